@@ -17,10 +17,21 @@
 #include <atres/Utility.h>
 #include <hltypes/harray.h>
 #include <hltypes/hmap.h>
+#include <hltypes/hmutex.h>
 #include <hltypes/hstring.h>
 
 #include "atresttfExport.h"
 
+typedef int FT_Error;
+typedef struct FT_LibraryRec_* FT_Library;
+typedef struct FT_FaceRec_* FT_Face;
+typedef struct FT_SizeRec_* FT_Size;
+typedef struct FT_GlyphRec_* FT_Glyph;
+typedef struct FT_StrokerRec_* FT_Stroker;
+typedef struct FTC_ManagerRec_* FTC_Manager;
+typedef struct FTC_CMapCacheRec_* FTC_CMapCache;
+typedef struct FTC_ImageCacheRec_* FTC_ImageCache;
+
 namespace april
 {
 	class Texture;
@@ -32,6 +43,29 @@ namespace atresttf
 	class atresttfExport FontTtf : public atres::FontDynamic
 	{
 	public:
+		/// @brief Gives exclusive access to the font's FreeType face for as long as the object exists.
+		/// @note FreeType faces must not be used by multiple threads at the same time. Different fonts can be used concurrently.
+		class atresttfExport FaceLock
+		{
+		public:
+			/// @brief Constructor.
+			/// @param[in] font The font whose face is locked.
+			FaceLock(FontTtf* font);
+			/// @brief Destructor.
+			~FaceLock();
+
+			/// @brief The locked FreeType face.
+			/// @note Is NULL if the font has not been loaded.
+			HL_DEFINE_GET(FT_Face, face, Face);
+
+		protected:
+			/// @brief The scope lock of the face mutex.
+			hmutex::ScopeLock lock;
+			/// @brief The locked FreeType face.
+			FT_Face face;
+
+		};
+
 		/// @brief Constructor.
 		/// @param[in] filename Filename of the font definition.
 		/// @param[in] loadBasicAscii Whether to pre-load the basic ASCII range of characters.
@@ -130,9 +164,24 @@ namespace atresttf
 
 		/// @brief Font filename.
 		HL_DEFINE_GET(hstr, fontFilename, FontFilename);
+		/// @brief Index of the face within the font file.
+		/// @note Only font collections (e.g. TTC files) contain more than one face. Has to be set before the font is loaded.
+		HL_DEFINE_GETSET(int, faceIndex, FaceIndex);
+		/// @brief Pixel height step to which the heights of size instances are quantized.
+		/// @note If 0, scaling is applied to the glyphs of this font and no size instances are created.
+		HL_DEFINE_GET(float, sizeQuantization, SizeQuantization);
+		/// @brief Sets the pixel height step to which the heights of size instances are quantized.
+		/// @param[in] value The height step.
+		/// @note Destroys all existing size instances and clears the renderer's cache so no text uses them anymore.
+		void setSizeQuantization(float value);
 		/// @brief Sets the border rendering mode.
 		/// @param[in] value The border rendering mode.
 		void setBorderMode(const BorderMode& value) override;
+		/// @brief Checks whether all textures of the font and its size instances are still uploaded.
+		/// @return True if no textures were lost.
+		bool checkTextures() override;
+		/// @brief Increases the texture generation of the font and its size instances.
+		void invalidateTextures() override;
 
 		/// @brief Gets kerning between two char codes.
 		/// @param[in] previousCharCode Character unicode value of the preceding character.
@@ -140,19 +189,63 @@ namespace atresttf
 		/// @return The kerning value.
 		float getKerning(unsigned int previousCharCode, unsigned int charCode) override;
 
+		/// @brief Gets the font instance that is used to render this font at a given scale.
+		/// @param[in] scale The scale.
+		/// @param[out] instanceScale The scale that has to be used with the returned font instance.
+		/// @return The font instance.
+		/// @note If size quantization is used, this returns a size instance with glyphs rendered at the quantized height which is created on demand.
+		Font* getScaledInstance(float scale, float& instanceScale) override;
+
 	protected:
 		/// @brief Whether to use a custom descender value that overrides the actual font's descender.
 		bool customDescender;
 		/// @brief Font filename.
 		hstr fontFilename;
 		/// @brief Font file data stream.
+		/// @note Only used when the font was created from a stream.
 		hstream fontStream;
+		/// @brief Font file data that is actually used.
+		/// @note Points either to fontStream or to font file data shared with other fonts.
+		hstream* fontData;
+		/// @brief Filename of the shared font file data that is used.
+		hstr fontDataFilename;
+		/// @brief Index of the face within the font file.
+		int faceIndex;
+		/// @brief FreeType face owned by this font.
+		/// @note The glyph cache manager uses this face as well.
+		FT_Face face;
+		/// @brief Size object of the face with the requested real dimension.
+		/// @note The glyph cache manager activates its own size object on the shared face so metrics are taken from this one.
+		FT_Size faceSize;
+		/// @brief Mutex that serializes access to the FreeType face.
+		hmutex faceMutex;
+		/// @brief FreeType cache manager that owns the glyph caches of this font.
+		FTC_Manager cacheManager;
+		/// @brief Cache for charmap lookups.
+		FTC_CMapCache cmapCache;
+		/// @brief Cache for outline and rendered glyph images.
+		FTC_ImageCache imageCache;
+		/// @brief Nominal character size in 26.6 fixed point used for cached glyph images.
+		/// @note Equivalent to the real-dimension size request that the face uses.
+		unsigned int cacheCharSize;
+		/// @brief Configured FreeType strokers, keyed by the border thickness in 26.6 fixed point.
+		/// @note Mostly used for internal optimization.
+		hmap<int, FT_Stroker> strokers;
 		/// @brief Whether to pre-load the basic ASCII range of characters.
 		bool loadBasicAscii;
+		/// @brief Pixel height step to which the heights of size instances are quantized.
+		float sizeQuantization;
+		/// @brief Size instances with their own glyphs and textures, keyed by their height in 26.6 fixed point.
+		hmap<int, FontTtf*> sizeInstances;
 		/// @brief Cache for calculated kerning values.
 		/// @note Mostly used for internal optimization.
 		hmap<std::pair<unsigned int, unsigned int>, float> kerningCache;
 
+		/// @brief Constructor for size instances.
+		/// @param[in] parent The font that owns the size instance.
+		/// @param[in] height Font height of the size instance.
+		FontTtf(FontTtf* parent, float height);
+
 		/// @brief Loads the font definition.
 		/// @param[in] fontFilename Font filename.
 		/// @param[in] name Font name.
@@ -167,6 +260,42 @@ namespace atresttf
 		/// @brief Loads the font definition.
 		/// @return True if successfully loaded.
 		bool _load() override;
+		/// @brief Creates and loads a size instance.
+		/// @param[in] height Font height of the size instance.
+		/// @return The size instance or NULL if it could not be loaded.
+		FontTtf* _createSizeInstance(float height);
+		/// @brief Releases the font file data.
+		void _releaseFontData();
+		/// @brief Creates the glyph cache manager and caches.
+		/// @param[in] face The face with the size already requested.
+		/// @return True if successfully created.
+		bool _createGlyphCache(FT_Face face);
+		/// @brief Destroys the glyph cache manager and caches.
+		void _destroyGlyphCache();
+		/// @brief Provides the already loaded face of the font to the glyph cache manager.
+		/// @param[in] faceId The face ID.
+		/// @param[in] library The FreeType library.
+		/// @param[in] requestData The font that requests the face.
+		/// @param[out] face The shared face.
+		/// @note The face is referenced so the cache manager can release it without destroying it.
+		/// @return FreeType error code.
+		static FT_Error _requestFace(void* faceId, FT_Library library, void* requestData, FT_Face* face);
+		/// @brief Finds the glyph index for a character using the charmap cache.
+		/// @param[in] charCode Character unicode value.
+		/// @return The glyph index or 0 if the font does not have the character.
+		/// @note The face mutex has to be locked when calling this.
+		unsigned int _getGlyphIndex(unsigned int charCode);
+		/// @brief Gets a glyph image from the glyph image cache.
+		/// @param[in] glyphIndex Glyph index.
+		/// @param[in] loadFlags FreeType load flags of the image type.
+		/// @return The cached glyph which must not be modified or NULL if it could not be loaded.
+		/// @note The face mutex has to be locked when calling this.
+		FT_Glyph _getCachedGlyph(unsigned int glyphIndex, int loadFlags);
+		/// @brief Gets a stroker configured for the given border thickness, creating it if necessary.
+		/// @param[in] borderThickness Thickness of the border.
+		/// @return The stroker or NULL if it could not be created.
+		/// @note The face mutex has to be locked when calling this.
+		FT_Stroker _getStroker(float borderThickness);
 		
 		/// @brief Loads an character image.
 		/// @param[in] charCode Character unicode value.
@@ -184,6 +313,17 @@ namespace atresttf
 		/// @param[in] borderThickness Thickness of the border.
 		/// @return The loaded image.
 		april::Image* _loadBorderCharacterImage(unsigned int charCode, float borderThickness) override;
+		/// @brief Loads border character images for multiple characters while locking the face and setting up the stroker only once.
+		/// @param[in] charCodes Character unicode values.
+		/// @param[in] borderThickness Thickness of the border.
+		/// @return The loaded images in the same order as the character codes, NULL for characters that could not be loaded.
+		harray<april::Image*> _loadBorderCharacterImages(const harray<unsigned int>& charCodes, float borderThickness) override;
+		/// @brief Renders a border character image with a configured stroker.
+		/// @param[in] charCode Character unicode value.
+		/// @param[in] stroker The stroker.
+		/// @return The rendered image.
+		/// @note The face mutex has to be locked when calling this.
+		april::Image* _renderBorderCharacterImage(unsigned int charCode, FT_Stroker stroker);
 
 	};
 
@@ -34,9 +34,21 @@ namespace atresttf
 	/// @param[in] name Font name.
 	/// @return The filename of the font.
 	atresttfFnExport hstr findSystemFontFilename(chstr name);
+	/// @brief Finds the face index of the font with the given font name within its font file.
+	/// @param[in] name Font name.
+	/// @return The face index of the font.
+	/// @note Only font collections (e.g. TTC files) contain more than one face.
+	atresttfFnExport int findSystemFontFaceIndex(chstr name);
 	/// @brief Gets the path where system fonts are installed.
 	/// @return The path where system fonts are installed.
 	atresttfFnExport hstr getSystemFontsPath();
+	/// @brief Gets the byte budget of the FreeType glyph cache of each font.
+	/// @return The byte budget.
+	atresttfFnExport int getGlyphCacheSize();
+	/// @brief Sets the byte budget of the FreeType glyph cache of each font.
+	/// @param[in] value The byte budget.
+	/// @note Only affects fonts that are loaded afterwards. Charmap lookups and glyph images are cached in this memory.
+	atresttfFnExport void setGlyphCacheSize(const int& value);
 
 }
 #endif
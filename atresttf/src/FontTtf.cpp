@@ -8,13 +8,18 @@
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
+#include FT_CACHE_H
+#include FT_GLYPH_H
+#include FT_SIZES_H
 #include FT_STROKER_H
 
 #include <april/RenderSystem.h>
 #include <april/Texture.h>
+#include <atres/Renderer.h>
 #include <hltypes/hfile.h>
 #include <hltypes/hlog.h>
 #include <hltypes/hltypesUtil.h>
+#include <hltypes/hmutex.h>
 #include <hltypes/hrdir.h>
 #include <hltypes/hresource.h>
 #include <hltypes/hstring.h>
@@ -32,9 +37,30 @@
 
 namespace atresttf
 {
+	static april::Image* _createBitmapImage(const FT_Bitmap& bitmap)
+	{
+		if (bitmap.width == (unsigned int)bitmap.pitch)
+		{
+			return april::Image::create(bitmap.width, bitmap.rows, bitmap.buffer, april::Image::Format::Alpha);
+		}
+		// making sure data is properly copied if "pitch" does not match "width"
+		april::Image* image = april::Image::create(bitmap.width, bitmap.rows, april::Color::White, april::Image::Format::Alpha);
+		image->write(0, 0, bitmap.width, bitmap.rows, 0, 0, bitmap.buffer, bitmap.pitch, bitmap.rows, april::Image::Format::Alpha);
+		return image;
+	}
+
 	FontTtf::FontTtf(chstr filename, bool loadBasicAscii) :
 		atres::FontDynamic(filename)
 	{
+		this->face = NULL;
+		this->faceSize = NULL;
+		this->cacheManager = NULL;
+		this->cmapCache = NULL;
+		this->imageCache = NULL;
+		this->cacheCharSize = 0;
+		this->sizeQuantization = 0.0f;
+		this->fontData = NULL;
+		this->faceIndex = 0;
 		this->customDescender = false;
 		this->loadBasicAscii = loadBasicAscii;
 		hstr path = hrdir::baseDir(filename);
@@ -53,6 +79,14 @@ namespace atresttf
 				{
 					this->textureSize = (int)line.replaced("TextureSize=", "");
 				}
+				else if (line.startsWith("SizeQuantization="))
+				{
+					this->sizeQuantization = (float)line.replaced("SizeQuantization=", "");
+				}
+				else if (line.startsWith("FaceIndex="))
+				{
+					this->faceIndex = (int)line.replaced("FaceIndex=", "");
+				}
 			}
 		}
 	}
@@ -60,6 +94,15 @@ namespace atresttf
 	FontTtf::FontTtf(chstr filename, float qualityScale, bool loadBasicAscii) :
 		atres::FontDynamic(filename)
 	{
+		this->face = NULL;
+		this->faceSize = NULL;
+		this->cacheManager = NULL;
+		this->cmapCache = NULL;
+		this->imageCache = NULL;
+		this->cacheCharSize = 0;
+		this->sizeQuantization = 0.0f;
+		this->fontData = NULL;
+		this->faceIndex = 0;
 		this->customDescender = false;
 		this->loadBasicAscii = loadBasicAscii;
 		hstr path = hrdir::baseDir(filename);
@@ -78,6 +121,14 @@ namespace atresttf
 				{
 					this->textureSize = (int)line.replaced("TextureSize=", "");
 				}
+				else if (line.startsWith("SizeQuantization="))
+				{
+					this->sizeQuantization = (float)line.replaced("SizeQuantization=", "");
+				}
+				else if (line.startsWith("FaceIndex="))
+				{
+					this->faceIndex = (int)line.replaced("FaceIndex=", "");
+				}
 			}
 		}
 	}
@@ -158,6 +209,31 @@ namespace atresttf
 		this->fontStream.writeRaw(stream);
 	}
 
+	FontTtf::FontTtf(FontTtf* parent, float height) :
+		atres::FontDynamic(parent->name)
+	{
+		float ratio = height / parent->height;
+		this->_setInternalValues(parent->fontFilename, parent->name, height, parent->baseScale, parent->lineHeight * ratio, false, parent->textureSize);
+		this->scale = 1.0f;
+		this->descender = parent->descender * ratio;
+		this->customDescender = parent->customDescender;
+		this->strikeThroughOffset = parent->strikeThroughOffset * ratio;
+		this->underlineOffset = parent->underlineOffset * ratio;
+		this->italicSkewRatio = parent->italicSkewRatio;
+		this->borderMode = parent->borderMode;
+		this->faceIndex = parent->faceIndex;
+		// the font data is shared with the parent
+		if (parent->fontDataFilename != "")
+		{
+			this->fontData = atresttf::acquireFontData(parent->fontDataFilename);
+			this->fontDataFilename = parent->fontDataFilename;
+		}
+		else
+		{
+			this->fontData = parent->fontData;
+		}
+	}
+
 	void FontTtf::_setInternalValues(chstr fontFilename, chstr name, float height, float scale, float lineHeight, bool loadBasicAscii, int textureSize)
 	{
 		this->fontFilename = fontFilename;
@@ -169,28 +245,155 @@ namespace atresttf
 		this->loadBasicAscii = loadBasicAscii;
 		this->textureSize = textureSize;
 		this->customDescender = false;
+		this->face = NULL;
+		this->faceSize = NULL;
+		this->cacheManager = NULL;
+		this->cmapCache = NULL;
+		this->imageCache = NULL;
+		this->cacheCharSize = 0;
+		this->sizeQuantization = 0.0f;
+		this->fontData = NULL;
+		this->faceIndex = 0;
 	}
 
 	FontTtf::~FontTtf()
 	{
+		foreach_map (int, FontTtf*, it, this->sizeInstances)
+		{
+			delete it->second;
+		}
+		this->sizeInstances.clear();
 		if (this->loaded)
 		{
+			hmutex::ScopeLock lock(&this->faceMutex);
+			foreach_map (int, FT_Stroker, it, this->strokers)
+			{
+				FT_Stroker_Done(it->second);
+			}
+			this->strokers.clear();
+			this->_destroyGlyphCache();
 			atresttf::destroyFace(this);
+			this->face = NULL;
+			this->faceSize = NULL;
+		}
+		this->_releaseFontData();
+	}
+
+	FontTtf::FaceLock::FaceLock(FontTtf* font) : lock(&font->faceMutex)
+	{
+		this->face = font->face;
+	}
+
+	FontTtf::FaceLock::~FaceLock()
+	{
+	}
+
+	void FontTtf::setSizeQuantization(float value)
+	{
+		if (this->sizeQuantization != value)
+		{
+			this->sizeQuantization = value;
+			foreach_map (int, FontTtf*, it, this->sizeInstances)
+			{
+				delete it->second;
+			}
+			this->sizeInstances.clear();
+			this->invalidateTextures();
+			// resolved fonts and cached text could still reference the destroyed size instances
+			if (atres::renderer != NULL)
+			{
+				atres::renderer->clearCache();
+			}
 		}
 	}
 
 	void FontTtf::setBorderMode(const BorderMode& value)
 	{
 		this->_setBorderMode(value);
+		foreach_map (int, FontTtf*, it, this->sizeInstances)
+		{
+			if (it->second != NULL)
+			{
+				it->second->setBorderMode(value);
+			}
+		}
+	}
+
+	bool FontTtf::checkTextures()
+	{
+		bool result = atres::FontDynamic::checkTextures();
+		foreach_map (int, FontTtf*, it, this->sizeInstances)
+		{
+			if (it->second != NULL && !it->second->checkTextures())
+			{
+				result = false;
+			}
+		}
+		return result;
+	}
+
+	void FontTtf::invalidateTextures()
+	{
+		atres::FontDynamic::invalidateTextures();
+		foreach_map (int, FontTtf*, it, this->sizeInstances)
+		{
+			if (it->second != NULL)
+			{
+				it->second->invalidateTextures();
+			}
+		}
+	}
+
+	atres::Font* FontTtf::getScaledInstance(float scale, float& instanceScale)
+	{
+		instanceScale = scale;
+		if (this->sizeQuantization <= 0.0f || !this->loaded)
+		{
+			return this;
+		}
+		float height = hmax(hroundf(this->height * scale / this->sizeQuantization), 1.0f) * this->sizeQuantization;
+		if (heqf(height, this->height, 0.01f))
+		{
+			return this;
+		}
+		int key = FLOAT2PTSIZE(height);
+		if (!this->sizeInstances.hasKey(key))
+		{
+			this->sizeInstances[key] = this->_createSizeInstance(height); // failed instances are kept as NULL so they are not attempted again
+		}
+		FontTtf* instance = this->sizeInstances[key];
+		if (instance == NULL)
+		{
+			return this;
+		}
+		// the instance is scaled so that its metrics match this font's metrics at the requested scale
+		instanceScale = this->height * scale / instance->height;
+		return instance;
+	}
+
+	FontTtf* FontTtf::_createSizeInstance(float height)
+	{
+		hlog::writef(logTag, "Creating size instance of font '%s' with height %g.", this->name.cStr(), height);
+		FontTtf* instance = new FontTtf(this, height);
+		if (!instance->load())
+		{
+			delete instance;
+			return NULL;
+		}
+		return instance;
 	}
 
 	bool FontTtf::_load()
 	{
-		if (this->fontStream.size() == 0)
+		if (this->fontData == NULL && this->fontStream.size() == 0)
 		{
 			if (this->fontFilename == "")
 			{
 				this->fontFilename = atresttf::findSystemFontFilename(this->name);
+				if (this->fontFilename != "")
+				{
+					this->faceIndex = atresttf::findSystemFontFaceIndex(this->name);
+				}
 			}
 			if (this->fontFilename == "") // no font file
 			{
@@ -207,35 +410,37 @@ namespace atresttf
 			this->lineHeight = this->height;
 		}
 		// libfreetype stuff
-		if (this->fontStream.size() == 0)
+		if (this->fontData == NULL)
 		{
-			this->fontStream.clear();
-			if (hresource::exists(this->fontFilename)) // prefer local fonts
+			if (this->fontStream.size() > 0)
 			{
-				hresource file;
-				file.open(this->fontFilename);
-				this->fontStream.writeRaw(file);
+				this->fontData = &this->fontStream;
 			}
 			else
 			{
-				hfile file;
-				file.open(this->fontFilename);
-				this->fontStream.writeRaw(file);
+				// font files are shared between all fonts that use them, e.g. multiple faces of a collection
+				this->fontData = atresttf::acquireFontData(this->fontFilename);
+				if (this->fontData == NULL)
+				{
+					hlog::error(logTag, "Could not read: " + this->fontFilename);
+					return false;
+				}
+				this->fontDataFilename = this->fontFilename;
 			}
 		}
 		FT_Library library = atresttf::getLibrary();
 		FT_Face face = NULL;
-		FT_Error error = FT_New_Memory_Face(library, (unsigned char*)this->fontStream, (FT_Long)this->fontStream.size(), 0, &face);
+		FT_Error error = FT_New_Memory_Face(library, (unsigned char*)(*this->fontData), (FT_Long)this->fontData->size(), this->faceIndex, &face);
 		if (error == FT_Err_Unknown_File_Format)
 		{
 			hlog::error(logTag, "Format not supported in: " + this->fontFilename);
-			this->fontStream.clear();
+			this->_releaseFontData();
 			return false;
 		}
 		if (error != 0)
 		{
-			hlog::error(logTag, "Could not read face 0 in: " + this->fontFilename + "; Error code: " + hstr(error));
-			this->fontStream.clear();
+			hlog::error(logTag, "Could not read face " + hstr(this->faceIndex) + " in: " + this->fontFilename + "; Error code: " + hstr(error));
+			this->_releaseFontData();
 			return false;
 		}
 		FT_Size_RequestRec request;
@@ -246,18 +451,33 @@ namespace atresttf
 		if (error != 0)
 		{
 			hlog::error(logTag, "Could not set font size in: " + this->fontFilename);
-			this->fontStream.clear();
+			this->_releaseFontData();
 			FT_Done_Face(face);
 			return false;
 		}
+		// the cache manager shares this face, but uses its own size object that matches the requested real dimension
+		this->face = face;
+		this->faceSize = face->size;
+		if (!this->_createGlyphCache(face))
+		{
+			hlog::error(logTag, "Could not create glyph cache for: " + this->fontFilename);
+			this->_releaseFontData();
+			FT_Done_Face(face);
+			this->face = NULL;
+			this->faceSize = NULL;
+			return false;
+		}
 		if (!atres::FontDynamic::_load())
 		{
 			hlog::error(logTag, "Could not load base class in: " + this->fontFilename);
-			this->fontStream.clear();
+			this->_destroyGlyphCache();
+			this->_releaseFontData();
 			FT_Done_Face(face);
+			this->face = NULL;
+			this->faceSize = NULL;
 			return false;
 		}
-		this->internalDescender = -PTSIZE2FLOAT(face->size->metrics.descender);
+		this->internalDescender = -PTSIZE2FLOAT(this->faceSize->metrics.descender);
 		if (!this->customDescender)
 		{
 			this->descender = this->internalDescender;
@@ -271,15 +491,116 @@ namespace atresttf
 		return true;
 	}
 
-	april::Image* FontTtf::_loadCharacterImage(unsigned int charCode, bool initial, float& advance, int& leftOffset, int& topOffset, float& ascender, float& descender, float& bearingX)
+	FT_Error FontTtf::_requestFace(FTC_FaceID, FT_Library, FT_Pointer requestData, FT_Face* face)
+	{
+		FontTtf* font = (FontTtf*)requestData;
+		if (font->face == NULL)
+		{
+			return FT_Err_Invalid_Face_Handle;
+		}
+		// the manager releases the face with FT_Done_Face() so it gets its own reference
+		FT_Error error = FT_Reference_Face(font->face);
+		if (error != 0)
+		{
+			return error;
+		}
+		*face = font->face;
+		return 0;
+	}
+
+	void FontTtf::_releaseFontData()
+	{
+		if (this->fontDataFilename != "")
+		{
+			atresttf::releaseFontData(this->fontDataFilename);
+			this->fontDataFilename = "";
+		}
+		else if (this->fontData == &this->fontStream)
+		{
+			this->fontStream.clear();
+		}
+		this->fontData = NULL;
+	}
+
+	bool FontTtf::_createGlyphCache(FT_Face face)
+	{
+		FT_Error error = FTC_Manager_New(atresttf::getLibrary(), 1, 1, (FT_ULong)atresttf::getGlyphCacheSize(), &FontTtf::_requestFace, this, &this->cacheManager);
+		if (error != 0)
+		{
+			this->cacheManager = NULL;
+			return false;
+		}
+		if (FTC_CMapCache_New(this->cacheManager, &this->cmapCache) != 0 || FTC_ImageCache_New(this->cacheManager, &this->imageCache) != 0)
+		{
+			this->_destroyGlyphCache();
+			return false;
+		}
+		// nominal size that results in the same scale as the real-dimension size request of the face
+		this->cacheCharSize = (unsigned int)FT_MulFix(face->units_per_EM, face->size->metrics.y_scale);
+		return true;
+	}
+
+	void FontTtf::_destroyGlyphCache()
+	{
+		if (this->cacheManager != NULL)
+		{
+			FTC_Manager_Done(this->cacheManager); // also destroys all caches
+			this->cacheManager = NULL;
+		}
+		this->cmapCache = NULL;
+		this->imageCache = NULL;
+	}
+
+	unsigned int FontTtf::_getGlyphIndex(unsigned int charCode)
 	{
-		FT_Face face = atresttf::getFace(this);
 		unsigned long charIndex = charCode;
 		if (charIndex == UNICODE_CHAR_NON_BREAKING_SPACE) // non-breaking space character should be treated just like a normal space when retrieving the glyph from the font
 		{
 			charIndex = UNICODE_CHAR_SPACE;
 		}
-		unsigned int glyphIndex = FT_Get_Char_Index(face, charIndex);
+		return FTC_CMapCache_Lookup(this->cmapCache, (FTC_FaceID)this, -1, (FT_UInt32)charIndex);
+	}
+
+	FT_Glyph FontTtf::_getCachedGlyph(unsigned int glyphIndex, int loadFlags)
+	{
+		FTC_ScalerRec scaler;
+		scaler.face_id = (FTC_FaceID)this;
+		scaler.width = this->cacheCharSize;
+		scaler.height = this->cacheCharSize;
+		scaler.pixel = 0;
+		scaler.x_res = 72;
+		scaler.y_res = 72;
+		FT_Glyph glyph = NULL;
+		if (FTC_ImageCache_LookupScaler(this->imageCache, &scaler, (FT_ULong)loadFlags, glyphIndex, &glyph, NULL) != 0)
+		{
+			return NULL;
+		}
+		return glyph;
+	}
+
+	FT_Stroker FontTtf::_getStroker(float borderThickness)
+	{
+		int thickness = FLOAT2PTSIZE(borderThickness);
+		FT_Stroker stroker = this->strokers.tryGet(thickness, NULL);
+		if (stroker != NULL)
+		{
+			return stroker;
+		}
+		FT_Error error = FT_Stroker_New(atresttf::getLibrary(), &stroker);
+		if (error != 0)
+		{
+			hlog::error(logTag, "Could not create stroker: " + this->fontFilename);
+			return NULL;
+		}
+		FT_Stroker_Set(stroker, thickness, FT_STROKER_LINECAP_ROUND, FT_STROKER_LINEJOIN_MITER_FIXED, 1 << 16);
+		this->strokers[thickness] = stroker;
+		return stroker;
+	}
+
+	april::Image* FontTtf::_loadCharacterImage(unsigned int charCode, bool initial, float& advance, int& leftOffset, int& topOffset, float& ascender, float& descender, float& bearingX)
+	{
+		hmutex::ScopeLock lock(&this->faceMutex);
+		unsigned int glyphIndex = this->_getGlyphIndex(charCode);
 		if (glyphIndex == 0)
 		{
 			if (!initial && charCode >= UNICODE_CHAR_SPACE)
@@ -288,39 +609,67 @@ namespace atresttf
 			}
 			return NULL;
 		}
-		FT_Error error = FT_Load_Glyph(face, glyphIndex, FT_LOAD_DEFAULT);
-		if (error != 0)
+		FT_Glyph glyph = this->_getCachedGlyph(glyphIndex, FT_LOAD_DEFAULT);
+		if (glyph == NULL)
 		{
 			hlog::error(logTag, "Could not load glyph from: " + this->fontFilename);
 			return NULL;
 		}
-		if (face->glyph->format != FT_GLYPH_FORMAT_BITMAP)
+		// the grid-fitted control box of the hinted outline corresponds to the glyph metrics' horizontal bearing
+		bool outlineBearing = (glyph->format == FT_GLYPH_FORMAT_OUTLINE);
+		FT_BBox box;
+		if (outlineBearing)
 		{
-			error = FT_Render_Glyph(face->glyph, FT_RENDER_MODE_LIGHT);
-			if (error != 0)
-			{
-				hlog::error(logTag, "Could not render glyph from: " + this->fontFilename);
-				return NULL;
-			}
+			FT_Glyph_Get_CBox(glyph, FT_GLYPH_BBOX_GRIDFIT, &box);
+		}
+		glyph = this->_getCachedGlyph(glyphIndex, FT_LOAD_DEFAULT | FT_LOAD_RENDER);
+		if (glyph == NULL)
+		{
+			hlog::error(logTag, "Could not load glyph from: " + this->fontFilename);
+			return NULL;
 		}
-		advance = PTSIZE2FLOAT(face->glyph->advance.x);
-		leftOffset = face->glyph->bitmap_left;
-		topOffset = face->glyph->bitmap_top;
-		ascender = -PTSIZE2FLOAT(face->size->metrics.ascender);
-		descender = -PTSIZE2FLOAT(face->size->metrics.descender);
-		bearingX = PTSIZE2FLOAT(face->glyph->metrics.horiBearingX);
-		return april::Image::create(face->glyph->bitmap.width, face->glyph->bitmap.rows, face->glyph->bitmap.buffer, april::Image::Format::Alpha);
+		if (glyph->format != FT_GLYPH_FORMAT_BITMAP)
+		{
+			hlog::error(logTag, "Could not render glyph from: " + this->fontFilename);
+			return NULL;
+		}
+		FT_BitmapGlyph bitmapGlyph = (FT_BitmapGlyph)glyph;
+		advance = glyph->advance.x / 65536.0f; // glyph advance is in 16.16 format
+		leftOffset = bitmapGlyph->left;
+		topOffset = bitmapGlyph->top;
+		ascender = -PTSIZE2FLOAT(this->faceSize->metrics.ascender);
+		descender = -PTSIZE2FLOAT(this->faceSize->metrics.descender);
+		bearingX = (outlineBearing ? PTSIZE2FLOAT(box.xMin) : (float)bitmapGlyph->left); // bitmap fonts do not have an outline
+		return _createBitmapImage(bitmapGlyph->bitmap);
 	}
 
 	april::Image* FontTtf::_loadBorderCharacterImage(unsigned int charCode, float borderThickness)
 	{
-		FT_Face face = atresttf::getFace(this);
-		unsigned long charIndex = charCode;
-		if (charIndex == UNICODE_CHAR_NON_BREAKING_SPACE) // non-breaking space character should be treated just like a normal space when retrieving the glyph from the font
+		hmutex::ScopeLock lock(&this->faceMutex);
+		FT_Stroker stroker = this->_getStroker(borderThickness);
+		if (stroker == NULL)
 		{
-			charIndex = UNICODE_CHAR_SPACE;
+			return NULL;
+		}
+		return this->_renderBorderCharacterImage(charCode, stroker);
+	}
+
+	harray<april::Image*> FontTtf::_loadBorderCharacterImages(const harray<unsigned int>& charCodes, float borderThickness)
+	{
+		harray<april::Image*> result;
+		// the face is locked and the stroker is set up only once for all characters
+		hmutex::ScopeLock lock(&this->faceMutex);
+		FT_Stroker stroker = this->_getStroker(borderThickness);
+		foreachc (unsigned int, it, charCodes)
+		{
+			result += (stroker != NULL ? this->_renderBorderCharacterImage((*it), stroker) : NULL);
 		}
-		unsigned int glyphIndex = FT_Get_Char_Index(face, charIndex);
+		return result;
+	}
+
+	april::Image* FontTtf::_renderBorderCharacterImage(unsigned int charCode, FT_Stroker stroker)
+	{
+		unsigned int glyphIndex = this->_getGlyphIndex(charCode);
 		if (glyphIndex == 0)
 		{
 			if (charCode >= UNICODE_CHAR_SPACE)
@@ -329,35 +678,26 @@ namespace atresttf
 			}
 			return NULL;
 		}
-		FT_Error error = FT_Load_Glyph(face, glyphIndex, FT_LOAD_DEFAULT);
-		if (error != 0)
+		FT_Glyph cachedGlyph = this->_getCachedGlyph(glyphIndex, FT_LOAD_DEFAULT);
+		if (cachedGlyph == NULL)
 		{
 			hlog::error(logTag, "Could not load glyph from: " + this->fontFilename);
 			return NULL;
 		}
-		if (face->glyph->format != FT_GLYPH_FORMAT_OUTLINE) // native border actually not supported in this font
+		if (cachedGlyph->format != FT_GLYPH_FORMAT_OUTLINE) // native border actually not supported in this font
 		{
 			hlog::error(logTag, "Not an outline glyph: " + this->fontFilename);
 			return NULL;
 		}
-		FT_Stroker stroker;
-		error = FT_Stroker_New(atresttf::getLibrary(), &stroker);
-		if (error != 0)
-		{
-			hlog::error(logTag, "Could not create stroker: " + this->fontFilename);
-			return NULL;
-		}
-		FT_Stroker_Set(stroker, FLOAT2PTSIZE(borderThickness), FT_STROKER_LINECAP_ROUND, FT_STROKER_LINEJOIN_MITER_FIXED, 1 << 16);
+		// cached glyphs are owned by the cache so a copy is stroked
 		FT_Glyph glyph;
-		error = FT_Get_Glyph(face->glyph, &glyph);
+		FT_Error error = FT_Glyph_Copy(cachedGlyph, &glyph);
 		if (error != 0)
 		{
 			hlog::error(logTag, "Could not get glyph from: " + this->fontFilename);
-			FT_Stroker_Done(stroker);
 			return NULL;
 		}
 		error = FT_Glyph_StrokeBorder(&glyph, stroker, false, true);
-		FT_Stroker_Done(stroker);
 		if (error != 0)
 		{
 			hlog::error(logTag, "Could not stroke: " + this->fontFilename);
@@ -371,18 +711,7 @@ namespace atresttf
 			FT_Done_Glyph(glyph);
 			return NULL;
 		}
-		FT_Bitmap bitmap = ((FT_BitmapGlyph)glyph)->bitmap;
-		april::Image* image = NULL;
-		if (bitmap.width == (unsigned int)bitmap.pitch)
-		{
-			image = april::Image::create(bitmap.width, bitmap.rows, bitmap.buffer, april::Image::Format::Alpha);
-		}
-		else
-		{
-			// making sure data is properly copied if "pitch" does not match "width"
-			image = april::Image::create(bitmap.width, bitmap.rows, april::Color::White, april::Image::Format::Alpha);
-			image->write(0, 0, bitmap.width, bitmap.rows, 0, 0, bitmap.buffer, bitmap.pitch, bitmap.rows, april::Image::Format::Alpha);
-		}
+		april::Image* image = _createBitmapImage(((FT_BitmapGlyph)glyph)->bitmap);
 		FT_Done_Glyph(glyph);
 		return image;
 	}
@@ -393,38 +722,31 @@ namespace atresttf
 		{
 			return 0.0f;
 		}
-		FT_Face face = atresttf::getFace(this);
+		hmutex::ScopeLock lock(&this->faceMutex);
+		FT_Face face = this->face;
 		if (!FT_HAS_KERNING(face))
 		{
 			return 0.0f;
 		}
-		std::pair<unsigned int, unsigned int> key;
+		std::pair<unsigned int, unsigned int> key(previousCharCode, charCode);
 		if (this->kerningCache.hasKey(key))
 		{
 			return this->kerningCache[key];
 		}
-		unsigned long charIndex = charCode;
-		if (charIndex == UNICODE_CHAR_NON_BREAKING_SPACE) // non-breaking space character should be treated just like a normal space when retrieving the glyph from the font
-		{
-			charIndex = UNICODE_CHAR_SPACE;
-		}
-		unsigned int glyphIndex = FT_Get_Char_Index(face, charIndex);
+		unsigned int glyphIndex = this->_getGlyphIndex(charCode);
 		if (glyphIndex == 0)
 		{
 			this->kerningCache[key] = 0.0f;
 			return this->kerningCache[key];
 		}
-		unsigned long previousCharInex = previousCharCode;
-		if (previousCharInex == UNICODE_CHAR_NON_BREAKING_SPACE) // non-breaking space character should be treated just like a normal space when retrieving the glyph from the font
-		{
-			previousCharInex = UNICODE_CHAR_SPACE;
-		}
-		unsigned int previousGlyphIndex = FT_Get_Char_Index(face, previousCharInex);
+		unsigned int previousGlyphIndex = this->_getGlyphIndex(previousCharCode);
 		if (previousGlyphIndex == 0)
 		{
 			this->kerningCache[key] = 0.0f;
 			return this->kerningCache[key];
 		}
+		// kerning is scaled with the active size which could be the one of the glyph cache manager
+		FT_Activate_Size(this->faceSize);
 		FT_Vector kerningVector;
 		FT_Error error = FT_Get_Kerning(face, previousGlyphIndex, glyphIndex, FT_KERNING_DEFAULT, &kerningVector);
 		if (error != 0)
@@ -19,9 +19,13 @@
 #include <hltypes/harray.h>
 #include <hltypes/hdir.h>
 #include <hltypes/hexception.h>
+#include <hltypes/hfile.h>
 #include <hltypes/hlog.h>
 #include <hltypes/hmap.h>
+#include <hltypes/hmutex.h>
 #include <hltypes/hplatform.h>
+#include <hltypes/hresource.h>
+#include <hltypes/hstream.h>
 #include <hltypes/hstring.h>
 #include <hltypes/hversion.h>
 
@@ -36,8 +40,14 @@ namespace atresttf
 
 	FT_Library library = NULL;
 	hmap<atres::Font*, FT_Face> faces;
+	static hmutex facesMutex;
 	static hmap<hstr, hstr> fonts;
+	static hmap<hstr, int> fontFaceIndices;
+	static hmap<hstr, hstream*> fontData;
+	static hmap<hstr, int> fontDataReferences;
+	static hmutex fontDataMutex;
 	static bool fontNamesChecked = false;
+	static int glyphCacheSize = 1048576;
 
 	void init()
 	{
@@ -52,11 +62,13 @@ namespace atresttf
 	void destroy()
 	{
 		hlog::write(logTag, "Destroying AtresTTF");
+		hmutex::ScopeLock lock(&facesMutex);
 		foreach_map (atres::Font*, FT_Face, it, faces)
 		{
 			FT_Done_Face(it->second);
 		}
 		faces.clear();
+		lock.release();
 		FT_Error error = FT_Done_FreeType(library);
 		if (error == 0)
 		{
@@ -83,6 +95,7 @@ namespace atresttf
 				int slash = 0;
 				hstr name;
 				hstr data;
+				harray<hstr> names;
 				hstr systemPath = atresttf::getSystemFontsPath();
 				while (RegEnumValueW(hKey, index, wName, &wSize, NULL, NULL, (BYTE*)wData, &wSize) == ERROR_SUCCESS)
 				{
@@ -96,7 +109,13 @@ namespace atresttf
 							name = name(0, slash).trimmedRight();
 						}
 					}
-					fonts[name] = hdir::joinPath(systemPath, data);
+					// collections list the names of all faces in order
+					names = name.split(" & ", -1, true);
+					for_iter (i, 0, names.size())
+					{
+						fonts[names[i]] = hdir::joinPath(systemPath, data);
+						fontFaceIndices[names[i]] = i;
+					}
 					memset(wName, 0, sizeof(wName));
 					memset(wData, 0, sizeof(wData));
 					wSize = sizeof(wName) - 1;
@@ -115,11 +134,19 @@ namespace atresttf
 			FT_Error error;
 			hstr fontName;
 			hstr styleName;
+			int faceCount = 0;
 			foreach (hstr, it, fontFiles)
 			{
-				error = FT_New_Face(library, (*it).cStr(), 0, &face);
-				if (error == 0)
+				faceCount = 1;
+				// collections contain multiple faces
+				for_iter (i, 0, faceCount)
 				{
+					error = FT_New_Face(library, (*it).cStr(), i, &face);
+					if (error != 0)
+					{
+						break;
+					}
+					faceCount = (int)face->num_faces;
 					fontName = hstr((char*)face->family_name);
 					styleName = hstr((char*)face->style_name);
 					FT_Done_Face(face);
@@ -128,6 +155,7 @@ namespace atresttf
 						fontName += " " + styleName;
 					}
 					fonts[fontName] = (*it);
+					fontFaceIndices[fontName] = i;
 				}
 			}
 #endif
@@ -145,6 +173,15 @@ namespace atresttf
 		return fonts.tryGet(name, "");
 	}
 
+	int findSystemFontFaceIndex(chstr name)
+	{
+		if (!fontNamesChecked)
+		{
+			getSystemFonts();
+		}
+		return fontFaceIndices.tryGet(name, 0);
+	}
+
 	hstr getSystemFontsPath()
 	{
 #ifdef _WIN32
@@ -168,6 +205,16 @@ namespace atresttf
 #endif
 	}
 
+	int getGlyphCacheSize()
+	{
+		return glyphCacheSize;
+	}
+
+	void setGlyphCacheSize(const int& value)
+	{
+		glyphCacheSize = value;
+	}
+
 	FT_Library getLibrary()
 	{
 		if (library == NULL)
@@ -177,13 +224,58 @@ namespace atresttf
 		return library;
 	}
 
-	FT_Face getFace(atres::Font* font)
+	hstream* acquireFontData(chstr filename)
 	{
-		return faces[font];
+		hmutex::ScopeLock lock(&fontDataMutex);
+		hstream* stream = fontData.tryGet(filename, NULL);
+		if (stream != NULL)
+		{
+			++fontDataReferences[filename];
+			return stream;
+		}
+		stream = new hstream();
+		if (hresource::exists(filename)) // prefer local fonts
+		{
+			hresource file;
+			file.open(filename);
+			stream->writeRaw(file);
+		}
+		else if (hfile::exists(filename))
+		{
+			hfile file;
+			file.open(filename);
+			stream->writeRaw(file);
+		}
+		if (stream->size() == 0)
+		{
+			delete stream;
+			return NULL;
+		}
+		fontData[filename] = stream;
+		fontDataReferences[filename] = 1;
+		return stream;
+	}
+
+	void releaseFontData(chstr filename)
+	{
+		hmutex::ScopeLock lock(&fontDataMutex);
+		if (!fontDataReferences.hasKey(filename))
+		{
+			hlog::warn(logTag, "No font data loaded for: " + filename);
+			return;
+		}
+		--fontDataReferences[filename];
+		if (fontDataReferences[filename] <= 0)
+		{
+			delete fontData[filename];
+			fontData.removeKey(filename);
+			fontDataReferences.removeKey(filename);
+		}
 	}
 
 	void registerFace(atres::Font* font, FT_Face face)
 	{
+		hmutex::ScopeLock lock(&facesMutex);
 		if (faces.hasKey(font))
 		{
 			hlog::error(logTag, "Cannot add Face for Font Resource: " + font->getName());
@@ -194,6 +286,7 @@ namespace atresttf
 
 	void destroyFace(atres::Font* font)
 	{
+		hmutex::ScopeLock lock(&facesMutex);
 		if (!faces.hasKey(font))
 		{
 			hlog::warn(logTag, "No Face registered for Font: " + font->getName());
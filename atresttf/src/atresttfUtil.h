@@ -17,6 +17,8 @@
 #include FT_FREETYPE_H
 
 #include <hltypes/hmap.h>
+#include <hltypes/hstream.h>
+#include <hltypes/hstring.h>
 
 namespace atres
 {
@@ -26,9 +28,10 @@ namespace atres
 namespace atresttf
 {
 	FT_Library getLibrary();
-	FT_Face getFace(atres::Font* font);
 	void registerFace(atres::Font* font, FT_Face face);
 	void destroyFace(atres::Font* font);
+	hstream* acquireFontData(chstr filename);
+	void releaseFontData(chstr filename);
 
 	extern FT_Library library;
 	extern hmap<atres::Font*, FT_Face> faces;
@@ -64,9 +64,17 @@ namespace atres
 		/// @brief Gets the calculated height of the font.
 		/// @return The calculated height of the font.
 		float getHeight() const;
+		/// @brief Gets the calculated height of the font at a given scale.
+		/// @param[in] scale The scale.
+		/// @return The calculated height of the font.
+		float getHeight(float scale) const;
 		/// @brief Gets the scale of the font.
 		/// @return The scale of the font.
 		float getScale() const;
+		/// @brief Gets the total scale of the font at a given scale.
+		/// @param[in] scale The scale.
+		/// @return The total scale of the font.
+		float getScale(float scale) const;
 		/// @brief Set the scale of the font.
 		HL_DEFINE_SET(float, scale, Scale);
 		/// @brief Internal base scale of the font.
@@ -74,18 +82,38 @@ namespace atres
 		/// @brief Gets the line-height of the font.
 		/// @return The line-height of the font.
 		float getLineHeight() const;
+		/// @brief Gets the line-height of the font at a given scale.
+		/// @param[in] scale The scale.
+		/// @return The line-height of the font.
+		float getLineHeight(float scale) const;
 		/// @brief Gets the descender of the font.
 		/// @return The descender of the font.
 		float getDescender() const;
+		/// @brief Gets the descender of the font at a given scale.
+		/// @param[in] scale The scale.
+		/// @return The descender of the font.
+		float getDescender(float scale) const;
 		/// @brief Gets the internal descender of the font.
 		/// @return The internal descender of the font.
 		float getInternalDescender() const;
+		/// @brief Gets the internal descender of the font at a given scale.
+		/// @param[in] scale The scale.
+		/// @return The internal descender of the font.
+		float getInternalDescender(float scale) const;
 		/// @brief Gets the vertical strike-through offset of the font.
 		/// @return The vertical strike-through offset of the font.
 		float getStrikeThroughOffset() const;
+		/// @brief Gets the vertical strike-through offset of the font at a given scale.
+		/// @param[in] scale The scale.
+		/// @return The vertical strike-through offset of the font.
+		float getStrikeThroughOffset(float scale) const;
 		/// @brief Gets the vertical underline offset of the font.
 		/// @return The vertical underline offset of the font.
 		float getUnderlineOffset() const;
+		/// @brief Gets the vertical underline offset of the font at a given scale.
+		/// @param[in] scale The scale.
+		/// @return The vertical underline offset of the font.
+		float getUnderlineOffset(float scale) const;
 		/// @brief The height ratio of skewing for italic rendering of the font.
 		HL_DEFINE_GET(float, italicSkewRatio, ItalicSkewRatio);
 		/// @brief Gets the border rendering mode.
@@ -110,6 +138,13 @@ namespace atres
 		/// @brief Gets all internal textures.
 		/// @return All internal textures.
 		harray<april::Texture*> getTextures() const;
+		/// @brief Incremented every time the textures of this font are lost or invalidated.
+		HL_DEFINE_GET(unsigned int, textureGeneration, TextureGeneration);
+		/// @brief Checks whether all textures of the font are still uploaded and increases the texture generation if they are not.
+		/// @return True if no textures were lost.
+		virtual bool checkTextures();
+		/// @brief Increases the texture generation so that all text using this font's textures is recreated.
+		virtual void invalidateTextures();
 
 		/// @brief Get the texture where the character definition for a specific char code is currently contained.
 		/// @param[in] charCode Character unicode value.
@@ -191,6 +226,13 @@ namespace atres
 		/// @return The RenderRectangle definition.
 		RenderRectangle makeBorderRenderRectangle(cgrectf rect, cgrectf area, chstr iconName, float borderThickness);
 
+		/// @brief Gets the font instance that is used to render this font at a given scale.
+		/// @param[in] scale The scale.
+		/// @param[out] instanceScale The scale that has to be used with the returned font instance.
+		/// @return The font instance.
+		/// @note The default implementation returns this font with the same scale. The font itself is not modified.
+		virtual Font* getScaledInstance(float scale, float& instanceScale);
+
 		/// @brief Loads basic ASCII range of characters.
 		/// @param[in] iconName Icon name.
 		/// @return True if icon is loaded.
@@ -198,6 +240,11 @@ namespace atres
 		/// @brief Loads basic ASCII range of border characters.
 		/// @param[in] borderThickness Thickness of the border.
 		virtual void loadBasicAsciiBorderCharacters(float borderThickness);
+		/// @brief Loads all border characters of a text that have not been loaded yet in one pass.
+		/// @param[in] text The text with the characters.
+		/// @param[in] borderThickness Thickness of the border.
+		/// @note Formatting tags are not parsed so unformatted text should be used.
+		virtual void loadBorderCharacters(chstr text, float borderThickness);
 
 		/// @brief The default border rendering mode for all fonts.
 		static BorderMode defaultBorderMode;
@@ -227,6 +274,8 @@ namespace atres
 		bool loaded;
 		/// @brief Font border rendering mode.
 		BorderMode borderMode;
+		/// @brief Texture generation of the font.
+		unsigned int textureGeneration;
 		/// @brief All character definitions.
 		hmap<unsigned int, CharacterDefinition*> characters;
 		/// @brief All border character definitions.
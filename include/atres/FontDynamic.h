@@ -90,6 +90,11 @@ namespace atres
 		/// @brief Loads basic ASCII range of border characters.
 		/// @param[in] borderThickness Thickness of the border.
 		void loadBasicAsciiBorderCharacters(float borderThickness) override;
+		/// @brief Loads all border characters of a text that have not been loaded yet in one pass.
+		/// @param[in] text The text with the characters.
+		/// @param[in] borderThickness Thickness of the border.
+		/// @note Formatting tags are not parsed so unformatted text should be used.
+		void loadBorderCharacters(chstr text, float borderThickness) override;
 
 	protected:
 		/// @brief Helper class for structuring images when using a prerendered border rendering mode.
@@ -147,6 +152,11 @@ namespace atres
 		/// @return True if successful.
 		/// @note Usually false is returned when the border character couldn't be or created loaded properly from the font definition.
 		bool _tryAddBorderCharacterBitmap(unsigned int charCode, float borderThickness);
+		/// @brief Adds a loaded border character bitmap to the texture.
+		/// @param[in] charCode Character unicode value.
+		/// @param[in] borderThickness Thickness of the border.
+		/// @param[in] image The border character image which is destroyed afterwards.
+		void _addBorderCharacterBitmap(unsigned int charCode, float borderThickness, april::Image* image);
 		/// @brief Attempts to add the icon bitmap to the texture.
 		/// @param[in] iconName Icon name.
 		/// @param[in] initial Whether this is the first attempt to write on the texture (used for internal optimization).
@@ -189,6 +199,12 @@ namespace atres
 		/// @param[in] borderThickness Thickness of the border.
 		/// @return The loaded image.
 		virtual april::Image* _loadBorderCharacterImage(unsigned int charCode, float borderThickness);
+		/// @brief Loads border character images for multiple characters at once.
+		/// @param[in] charCodes Character unicode values.
+		/// @param[in] borderThickness Thickness of the border.
+		/// @return The loaded images in the same order as the character codes, NULL for characters that could not be loaded.
+		/// @note Fonts can override this to prepare the glyph rendering only once for all characters.
+		virtual harray<april::Image*> _loadBorderCharacterImages(const harray<unsigned int>& charCodes, float borderThickness);
 		/// @brief Generates a border character image.
 		/// @param[in] charCode Character unicode value.
 		/// @param[in] borderThickness Thickness of the border.
@@ -19,6 +19,7 @@
 #include <hltypes/harray.h>
 #include <hltypes/hltypesUtil.h>
 #include <hltypes/hmap.h>
+#include <hltypes/hmutex.h>
 #include <hltypes/hstring.h>
 
 #include "atresExport.h"
@@ -28,9 +29,119 @@ namespace atres
 {
 	class Font;
 	class FontIconMap;
+	class LayoutWorker;
 	template <typename T>
 	class Cache;
 
+	/// @brief Holds the intermediate state of text layout and render data creation.
+	/// @note Each thread that creates render lines or render text concurrently needs its own context. Characters should be
+	/// preloaded with Renderer::analyzeText() beforehand, because fonts load missing characters into their textures. The same
+	/// applies to border characters which are loaded with Font::loadBorderCharacters().
+	/// @note Only Renderer::createRenderWords(), Renderer::createRenderLines() and Renderer::createRenderText() with an explicit
+	/// context may be called off the main thread. All other methods use the renderer's caches which are not guarded.
+	class atresExport LayoutContext
+	{
+	public:
+		friend class Renderer;
+
+		LayoutContext();
+
+		/// @brief Per-character layout data of the words created last with this context.
+		inline const GlyphRun& getGlyphRun() const { return this->_glyphRun; }
+
+	private:
+		harray<FormatTag> _tags;
+		harray<FormatTag> _stack;
+		FormatTag _currentTag;
+		FormatTag _nextTag;
+
+		hstr _fontName;
+		Font* _font;
+		ResolvedFont _resolvedFont;
+		FontIconMap* _iconFont;
+		hstr _fontIconName;
+		hmap<unsigned int, CharacterDefinition*>& _characters;
+		hmap<unsigned int, CharacterDefinition*> _dummyCharacters; // required for some compilers
+		CharacterDefinition* _asciiCharacters[128];
+		hmap<hstr, IconDefinition*>& _icons;
+		hmap<hstr, IconDefinition*> _dummyIcons; // required for some compilers
+		CharacterDefinition* _character;
+		BorderCharacterDefinition* _borderCharacter;
+		IconDefinition* _icon;
+		BorderIconDefinition* _borderIcon;
+		float _height;
+		float _lineHeight;
+		float _descender;
+		float _internalDescender;
+		float _strikeThroughOffset;
+		float _underlineOffset;
+		float _italicSkewRatio;
+		float _fontScale;
+		float _fontBaseScale;
+		float _iconFontScale;
+		float _iconFontBearingX;
+		float _iconFontOffsetY;
+		hmap<hstr, float> _iconFontCustomFontOffsets;
+		float _textScale;
+		float _scale;
+		gvec2f _shadowOffset;
+		gvec2f _textShadowOffset;
+		float _borderThickness;
+		float _borderFontThickness;
+		float _textBorderThickness;
+
+		harray<RenderSequence> _textSequences;
+		RenderSequence _textSequence;
+		harray<RenderSequence> _shadowSequences;
+		RenderSequence _shadowSequence;
+		harray<RenderSequence> _borderSequences;
+		RenderSequence _borderSequence;
+		RenderRectangle _renderRect;
+		harray<Font*> _renderFonts;
+		grectf _liningRect;
+		harray<RenderLiningSequence> _textLiningSequences;
+		RenderLiningSequence _textStrikeThroughSequence;
+		RenderLiningSequence _textUnderlineSequence;
+		harray<RenderLiningSequence> _shadowLiningSequences;
+		RenderLiningSequence _shadowStrikeThroughSequence;
+		RenderLiningSequence _shadowUnderlineSequence;
+		harray<RenderLiningSequence> _borderLiningSequences;
+		RenderLiningSequence _borderStrikeThroughSequence;
+		RenderLiningSequence _borderUnderlineSequence;
+
+		april::Color _textColor;
+		april::Color _shadowColor;
+		april::Color _borderColor;
+		april::Color _strikeThroughColor;
+		april::Color _underlineColor;
+		hstr _hex;
+		hstr _parameterString0;
+		hstr _parameterString1;
+		int _effectMode;
+		bool _strikeThroughActive;
+		float _strikeThroughThickness;
+		float _textStrikeThroughThickness;
+		bool _underlineActive;
+		float _underlineThickness;
+		float _textUnderlineThickness;
+		bool _italicActive;
+		bool _hideActive;
+		int _alpha;
+
+		harray<RenderLine> _lines;
+		RenderLine _line;
+		RenderWord _word;
+		GlyphRun _glyphRun;
+		const RenderLine* _renderLine;
+		const RenderWord* _renderWord;
+
+		april::Texture* _texture;
+		unsigned int _code;
+		hstr _iconName;
+		int _glyphIndex;
+
+	};
+
 	class atresExport Renderer
 	{
 	public:
@@ -50,19 +161,28 @@ namespace atres
 		HL_DEFINE_GET(float, underlineThickness, UnderlineThickness);
 		void setUnderlineThickness(float value);
 		HL_DEFINE_ISSET(globalOffsets, GlobalOffsets);
-		/// @brief Option to use old, non-smart line-break parsing for ideographs.
+		/// @brief Option to use old, non-smart line-break parsing that breaks after every punctuation character.
+		/// @note When turned off, break opportunities within words are determined by Unicode line-break classes (UAX #14).
 		HL_DEFINE_IS(useLegacyLineBreakParsing, UseLegacyLineBreakParsing);
 		void setUseLegacyLineBreakParsing(bool value);
 		/// @brief When turned on, this regards ideographs as words when segmenting text into lines.
+		/// @note Line-break rules for CJK punctuation are still respected (e.g. no line starts with a closing bracket or small kana).
 		/// @note This is particularly useful when having Japanese or Chinese text. Korean text has actual spaces so this is not necessary, but still useful.
 		HL_DEFINE_IS(useIdeographWords, UseIdeographWords);
 		void setUseIdeographWords(bool value);
+		/// @brief When turned on, words are measured once per unscaled font and reused for all scaled variants of that font (e.g. "Arial:0.8").
+		/// @note Only applies to fonts whose scaled variants share their metrics and to texts without font changes, other texts are measured as usual.
+		/// @note This is particularly useful for zoom animations and UI scaling where the font scale changes often.
+		HL_DEFINE_IS(scaleInvariantLayout, ScaleInvariantLayout);
+		void setScaleInvariantLayout(bool value);
 		/// @brief Allows to turn justified text into another formatting. This is to counter languages with problematic characters.
 		HL_DEFINE_GET(Horizontal, justifiedDefault, JustifiedDefault);
 		void setJustifiedDefault(Horizontal value);
 		hstr getDefaultFontName() const;
 		void setDefaultFontName(chstr value);
 		void setCacheSize(int value);
+		/// @brief Incremented every time the cache is cleared so retained text objects know when to rebuild.
+		HL_DEFINE_GET(unsigned int, cacheGeneration, CacheGeneration);
 
 		bool hasFont(chstr name) const;
 
@@ -72,18 +192,38 @@ namespace atres
 		void destroyFont(Font* font);
 		void unregisterFont(Font* font);
 		void registerFontAlias(chstr name, chstr alias);
+		/// @brief Gets a font and sets its scale from the font name (e.g. "Arial:0.8").
+		/// @param[in] name The font name.
+		/// @return The font.
+		/// @note This modifies the scale of the shared font object so it is not thread-safe. Use resolveFont() to get the font and the scale without modifying the font.
+		/// @note Text rendering does not depend on the scale set here anymore.
 		Font* getFont(chstr name);
+		/// @brief Resolves a font name with an optional scale suffix (e.g. "Arial:0.8") into a font and a scale.
+		/// @param[in] name The font name.
+		/// @return The resolved font.
+		/// @note The result is cached per font name and no font is modified in the process.
+		ResolvedFont resolveFont(chstr name);
 		
 		inline const hmap<hstr, Font*>& getFonts() const { return this->fonts; }
 
 		void analyzeText(chstr fontName, chstr text);
 		hstr analyzeFormatting(chstr text, harray<FormatTag>& tags);
+		/// @brief Analyzes the formatting of a text once so it can be reused for drawing and measuring without parsing it again.
+		/// @param[in] fontName Name of the default font.
+		/// @param[in] text The text with formatting tags.
+		/// @return The analyzed text.
+		FormattedText makeFormattedText(chstr fontName, chstr text);
 		harray<RenderLine> removeOutOfBoundLines(const harray<RenderLine>& lines, cgrectf rect);
 		void verticalCorrection(harray<RenderLine>& lines, cgrectf rect, const Vertical& vertical, float x, float lineHeight, float descender, float internalDescender);
 		void horizontalCorrection(harray<RenderLine>& lines, cgrectf rect, Horizontal horizontal, float y);
+		/// @note The per-character data of the words is stored in LayoutContext::getGlyphRun() of the used context.
 		harray<RenderWord> createRenderWords(cgrectf rect, chstr text, const harray<FormatTag>& tags);
+		/// @note The per-character data of the words is stored in LayoutContext::getGlyphRun() of the used context.
+		harray<RenderWord> createRenderWords(LayoutContext& context, cgrectf rect, chstr text, const harray<FormatTag>& tags);
 		harray<RenderLine> createRenderLines(cgrectf rect, chstr text, const harray<FormatTag>& tags, const Horizontal& horizontal, const Vertical& vertical, cgvec2f offset = gvec2f());
+		harray<RenderLine> createRenderLines(LayoutContext& context, cgrectf rect, chstr text, const harray<FormatTag>& tags, const Horizontal& horizontal, const Vertical& vertical, cgvec2f offset = gvec2f());
 		RenderText createRenderText(cgrectf rect, chstr text, const harray<RenderLine>& lines, const harray<FormatTag>& tags, const ColorData* colorData = NULL);
+		RenderText createRenderText(LayoutContext& context, cgrectf rect, chstr text, const harray<RenderLine>& lines, const harray<FormatTag>& tags, const ColorData* colorData = NULL);
 		harray<RenderSequence> optimizeSequences(harray<RenderSequence>& sequences);
 		harray<RenderLiningSequence> optimizeSequences(harray<RenderLiningSequence>& sequences);
 
@@ -102,16 +242,52 @@ namespace atres
 		void drawTextUnformatted(cgrectf rect, chstr text, const Horizontal& horizontal, const Vertical& vertical, const ColorData& colorData, cgvec2f offset = gvec2f());
 		void drawText(chstr fontName, cgrectf rect, chstr text, const Horizontal& horizontal, const Vertical& vertical, const ColorData& colorData, cgvec2f offset = gvec2f());
 		void drawTextUnformatted(chstr fontName, cgrectf rect, chstr text, const Horizontal& horizontal, const Vertical& vertical, const ColorData& colorData, cgvec2f offset = gvec2f());
+		// preformatted
+		void drawText(const FormattedText& formattedText, cgrectf rect, const Horizontal& horizontal = Horizontal::Left, const Vertical& vertical = Vertical::Center,
+			const april::Color& color = april::Color::White, cgvec2f offset = gvec2f());
+		void drawText(const FormattedText& formattedText, cgrectf rect, const Horizontal& horizontal, const Vertical& vertical, const ColorData& colorData, cgvec2f offset = gvec2f());
+		// retained
+		/// @brief Draws a retained text object and rebuilds its render data only if it was invalidated.
+		/// @param[in] textObject The text object.
+		void drawTextObject(TextObject& textObject);
+		/// @brief Draws only the first glyphs of a retained text object (e.g. for typewriter effects) without laying out the text again.
+		/// @param[in] textObject The text object.
+		/// @param[in] glyphCount Number of characters and icons in layout order to draw, including their shadows, borders and linings.
+		void drawTextObject(TextObject& textObject, int glyphCount);
+		// append-only
+		/// @brief Appends text in a new line and lays out only the new text.
+		/// @param[in] appendableText The appendable text.
+		/// @param[in] text The text with formatting tags.
+		void appendText(AppendableText& appendableText, chstr text);
+		/// @brief Draws all lines of an appendable text that are fully inside of its rect.
+		/// @param[in] appendableText The appendable text.
+		void drawAppendableText(AppendableText& appendableText);
+		// virtualized
+		/// @brief Lays out a virtualized text into its line index if required.
+		/// @param[in] virtualizedText The virtualized text.
+		void updateVirtualizedText(VirtualizedText& virtualizedText);
+		/// @brief Draws only the lines of a virtualized text that intersect its rect at the current scroll offset.
+		/// @param[in] virtualizedText The virtualized text.
+		void drawVirtualizedText(VirtualizedText& virtualizedText);
 		// base methods
 		harray<RenderLine> makeRenderLines(chstr fontName, cgrectf rect, chstr text, const Horizontal& horizontal = Horizontal::Left, const Vertical& vertical = Vertical::Center,
 			const april::Color& color = april::Color::White, cgvec2f offset = gvec2f());
 		harray<RenderLine> makeRenderLinesUnformatted(chstr fontName, cgrectf rect, chstr text, const Horizontal& horizontal = Horizontal::Left, const Vertical& vertical = Vertical::Center,
 			const april::Color& color = april::Color::White, cgvec2f offset = gvec2f());
+		harray<RenderLine> makeRenderLines(const FormattedText& formattedText, cgrectf rect, const Horizontal& horizontal = Horizontal::Left, const Vertical& vertical = Vertical::Center,
+			const april::Color& color = april::Color::White, cgvec2f offset = gvec2f());
+		/// @brief Creates render lines for many texts at once and spreads the layout work over worker threads.
+		/// @param[in] requests The texts to lay out.
+		/// @param[in] workerCount Maximum number of additional worker threads, the calling thread always takes part. Worker threads are kept for later batches.
+		/// @return The render lines and dimensions of each text in the same order as the requests.
+		/// @note Missing characters are loaded on the calling thread before the workers start and results are added to the lines cache.
+		harray<LayoutResult> makeRenderLines(const harray<LayoutRequest>& requests, int workerCount = 3);
 
 		float getTextWidth(chstr fontName, chstr text);
 		float getTextWidth(chstr text);
 		float getTextWidthUnformatted(chstr fontName, chstr text);
 		float getTextWidthUnformatted(chstr text);
+		float getTextWidth(const FormattedText& formattedText);
 		float getTextAdvanceX(chstr fontName, chstr text);
 		float getTextAdvanceX(chstr text);
 		float getTextAdvanceXUnformatted(chstr fontName, chstr text);
@@ -136,12 +312,71 @@ namespace atres
 		// @see getTextWidth()
 		// @see makeRenderLines()
 		float getTextHeightUnformatted(chstr text, float maxWidth, const Horizontal& horizontal = Horizontal::LeftWrapped);
+		/// @brief Finds the largest font scale at which a text fits into a rect, measuring the words of the text only once.
+		/// @param[in] fontName Name of the font. If it already has a scale suffix (e.g. "Arial:0.8"), the fitted scales are applied on top of it.
+		/// @param[in] rect The rect the text has to fit into.
+		/// @param[in] text The text with formatting tags.
+		/// @param[in] minScale Smallest allowed scale.
+		/// @param[in] maxScale Largest allowed scale.
+		/// @param[in] horizontal Horizontal formatting.
+		/// @param[in] vertical Vertical formatting.
+		/// @return The found scale, the scaled font name for drawing and the render lines at that scale.
+		/// @note A non-empty text never fits into a rect without width.
+		/// @note Scales are searched in steps of 0.01 so that fitted font names of different texts can share cache entries.
+		FitResult fitText(chstr fontName, cgrectf rect, chstr text, float minScale, float maxScale, const Horizontal& horizontal = Horizontal::LeftWrapped,
+			const Vertical& vertical = Vertical::Center);
 		hstr getFittingText(chstr fontName, chstr text, float maxWidth);
 		hstr getFittingText(chstr text, float maxWidth);
 		hstr getFittingTextUnformatted(chstr fontName, chstr text, float maxWidth);
 		hstr getFittingTextUnformatted(chstr text, float maxWidth);
+		/// @brief Finds how much of the first line of a text fits into a width, leaving room for an ellipsis if the text has to be cut off.
+		/// @param[in] fontName Name of the font.
+		/// @param[in] text The text with formatting tags.
+		/// @param[in] maxWidth Maximum width.
+		/// @param[in] ellipsis Text that will be appended to a cut off text (e.g. "..."), its width is only reserved if the text doesn't fit as a whole.
+		/// @return Byte offset in the unformatted text where the fitting part ends.
+		/// @note Uses binary searches over the words and the per-character widths of the cached layout.
+		int getFittingTextOffset(chstr fontName, chstr text, float maxWidth, chstr ellipsis = "");
+		/// @brief Finds how much of the first line of a text fits into a width, leaving room for an ellipsis if the text has to be cut off.
+		/// @param[in] fontName Name of the font.
+		/// @param[in] text The text without formatting tags.
+		/// @param[in] maxWidth Maximum width.
+		/// @param[in] ellipsis Text that will be appended to a cut off text (e.g. "..."), its width is only reserved if the text doesn't fit as a whole.
+		/// @return Byte offset in the text where the fitting part ends.
+		/// @note Uses binary searches over the words and the per-character widths of the cached layout.
+		int getFittingTextOffsetUnformatted(chstr fontName, chstr text, float maxWidth, chstr ellipsis = "");
+		/// @brief Cuts off the first line of a text at a width and appends an ellipsis if it doesn't fit as a whole.
+		/// @return The unformatted truncated text.
+		/// @see getFittingTextOffset()
+		hstr getTruncatedText(chstr fontName, chstr text, float maxWidth, chstr ellipsis);
+		/// @brief Cuts off the first line of a text without formatting tags at a width and appends an ellipsis if it doesn't fit as a whole.
+		/// @return The truncated text.
+		/// @see getFittingTextOffsetUnformatted()
+		hstr getTruncatedTextUnformatted(chstr fontName, chstr text, float maxWidth, chstr ellipsis);
+		/// @brief Finds the caret position in a text that is closest to a point.
+		/// @param[in] lines Render lines of the text, e.g. from makeRenderLines().
+		/// @param[in] position The point in the same coordinates as the lines.
+		/// @return Byte index in the unformatted text.
+		/// @note Lines, words and characters are found with binary searches over the layout, so this is cheap to call for every mouse event.
+		int getTextIndexAt(const harray<RenderLine>& lines, cgvec2f position);
+		/// @brief Gets the caret rectangle in front of a character of a text.
+		/// @param[in] lines Render lines of the text, e.g. from makeRenderLines().
+		/// @param[in] index Byte index in the unformatted text.
+		/// @return Caret rectangle with a width of 0 and the height of the line.
+		grectf getCaretRect(const harray<RenderLine>& lines, int index);
+		/// @brief Gets the rectangles that cover a range of a text, one for each line.
+		/// @param[in] lines Render lines of the text, e.g. from makeRenderLines().
+		/// @param[in] start Byte index in the unformatted text where the range starts.
+		/// @param[in] end Byte index in the unformatted text where the range ends (exclusive).
+		/// @return The selection rectangles.
+		harray<grectf> getSelectionRects(const harray<RenderLine>& lines, int start, int end);
 
 		void clearCache();
+		/// @brief Checks whether the textures of all fonts are still uploaded and invalidates text that uses lost textures.
+		/// @return True if no textures were lost.
+		/// @note Drawing cached text only compares texture generations, so this has to be called after the textures could have been lost
+		/// (e.g. Android's onPause) or at most once per frame.
+		bool checkTextures();
 
 	protected:
 		hmap<hstr, Font*> fonts;
@@ -155,116 +390,89 @@ namespace atres
 		bool globalOffsets;
 		bool useLegacyLineBreakParsing;
 		bool useIdeographWords;
+		bool scaleInvariantLayout;
 		Horizontal justifiedDefault;
 		Cache<CacheEntryText>* cacheText;
 		Cache<CacheEntryText>* cacheTextUnformatted;
 		Cache<CacheEntryLines>* cacheLines;
 		Cache<CacheEntryLines>* cacheLinesUnformatted;
+		Cache<CacheEntryLineBreaks>* cacheLineBreaks;
+		Cache<CacheEntryLineBreaks>* cacheLineBreaksUnformatted;
+		Cache<CacheEntryWords>* cacheWords;
+		Cache<CacheEntryWords>* cacheWordsUnformatted;
+		unsigned int cacheGeneration;
+		/// @brief Layout context used by the renderer's own drawing and measuring.
+		LayoutContext layoutContext;
+		hmap<hstr, ResolvedFont> resolvedFonts;
+		hmutex resolvedFontsMutex;
+		/// @brief Last ID given to a FormattedText, guarded because formatted texts can be made on any thread.
+		unsigned int formattedTextId;
+		hmutex formattedTextIdMutex;
+		/// @brief Worker threads of batched layouts, created on demand and kept until the renderer is destroyed.
+		harray<LayoutWorker*> layoutWorkers;
 
-		void _initializeFormatTags(const harray<FormatTag>& tags);
-		void _initializeLineProcessing(const harray<RenderLine>& lines = harray<RenderLine>());
-		void _initializeRenderSequences();
-		void _checkFormatTags(chstr text, int index);
-		void _processFormatTags(chstr text, int index);
-		void _makeGradientColors(cgrectf drawRect, const ColorData* colorData, april::Color& topLeft, april::Color& topRight, april::Color& bottomLeft, april::Color& bottomRight);
-		void _checkSequenceSwitch();
-		void _updateLiningSequenceSwitch(bool force = false);
+		void _initializeFormatTags(LayoutContext& context, const harray<FormatTag>& tags);
+		void _initializeLineProcessing(LayoutContext& context);
+		void _setCharacters(LayoutContext& context, const hmap<unsigned int, CharacterDefinition*>& characters);
+		CharacterDefinition* _findCharacter(LayoutContext& context, unsigned int code);
+		void _createRenderLines(LayoutContext& context, harray<RenderLine>& result, cgrectf rect, chstr text, const harray<FormatTag>& tags, const Horizontal& horizontal, const Vertical& vertical, cgvec2f offset = gvec2f());
+		void _createLineBreaks(LayoutContext& context, harray<RenderLine>& result, float width, chstr text, const harray<FormatTag>& tags, const Horizontal& horizontal);
+		bool _createScaledLineBreaks(LayoutContext& context, Cache<CacheEntryWords>* wordsCache, harray<RenderLine>& result, const CacheEntryBasicText& entry, chstr text, const harray<FormatTag>& tags, const Horizontal& horizontal);
+		harray<RenderWord> _createRenderWords(LayoutContext& context, cgrectf rect, chstr text, const harray<FormatTag>& tags, int textStart, int textEnd);
+		void _breakRenderWords(LayoutContext& context, harray<RenderLine>& result, harray<RenderWord>& words, float width, const Horizontal& horizontal);
+		CacheEntryWords* _makeRenderWords(LayoutContext& context, Cache<CacheEntryWords>* wordsCache, chstr text, unsigned int textHash, chstr fontName, chstr unformattedText, const harray<FormatTag>& tags);
+		bool _scaleRenderWords(LayoutContext& context, const CacheEntryWords& entry, float scale, float width, harray<RenderWord>& words);
+		int _getFittingTextOffset(chstr fontName, chstr text, float maxWidth, chstr ellipsis, bool& truncated);
+		int _findLineIndex(const harray<RenderLine>& lines, int index);
+		float _getCaretX(const RenderLine& line, int index);
+		int _findFittingWord(const RenderLine& line, float maxWidth, float ellipsisWidth, int& byteCount);
+		bool _checkTextFit(LayoutContext& context, chstr fontName, cgrectf rect, chstr text, unsigned int textHash, chstr unformattedText, const harray<FormatTag>& tags, const Horizontal& horizontal, float scale);
+		void _placeRenderLines(harray<RenderLine>& lines, cgrectf rect, const Horizontal& horizontal, const Vertical& vertical, cgvec2f offset, float lineHeight, float descender, float internalDescender);
+		void _makeRenderLines(LayoutContext& context, Cache<CacheEntryLineBreaks>* lineBreaksCache, Cache<CacheEntryWords>* wordsCache, const CacheEntryBasicText& entry, harray<RenderLine>& result, chstr text, const harray<FormatTag>& tags);
+		void _createRenderText(LayoutContext& context, RenderText& result, cgrectf rect, chstr text, const harray<RenderLine>& lines, const harray<FormatTag>& tags, const ColorData* colorData = NULL);
+		void _initializeRenderSequences(LayoutContext& context);
+		void _checkFormatTags(LayoutContext& context, chstr text, int index);
+		void _processFormatTags(LayoutContext& context, chstr text, int index);
+		void _makeGradientColors(LayoutContext& context, cgrectf drawRect, const ColorData* colorData, april::Color& topLeft, april::Color& topRight, april::Color& bottomLeft, april::Color& bottomRight);
+		void _resetRenderSequence(RenderSequence& sequence);
+		void _resetRenderLiningSequence(RenderLiningSequence& sequence, const april::Color& color);
+		void _checkSequenceSwitch(LayoutContext& context);
+		void _updateLiningSequenceSwitch(LayoutContext& context, bool force = false);
+		ResolvedFont _resolveFont(chstr name);
+		ResolvedFont _resolveTagFont(const FormatTag& tag);
+		void _preloadCharacters(chstr text, const harray<FormatTag>& tags);
+		void _preloadBorderCharacters(chstr text, const harray<FormatTag>& tags);
 		bool _checkTextures();
+		bool _checkTextures(const RenderText& renderText);
+		void _updateTextObject(TextObject& textObject);
+		void _updateAppendableText(AppendableText& appendableText);
+		void _updateVirtualizedWindow(VirtualizedText& virtualizedText, bool force);
+		void _moveRenderLines(harray<RenderLine>& lines, int start, cgvec2f offset);
+		void _moveRenderText(RenderText& renderText, cgvec2f offset);
+		void _mergeRenderText(RenderText& result, const RenderText& other);
 		harray<FormatTag> _makeDefaultTags(const april::Color& color, chstr fontName, hstr& text);
 		harray<FormatTag> _makeDefaultTagsUnformatted(const april::Color& color, chstr fontName);
+		harray<FormatTag> _makeDefaultTags(const april::Color& color, const FormattedText& formattedText);
 
 		void _drawRenderText(RenderText& renderText, const april::Color& color);
-		void _drawRenderSequence(RenderSequence& sequence, unsigned char alpha);
+		void _drawRenderText(RenderText& renderText, const april::Color& color, int glyphCount);
+		void _drawRenderTextRange(RenderText& renderText, const april::Color& color, int firstGlyph, int lastGlyph);
+		void _drawRenderSequence(RenderSequence& sequence, unsigned char alpha, int vertexCount = -1, int vertexStart = 0);
 		void _drawRenderLiningSequence(RenderLiningSequence& sequence, const april::Color& color);
+		void _drawRenderLiningSequenceRange(RenderLiningSequence& sequence, const april::Color& color, int vertexStart, int vertexCount);
+		void _drawRenderLiningSequence(RenderLiningSequence& sequence, const april::Color& color, int glyphCount);
 
 	private:
-		harray<FormatTag> _tags;
-		harray<FormatTag> _stack;
-		FormatTag _currentTag;
-		FormatTag _nextTag;
-
-		hstr _fontName;
-		Font* _font;
-		FontIconMap* _iconFont;
-		hstr _fontIconName;
-		hmap<unsigned int, CharacterDefinition*>& _characters;
-		hmap<unsigned int, CharacterDefinition*> _dummyCharacters; // required for some compilers
-		hmap<hstr, IconDefinition*>& _icons;
-		hmap<hstr, IconDefinition*> _dummyIcons; // required for some compilers
-		CharacterDefinition* _character;
-		BorderCharacterDefinition* _borderCharacter;
-		IconDefinition* _icon;
-		BorderIconDefinition* _borderIcon;
-		float _height;
-		float _lineHeight;
-		float _descender;
-		float _internalDescender;
-		float _strikeThroughOffset;
-		float _underlineOffset;
-		float _italicSkewRatio;
-		float _fontScale;
-		float _fontBaseScale;
-		float _iconFontScale;
-		float _iconFontBearingX;
-		float _iconFontOffsetY;
-		hmap<hstr, float> _iconFontCustomFontOffsets;
-		float _textScale;
-		float _scale;
-		gvec2f _shadowOffset;
-		gvec2f _textShadowOffset;
-		float _borderThickness;
-		float _borderFontThickness;
-		float _textBorderThickness;
-
-		harray<RenderSequence> _textSequences;
-		RenderSequence _textSequence;
-		harray<RenderSequence> _shadowSequences;
-		RenderSequence _shadowSequence;
-		harray<RenderSequence> _borderSequences;
-		RenderSequence _borderSequence;
-		RenderRectangle _renderRect;
-		grectf _liningRect;
-		harray<RenderLiningSequence> _textLiningSequences;
-		RenderLiningSequence _textStrikeThroughSequence;
-		RenderLiningSequence _textUnderlineSequence;
-		harray<RenderLiningSequence> _shadowLiningSequences;
-		RenderLiningSequence _shadowStrikeThroughSequence;
-		RenderLiningSequence _shadowUnderlineSequence;
-		harray<RenderLiningSequence> _borderLiningSequences;
-		RenderLiningSequence _borderStrikeThroughSequence;
-		RenderLiningSequence _borderUnderlineSequence;
-
-		april::Color _textColor;
-		april::Color _shadowColor;
-		april::Color _borderColor;
-		april::Color _strikeThroughColor;
-		april::Color _underlineColor;
-		hstr _hex;
-		hstr _parameterString0;
-		hstr _parameterString1;
-		int _effectMode;
-		bool _strikeThroughActive;
-		float _strikeThroughThickness;
-		float _textStrikeThroughThickness;
-		bool _underlineActive;
-		float _underlineThickness;
-		float _textUnderlineThickness;
-		bool _italicActive;
-		bool _hideActive;
-		int _alpha;
-
 		harray<RenderLine> _lines;
-		RenderLine _line;
-		RenderWord _word;
-
-		april::Texture* _texture;
-		unsigned int _code;
-		hstr _iconName;
 
 		CacheEntryText* _cacheEntryText;
 		CacheEntryText _cacheEntryTextData;
 		CacheEntryLines* _cacheEntryLines;
 		CacheEntryLines _cacheEntryLinesData;
+		CacheEntryLineBreaks* _cacheEntryLineBreaks;
+		CacheEntryLineBreaks _cacheEntryLineBreaksData;
+		CacheEntryWords* _cacheEntryWords;
+		CacheEntryWords _cacheEntryWordsData;
 
 	};
 	
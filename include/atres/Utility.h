@@ -27,6 +27,8 @@
 
 namespace atres
 {
+	class Font;
+
 	HL_ENUM_CLASS_PREFIX_DECLARE(atresExport, Horizontal,
 	(
 		HL_ENUM_DECLARE(Horizontal, Left);
@@ -136,14 +138,19 @@ namespace atres
 		bool multiplyAlpha;
 		harray<april::ColoredTexturedVertex> vertices;
 		harray<april::Color> colors;
+		/// @brief Glyph index in layout order of each rectangle.
+		harray<int> glyphs;
 		
 		RenderSequence();
 
 		/// @note Not thread-safe!
-		void addRenderRectangle(const RenderRectangle& rect, const april::Color& color, float italicSkewOffset);
+		void addRenderRectangle(const RenderRectangle& rect, const april::Color& color, float italicSkewOffset, int glyph = 0);
 		void addRenderRectangle(const RenderRectangle& rect, const april::Color& colorTopLeft, const april::Color& colorTopRight,
-			const april::Color& colorBottomLeft, const april::Color& colorBottomRight, float italicSkewOffset);
-		void mergeFrom(const RenderSequence& other);
+			const april::Color& colorBottomLeft, const april::Color& colorBottomRight, float italicSkewOffset, int glyph = 0);
+		/// @brief Gets the number of vertices that belong to glyphs before the given glyph index.
+		int getRevealedVertexCount(int glyphCount) const;
+		/// @param[in] glyphOffset Offset added to the glyph indices of the merged rectangles.
+		void mergeFrom(const RenderSequence& other, int glyphOffset = 0);
 		void clear();
 
 	};
@@ -153,16 +160,46 @@ namespace atres
 	public:
 		april::Color color;
 		harray<april::PlainVertex> vertices;
+		/// @brief Index of the first glyph in layout order of each rectangle.
+		harray<int> glyphs;
+		/// @brief Index of the last glyph in layout order of each rectangle, since rectangles of consecutive glyphs are merged.
+		harray<int> lastGlyphs;
 
 		RenderLiningSequence();
 
 		/// @note Not thread-safe!
-		void addRectangle(cgrectf rect);
-		void mergeFrom(const RenderLiningSequence& other);
+		void addRectangle(cgrectf rect, int glyph = 0);
+		/// @brief Gets the number of vertices that belong to rectangles starting before the given glyph index.
+		int getRevealedVertexCount(int glyphCount) const;
+		/// @param[in] glyphOffset Offset added to the glyph indices of the merged rectangles.
+		void mergeFrom(const RenderLiningSequence& other, int glyphOffset = 0);
 		void clear();
 
 	};
 
+	/// @brief Per-character layout data of multiple words stored as structure of arrays.
+	class atresExport GlyphRun
+	{
+	public:
+		harray<float> charXs;
+		harray<float> charAdvanceXs;
+		harray<float> segmentWidths;
+
+		GlyphRun();
+
+		inline int size() const { return this->charXs.size(); }
+
+		/// @note Not thread-safe!
+		void add(float charX, float charAdvanceX, float segmentWidth);
+		void addFrom(const GlyphRun& other, int start, int count);
+		/// @brief Multiplies all metrics by a factor.
+		void scale(float factor);
+		void clear();
+		/// @brief Exchanges the data with another glyph run without copying it.
+		void swap(GlyphRun& other);
+
+	};
+
 	class atresExport RenderWord
 	{
 	public:
@@ -174,10 +211,10 @@ namespace atres
 		bool icon;
 		float advanceX;
 		float bearingX;
-		harray<float> charXs;
-		harray<float> charHeights;
-		harray<float> charAdvanceXs;
-		harray<float> segmentWidths;
+		/// @brief Index of the first character in the GlyphRun of the line (or of the LayoutContext before the word was added to a line).
+		int glyphIndex;
+		/// @brief Number of characters in the GlyphRun.
+		int glyphCount;
 
 		RenderWord();
 
@@ -205,6 +242,8 @@ namespace atres
 		float advanceX;
 		bool terminated;
 		harray<RenderWord> words;
+		/// @brief Per-character layout data of all words.
+		GlyphRun glyphs;
 		
 		RenderLine();
 
@@ -220,11 +259,40 @@ namespace atres
 		harray<RenderLiningSequence> textLiningSequences;
 		harray<RenderLiningSequence> shadowLiningSequences;
 		harray<RenderLiningSequence> borderLiningSequences;
+		/// @brief Fonts whose textures are used by the sequences.
+		harray<Font*> fonts;
+		/// @brief Texture generations of the fonts at the time the sequences were created.
+		harray<unsigned int> textureGenerations;
+		/// @brief Number of characters and icons in layout order that can be revealed.
+		int glyphCount;
 
 		RenderText();
 
 	};
 
+	/// @brief Font with the scale resolved from a font name such as "Arial:0.8".
+	/// @note The font itself is not modified, all metrics are calculated with the resolved scale.
+	class atresExport ResolvedFont
+	{
+	public:
+		/// @brief The font.
+		Font* font;
+		/// @brief The scale applied to the font.
+		float scale;
+
+		ResolvedFont();
+		ResolvedFont(Font* font, float scale);
+
+		float getScale() const;
+		float getHeight() const;
+		float getLineHeight() const;
+		float getDescender() const;
+		float getInternalDescender() const;
+		float getStrikeThroughOffset() const;
+		float getUnderlineOffset() const;
+
+	};
+
 	class atresExport FormatTag
 	{
 	public:
@@ -252,11 +320,278 @@ namespace atres
 		hstr consumedData;
 		int start;
 		int count;
+		/// @brief Font resolved in advance from the data of Font and Icon tags.
+		ResolvedFont font;
+		/// @brief Color resolved in advance from the data of Color tags.
+		april::Color color;
+		/// @brief Whether the font or the color has been resolved in advance and can be used instead of the data.
+		bool resolved;
 		
 		FormatTag();
 
 	};
 
+	/// @brief Text with already analyzed formatting that can be reused for rendering and measuring.
+	/// @note Created with Renderer::makeFormattedText(). Fonts and colors of the tags are resolved in advance as well, but only
+	/// used while the renderer's cache generation has not changed, e.g. due to fonts being registered or unregistered.
+	class atresExport FormattedText
+	{
+	public:
+		friend class Renderer;
+
+		FormattedText();
+
+		/// @brief The original text with formatting tags.
+		HL_DEFINE_GET(hstr, text, Text);
+		/// @brief The font name.
+		HL_DEFINE_GET(hstr, fontName, FontName);
+		/// @brief The text without formatting tags.
+		HL_DEFINE_GET(hstr, unformattedText, UnformattedText);
+		/// @brief The analyzed formatting tags with byte offsets in the unformatted text.
+		inline const harray<FormatTag>& getTags() const { return this->tags; }
+		/// @brief Hash value of the original text used for caching.
+		HL_DEFINE_GET(unsigned int, textHash, TextHash);
+		/// @brief Unique ID of the text used for caching.
+		/// @note Cache entries with the same ID are known to have the same text so the text does not have to be compared.
+		HL_DEFINE_GET(unsigned int, textId, TextId);
+
+	protected:
+		hstr text;
+		hstr fontName;
+		hstr unformattedText;
+		harray<FormatTag> tags;
+		unsigned int textHash;
+		unsigned int textId;
+		/// @brief Font resolved in advance from the font name.
+		ResolvedFont font;
+		/// @brief The renderer's cache generation when the fonts were resolved.
+		unsigned int cacheGeneration;
+
+	};
+
+	/// @brief Retained text that keeps its render data between draws and is only rebuilt when its inputs or the font cache change.
+	/// @note Drawn with Renderer::drawTextObject().
+	class atresExport TextObject
+	{
+	public:
+		friend class Renderer;
+
+		TextObject();
+		TextObject(chstr fontName, cgrectf rect, chstr text, const Horizontal& horizontal = Horizontal::Left, const Vertical& vertical = Vertical::Center,
+			const april::Color& color = april::Color::White, cgvec2f offset = gvec2f());
+
+		HL_DEFINE_GET(hstr, fontName, FontName);
+		void setFontName(chstr value);
+		HL_DEFINE_GET(hstr, text, Text);
+		void setText(chstr value);
+		HL_DEFINE_GET(grectf, rect, Rect);
+		void setRect(cgrectf value);
+		HL_DEFINE_GET(Horizontal, horizontal, Horizontal);
+		void setHorizontal(const Horizontal& value);
+		HL_DEFINE_GET(Vertical, vertical, Vertical);
+		void setVertical(const Vertical& value);
+		HL_DEFINE_GET(april::Color, color, Color);
+		/// @note Changing only the alpha value does not require the text to be rebuilt.
+		void setColor(const april::Color& value);
+		HL_DEFINE_GET(gvec2f, offset, Offset);
+		void setOffset(cgvec2f value);
+		HL_DEFINE_IS(valid, Valid);
+		/// @brief The render data from the last rebuild.
+		inline const RenderText& getRenderText() const { return this->renderText; }
+		/// @brief Gets the number of glyphs that can be revealed.
+		/// @note Only available after the object was drawn.
+		inline int getGlyphCount() const { return this->renderText.glyphCount; }
+
+		/// @brief Forces the text to be rebuilt on the next draw.
+		void invalidate();
+
+	protected:
+		hstr fontName;
+		hstr text;
+		grectf rect;
+		Horizontal horizontal;
+		Vertical vertical;
+		april::Color color;
+		gvec2f offset;
+		RenderText renderText;
+		bool valid;
+		unsigned int cacheGeneration;
+
+	};
+
+	/// @brief Append-only text (e.g. chat logs or consoles) where only newly appended text is laid out.
+	/// @note Every appended text starts in a new line and formatting tags do not carry over between appended texts.
+	/// @note Appended with Renderer::appendText() and drawn with Renderer::drawAppendableText().
+	class atresExport AppendableText
+	{
+	public:
+		friend class Renderer;
+
+		AppendableText();
+		AppendableText(chstr fontName, cgrectf rect, const Horizontal& horizontal = Horizontal::LeftWrapped, const Vertical& vertical = Vertical::Bottom,
+			const april::Color& color = april::Color::White);
+
+		HL_DEFINE_GET(hstr, fontName, FontName);
+		void setFontName(chstr value);
+		/// @note Changing only the position or height of the rect does not require the text to be laid out again.
+		HL_DEFINE_GET(grectf, rect, Rect);
+		void setRect(cgrectf value);
+		HL_DEFINE_GET(Horizontal, horizontal, Horizontal);
+		void setHorizontal(const Horizontal& value);
+		HL_DEFINE_GETSET(Vertical, vertical, Vertical);
+		HL_DEFINE_GET(april::Color, color, Color);
+		/// @note Changing only the alpha value does not require the text to be laid out again.
+		void setColor(const april::Color& value);
+		/// @brief All appended texts.
+		inline const harray<hstr>& getTexts() const { return this->texts; }
+		/// @brief Height of all laid out lines.
+		HL_DEFINE_GET(float, height, Height);
+
+		/// @brief Removes all text.
+		void clear();
+		/// @brief Forces all text to be laid out again on the next draw.
+		void invalidate();
+
+	protected:
+		hstr fontName;
+		grectf rect;
+		Horizontal horizontal;
+		Vertical vertical;
+		april::Color color;
+		harray<hstr> texts;
+		harray<RenderLine> lines;
+		/// @brief Render data of all lines merged into one set of sequences.
+		RenderText renderText;
+		/// @brief Index of the first glyph of each line within the render data, used to draw only the visible lines.
+		harray<int> lineGlyphs;
+		float height;
+		gvec2f offset;
+		int laidOutCount;
+		bool valid;
+		unsigned int cacheGeneration;
+
+	};
+
+	/// @brief A single entry in the line index of a VirtualizedText.
+	class atresExport VirtualizedLine
+	{
+	public:
+		/// @brief Byte offset of the line's first character in the unformatted text.
+		int start;
+		/// @brief Vertical position of the line within the text.
+		float y;
+		/// @brief Height of the line.
+		float height;
+
+		VirtualizedLine();
+
+	};
+
+	/// @brief Long scrollable text (e.g. credits or license texts) where only the lines inside of the visible window are laid out and rendered.
+	/// @note The text is measured once into a compact line index and only the visible lines are laid out again when the window changes.
+	/// @note Scrolling within the same visible lines only moves the existing vertices.
+	/// @note Drawn with Renderer::drawVirtualizedText().
+	class atresExport VirtualizedText
+	{
+	public:
+		friend class Renderer;
+
+		VirtualizedText();
+		VirtualizedText(chstr fontName, chstr text, cgrectf rect, const Horizontal& horizontal = Horizontal::LeftWrapped,
+			const april::Color& color = april::Color::White);
+
+		HL_DEFINE_GET(hstr, fontName, FontName);
+		void setFontName(chstr value);
+		HL_DEFINE_GET(hstr, text, Text);
+		void setText(chstr value);
+		/// @note Changing only the position or height of the rect does not require the text to be laid out again.
+		HL_DEFINE_GET(grectf, rect, Rect);
+		void setRect(cgrectf value);
+		HL_DEFINE_GET(Horizontal, horizontal, Horizontal);
+		void setHorizontal(const Horizontal& value);
+		HL_DEFINE_GET(april::Color, color, Color);
+		/// @note Changing only the alpha value does not require the text to be laid out again.
+		void setColor(const april::Color& value);
+		/// @brief Vertical scroll offset of the visible window within the text.
+		HL_DEFINE_GET(float, scrollOffset, ScrollOffset);
+		void setScrollOffset(float value);
+		/// @brief Height of the entire laid out text.
+		/// @note Only available after the text was laid out with Renderer::updateVirtualizedText() or drawn.
+		HL_DEFINE_GET(float, height, Height);
+		/// @brief Gets the number of lines in the line index.
+		inline int getLineCount() const { return this->lines.size(); }
+
+		/// @brief Forces the text to be laid out again on the next draw.
+		void invalidate();
+
+	protected:
+		hstr fontName;
+		hstr text;
+		grectf rect;
+		Horizontal horizontal;
+		april::Color color;
+		float scrollOffset;
+		float height;
+		hstr unformattedText;
+		harray<FormatTag> tags;
+		harray<VirtualizedLine> lines;
+		RenderText renderText;
+		gvec2f renderOffset;
+		int firstLine;
+		int lastLine;
+		bool valid;
+		bool renderValid;
+		unsigned int cacheGeneration;
+
+	};
+
+	/// @brief A single text in a batched layout.
+	/// @note Used with Renderer::makeRenderLines().
+	class atresExport LayoutRequest
+	{
+	public:
+		hstr fontName;
+		grectf rect;
+		hstr text;
+		Horizontal horizontal;
+		Vertical vertical;
+		gvec2f offset;
+
+		LayoutRequest();
+		LayoutRequest(chstr fontName, cgrectf rect, chstr text, const Horizontal& horizontal = Horizontal::Left, const Vertical& vertical = Vertical::Center, cgvec2f offset = gvec2f());
+
+	};
+
+	/// @brief The result of a single text in a batched layout.
+	class atresExport LayoutResult
+	{
+	public:
+		harray<RenderLine> lines;
+		/// @brief Width of the widest line.
+		float width;
+		/// @brief Height of all lines.
+		float height;
+
+		LayoutResult();
+
+	};
+
+	/// @brief The result of fitting a text into a rect.
+	class atresExport FitResult
+	{
+	public:
+		/// @brief The scaled font name that the text can be drawn with (e.g. "Arial:0.85").
+		hstr fontName;
+		/// @brief The largest scale at which the text fits.
+		float scale;
+		/// @brief False if the text doesn't fit even at the smallest allowed scale.
+		bool fits;
+		harray<RenderLine> lines;
+
+		FitResult();
+
+	};
+
 	class atresExport TextureContainer
 	{
 	public:
@@ -289,6 +624,8 @@ namespace atres
 	{
 	public:
 		hstr text;
+		unsigned int textHash;
+		unsigned int textId;
 		hstr fontName;
 		grectf rect;
 		Horizontal horizontal;
@@ -306,11 +643,15 @@ namespace atres
 		virtual ~CacheEntryBasicText();
 
 		void set(chstr text, chstr fontName, cgrectf rect, Horizontal horizontal, Vertical vertical, const april::Color& color, cgvec2f offset);
+		void set(chstr text, unsigned int textHash, chstr fontName, cgrectf rect, Horizontal horizontal, Vertical vertical, const april::Color& color, cgvec2f offset);
+		void set(const FormattedText& formattedText, cgrectf rect, Horizontal horizontal, Vertical vertical, const april::Color& color, cgvec2f offset);
 		void set(chstr text, chstr fontName, cgrectf rect, Horizontal horizontal, Vertical vertical, const april::Color& color, bool useMoreColors,
 			const april::Color& colorTopRight, const april::Color& colorBottomLeft, const april::Color& colorBottomRight, bool horizontalColorFit, bool verticalColorFit, cgvec2f offset);
 		virtual bool isEqual(const CacheEntryBasicText& other) const;
 		unsigned int hash() const;
 
+		static unsigned int hashText(chstr text);
+
 	};
 
 	class CacheEntryText : public CacheEntryBasicText
@@ -331,6 +672,34 @@ namespace atres
 
 	};
 
+	/// @brief Cached line breaks of a text for one wrapping width, independent of alignment, height and position.
+	class CacheEntryLineBreaks : public CacheEntryBasicText
+	{
+	public:
+		harray<RenderLine> value;
+		float lineHeight;
+		float descender;
+		float internalDescender;
+
+		CacheEntryLineBreaks();
+
+	};
+
+	/// @brief Cached words of a text measured with an unscaled font, used by scale-invariant layout.
+	class CacheEntryWords : public CacheEntryBasicText
+	{
+	public:
+		harray<RenderWord> value;
+		GlyphRun glyphs;
+		float height;
+		float lineHeight;
+		float descender;
+		float internalDescender;
+
+		CacheEntryWords();
+
+	};
+
 	class CacheEntryLine
 	{
 	public:
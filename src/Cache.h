@@ -44,6 +44,8 @@ namespace atres
 		}
 		/// @brief Adds a cache entry.
 		/// @param[in] entry The cache entry.
+		/// @note An already existing equal entry is overwritten.
+		/// @note Usually only the key data is added and the value is created directly inside of the returned entry afterwards, to avoid copying it.
 		inline T* add(const T& entry)
 		{
 			unsigned int hash = entry.hash();
@@ -60,6 +62,10 @@ namespace atres
 				dataArray += newEntry;
 				this->entries += newEntry;
 			}
+			else
+			{
+				*dataArray[index] = entry;
+			}
 			return dataArray[index];
 		}
 		/// @brief Gets a cache entry.
@@ -43,7 +43,8 @@ namespace atres
 		underlineOffset(0.0f),
 		italicSkewRatio(0.3f),
 		loaded(false),
-		borderMode(Font::defaultBorderMode)
+		borderMode(Font::defaultBorderMode),
+		textureGeneration(0)
 	{
 		this->name = name;
 	}
@@ -150,37 +151,72 @@ namespace atres
 	
 	float Font::getHeight() const
 	{
-		return (this->height * this->scale * this->baseScale);
+		return this->getHeight(this->scale);
+	}
+
+	float Font::getHeight(float scale) const
+	{
+		return (this->height * scale * this->baseScale);
 	}
 	
 	float Font::getScale() const
 	{
-		return (this->scale * this->baseScale);
+		return this->getScale(this->scale);
 	}
-	
+
+	float Font::getScale(float scale) const
+	{
+		return (scale * this->baseScale);
+	}
+
 	float Font::getLineHeight() const
 	{
-		return (this->lineHeight * this->scale * this->baseScale);
+		return this->getLineHeight(this->scale);
+	}
+
+	float Font::getLineHeight(float scale) const
+	{
+		return (this->lineHeight * scale * this->baseScale);
 	}
 
 	float Font::getDescender() const
 	{
-		return (this->descender * this->scale * this->baseScale);
+		return this->getDescender(this->scale);
+	}
+
+	float Font::getDescender(float scale) const
+	{
+		return (this->descender * scale * this->baseScale);
 	}
 
 	float Font::getInternalDescender() const
 	{
-		return (this->internalDescender * this->scale * this->baseScale);
+		return this->getInternalDescender(this->scale);
+	}
+
+	float Font::getInternalDescender(float scale) const
+	{
+		return (this->internalDescender * scale * this->baseScale);
 	}
 
 	float Font::getStrikeThroughOffset() const
 	{
-		return (this->strikeThroughOffset * this->scale * this->baseScale);
+		return this->getStrikeThroughOffset(this->scale);
+	}
+
+	float Font::getStrikeThroughOffset(float scale) const
+	{
+		return (this->strikeThroughOffset * scale * this->baseScale);
 	}
 
 	float Font::getUnderlineOffset() const
 	{
-		return (this->underlineOffset * this->scale * this->baseScale);
+		return this->getUnderlineOffset(this->scale);
+	}
+
+	float Font::getUnderlineOffset(float scale) const
+	{
+		return (this->underlineOffset * scale * this->baseScale);
 	}
 
 	void Font::setBorderMode(const BorderMode& value)
@@ -203,6 +239,7 @@ namespace atres
 				delete (*it);
 			}
 			this->borderTextureContainers.clear();
+			++this->textureGeneration; // text using the deleted border textures has to be recreated
 		}
 	}
 
@@ -212,6 +249,32 @@ namespace atres
 		return (this->textureContainers + this->borderTextureContainers.cast<TextureContainer*>()).mapped(&_containerTextures::lambda);
 	}
 	
+	bool Font::checkTextures()
+	{
+		foreach (TextureContainer*, it, this->textureContainers)
+		{
+			if ((*it)->texture != NULL && !(*it)->texture->isUploaded())
+			{
+				++this->textureGeneration;
+				return false;
+			}
+		}
+		foreach (BorderTextureContainer*, it, this->borderTextureContainers)
+		{
+			if ((*it)->texture != NULL && !(*it)->texture->isUploaded())
+			{
+				++this->textureGeneration;
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void Font::invalidateTextures()
+	{
+		++this->textureGeneration;
+	}
+
 	april::Texture* Font::getTexture(unsigned int charCode)
 	{
 		foreachc (TextureContainer*, it, this->textureContainers)
@@ -324,6 +387,12 @@ namespace atres
 		return result;
 	}
 
+	Font* Font::getScaledInstance(float scale, float& instanceScale)
+	{
+		instanceScale = scale;
+		return this;
+	}
+
 	void Font::loadBasicAsciiCharacters()
 	{
 	}
@@ -332,6 +401,10 @@ namespace atres
 	{
 	}
 
+	void Font::loadBorderCharacters(chstr, float)
+	{
+	}
+
 	// using static definitions to avoid memory allocation for optimization, NOT THREAD-SAFE
 	static RenderRectangle _result;
 	static gvec2f _fullSize(1.0f, 1.0f);
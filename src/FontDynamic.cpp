@@ -174,7 +174,49 @@ namespace atres
 		this->_tryCreateFirstBorderTextureContainer(borderThickness);
 		for_itert (unsigned int, code, 32, 128)
 		{
-			this->_tryAddBorderCharacterBitmap(code, true);
+			this->_tryAddBorderCharacterBitmap(code, borderThickness);
+		}
+	}
+
+	void FontDynamic::loadBorderCharacters(chstr text, float borderThickness)
+	{
+		if (this->borderMode == BorderMode::Software)
+		{
+			return;
+		}
+		std::ustring chars = text.uStr();
+		harray<unsigned int> charCodes;
+		for_itert (unsigned int, i, 0, (unsigned int)chars.size())
+		{
+			if (!Font::hasBorderCharacter(chars[i], borderThickness) && !charCodes.has(chars[i]))
+			{
+				charCodes += chars[i];
+			}
+		}
+		if (charCodes.size() == 0)
+		{
+			return;
+		}
+		this->_tryCreateFirstBorderTextureContainer(borderThickness);
+		harray<april::Image*> images;
+		if (this->borderMode == BorderMode::FontNative)
+		{
+			// all border glyphs are created in one go so the font can prepare everything only once
+			images = this->_loadBorderCharacterImages(charCodes, borderThickness);
+		}
+		else
+		{
+			foreach (unsigned int, it, charCodes)
+			{
+				images += this->_generateBorderCharacterImage((*it), borderThickness);
+			}
+		}
+		for_iter (i, 0, charCodes.size())
+		{
+			if (images[i] != NULL)
+			{
+				this->_addBorderCharacterBitmap(charCodes[i], borderThickness, images[i]);
+			}
 		}
 	}
 
@@ -253,6 +295,12 @@ namespace atres
 		{
 			return false;
 		}
+		this->_addBorderCharacterBitmap(charCode, borderThickness, image);
+		return true;
+	}
+
+	void FontDynamic::_addBorderCharacterBitmap(unsigned int charCode, float borderThickness, april::Image* image)
+	{
 		// this makes sure that there is no vertical overlap between characters
 		BorderCharacterDefinition* borderCharacter = new BorderCharacterDefinition(borderThickness);
 		int charWidth = image->w + SAFE_SPACE * 2;
@@ -271,7 +319,6 @@ namespace atres
 		this->borderCharacters[charCode] += borderCharacter;
 		textureContainer->characters += charCode;
 		textureContainer->penX += charWidth + CHARACTER_SPACE * 2;
-		return true;
 	}
 
 	bool FontDynamic::_tryAddIconBitmap(chstr iconName, bool initial)
@@ -390,6 +437,16 @@ namespace atres
 		return NULL;
 	}
 
+	harray<april::Image*> FontDynamic::_loadBorderCharacterImages(const harray<unsigned int>& charCodes, float borderThickness)
+	{
+		harray<april::Image*> result;
+		foreachc (unsigned int, it, charCodes)
+		{
+			result += this->_loadBorderCharacterImage((*it), borderThickness);
+		}
+		return result;
+	}
+
 	april::Image* FontDynamic::_generateBorderCharacterImage(unsigned int charCode, float borderThickness)
 	{
 		float advance = 0;
@@ -8,6 +8,13 @@
 
 #include <math.h>
 #include <stdio.h>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define _ATRES_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define _ATRES_NEON
+#endif
 
 #include <april/april.h>
 #include <april/RenderSystem.h>
@@ -19,6 +26,7 @@
 #include <hltypes/hltypesUtil.h>
 #include <hltypes/hmap.h>
 #include <hltypes/hstring.h>
+#include <hltypes/hthread.h>
 
 #include "atres.h"
 #include "Cache.h"
@@ -29,17 +37,6 @@
 //#define _DEBUG_RENDER_TEXT
 #endif
 
-#define IS_IDEOGRAPH(code) \
-	( \
-		((code) >= 0x3040 && (code) <= 0x309F) ||	/* Hiragana */ \
-		((code) >= 0x30A0 && (code) <= 0x30FF) ||	/* Katakana */ \
-		((code) >= 0x3400 && (code) <= 0x4DFF) ||	/* CJK Unified Ideographs Extension A */ \
-		((code) >= 0x4E00 && (code) <= 0x9FFF) ||	/* CJK Unified Ideographs */ \
-		((code) >= 0xF900 && (code) <= 0xFAFF) ||	/* CJK Compatibility Ideographs */ \
-		((code) >= 0x20000 && (code) <= 0x2A6DF) ||	/* CJK Unified Ideographs Extension B */ \
-		((code) >= 0x2F800 && (code) <= 0x2FA1F)	/* CJK Compatibility Ideographs Supplement */ \
-	)
-
 #define IS_PUNCTUATION_CHAR(code) \
 	( \
 		(code) == 0x21 ||	/* exclamation mark */ \
@@ -95,33 +92,405 @@
 #define EFFECT_MODE_BORDER 2
 
 #define CHECK_RECT_SIZE 100000.0f // because of the 7-digit precision in floats
+#define FIT_TEXT_SCALE_STEP 0.01f // coarse enough that fitted font names share cache entries
+#define LAYOUT_WORKER_SPIN_COUNT 1000 // batches usually come in bursts so idle workers keep yielding for a while before they sleep
 
 namespace atres
 {
 	static hstr _iconPlaceholder = hstr::fromUnicode(0xA0u);
 	static float sqrt05 = hsqrt(0.5f);
 
+	static inline int _utf8CharSize(char c)
+	{
+		unsigned char value = (unsigned char)c;
+		if (value < 0xC0)
+		{
+			return 1; // also covers invalid continuation bytes and the terminating zero
+		}
+		if (value < 0xE0)
+		{
+			return 2;
+		}
+		if (value < 0xF0)
+		{
+			return 3;
+		}
+		return 4;
+	}
+
+	/// @brief Finds the first byte that is not ASCII, starting at the given index.
+	/// @return The index of the byte or size if all remaining bytes are ASCII.
+	static inline int _findNonAsciiByte(const char* str, int index, int size)
+	{
+#if defined(_ATRES_SSE2)
+		while (index + 16 <= size)
+		{
+			int mask = _mm_movemask_epi8(_mm_loadu_si128((const __m128i*)(str + index)));
+			if (mask != 0)
+			{
+				while ((mask & 1) == 0)
+				{
+					mask >>= 1;
+					++index;
+				}
+				return index;
+			}
+			index += 16;
+		}
+#elif defined(_ATRES_NEON)
+		while (index + 16 <= size)
+		{
+			if (vmaxvq_u8(vld1q_u8((const uint8_t*)(str + index))) >= 0x80)
+			{
+				break;
+			}
+			index += 16;
+		}
+#endif
+		while (index < size && (unsigned char)str[index] < 0x80)
+		{
+			++index;
+		}
+		return index;
+	}
+
+	/// @brief Decodes a character and avoids full UTF-8 decoding for ASCII characters.
+	static inline unsigned int _decodeChar(chstr text, const char* str, int index, int* byteSize)
+	{
+		if ((unsigned char)str[index] < 0x80)
+		{
+			*byteSize = 1;
+			return (unsigned char)str[index];
+		}
+		return text.firstUnicodeChar(index, byteSize);
+	}
+
+	/// @brief Line-break classes based on UAX #14.
+	/// @note Classes that are irrelevant within words are resolved beforehand: H2, H3 and JL to ID, JV and JT to CM, HL to AL, AI, SG,
+	/// XX and CJ to AL and NS. Spaces and newlines are handled separately.
+	/// @note No dictionary is used for SA (Thai, Lao, Myanmar, Khmer), so SA behaves like AL towards other classes but allows breaks
+	/// between clusters. Combining marks are resolved to CM and Thai and Lao leading vowels to BB, so clusters are never split.
+	enum LineBreakClass
+	{
+		LINE_BREAK_OP = 0, LINE_BREAK_CL, LINE_BREAK_CP, LINE_BREAK_QU, LINE_BREAK_GL, LINE_BREAK_NS, LINE_BREAK_EX, LINE_BREAK_SY,
+		LINE_BREAK_IS, LINE_BREAK_PR, LINE_BREAK_PO, LINE_BREAK_NU, LINE_BREAK_AL, LINE_BREAK_ID, LINE_BREAK_IN, LINE_BREAK_HY,
+		LINE_BREAK_BA, LINE_BREAK_BB, LINE_BREAK_B2, LINE_BREAK_ZW, LINE_BREAK_CM, LINE_BREAK_WJ, LINE_BREAK_SA, LINE_BREAK_COUNT
+	};
+
+	struct LineBreakRange
+	{
+		unsigned int first;
+		unsigned int last;
+		unsigned char lineBreakClass;
+	};
+
+	// first stage, ASCII characters are indexed directly
+	static const unsigned char _asciiLineBreakClasses[128] =
+	{
+		LINE_BREAK_CM, LINE_BREAK_CM, LINE_BREAK_CM, LINE_BREAK_CM, LINE_BREAK_CM, LINE_BREAK_CM, LINE_BREAK_CM, LINE_BREAK_CM,
+		LINE_BREAK_CM, LINE_BREAK_BA, LINE_BREAK_CM, LINE_BREAK_CM, LINE_BREAK_CM, LINE_BREAK_CM, LINE_BREAK_CM, LINE_BREAK_CM,
+		LINE_BREAK_CM, LINE_BREAK_CM, LINE_BREAK_CM, LINE_BREAK_CM, LINE_BREAK_CM, LINE_BREAK_CM, LINE_BREAK_CM, LINE_BREAK_CM,
+		LINE_BREAK_CM, LINE_BREAK_CM, LINE_BREAK_CM, LINE_BREAK_CM, LINE_BREAK_CM, LINE_BREAK_CM, LINE_BREAK_CM, LINE_BREAK_CM,
+		LINE_BREAK_WJ, LINE_BREAK_EX, LINE_BREAK_QU, LINE_BREAK_AL, LINE_BREAK_PR, LINE_BREAK_PO, LINE_BREAK_AL, LINE_BREAK_QU,
+		LINE_BREAK_OP, LINE_BREAK_CP, LINE_BREAK_AL, LINE_BREAK_PR, LINE_BREAK_IS, LINE_BREAK_HY, LINE_BREAK_IS, LINE_BREAK_SY,
+		LINE_BREAK_NU, LINE_BREAK_NU, LINE_BREAK_NU, LINE_BREAK_NU, LINE_BREAK_NU, LINE_BREAK_NU, LINE_BREAK_NU, LINE_BREAK_NU,
+		LINE_BREAK_NU, LINE_BREAK_NU, LINE_BREAK_IS, LINE_BREAK_IS, LINE_BREAK_AL, LINE_BREAK_AL, LINE_BREAK_AL, LINE_BREAK_EX,
+		LINE_BREAK_AL, LINE_BREAK_AL, LINE_BREAK_AL, LINE_BREAK_AL, LINE_BREAK_AL, LINE_BREAK_AL, LINE_BREAK_AL, LINE_BREAK_AL,
+		LINE_BREAK_AL, LINE_BREAK_AL, LINE_BREAK_AL, LINE_BREAK_AL, LINE_BREAK_AL, LINE_BREAK_AL, LINE_BREAK_AL, LINE_BREAK_AL,
+		LINE_BREAK_AL, LINE_BREAK_AL, LINE_BREAK_AL, LINE_BREAK_AL, LINE_BREAK_AL, LINE_BREAK_AL, LINE_BREAK_AL, LINE_BREAK_AL,
+		LINE_BREAK_AL, LINE_BREAK_AL, LINE_BREAK_AL, LINE_BREAK_OP, LINE_BREAK_PR, LINE_BREAK_CP, LINE_BREAK_AL, LINE_BREAK_AL,
+		LINE_BREAK_AL, LINE_BREAK_AL, LINE_BREAK_AL, LINE_BREAK_AL, LINE_BREAK_AL, LINE_BREAK_AL, LINE_BREAK_AL, LINE_BREAK_AL,
+		LINE_BREAK_AL, LINE_BREAK_AL, LINE_BREAK_AL, LINE_BREAK_AL, LINE_BREAK_AL, LINE_BREAK_AL, LINE_BREAK_AL, LINE_BREAK_AL,
+		LINE_BREAK_AL, LINE_BREAK_AL, LINE_BREAK_AL, LINE_BREAK_AL, LINE_BREAK_AL, LINE_BREAK_AL, LINE_BREAK_AL, LINE_BREAK_AL,
+		LINE_BREAK_AL, LINE_BREAK_AL, LINE_BREAK_AL, LINE_BREAK_OP, LINE_BREAK_BA, LINE_BREAK_CL, LINE_BREAK_AL, LINE_BREAK_CM,
+	};
+
+	// second stage, sorted ranges of all other characters that are not AL
+	static const LineBreakRange _lineBreakRanges[] =
+	{
+		{0x00A0, 0x00A0, LINE_BREAK_GL}, {0x00A1, 0x00A1, LINE_BREAK_OP}, {0x00A2, 0x00A2, LINE_BREAK_PO},
+		{0x00A3, 0x00A5, LINE_BREAK_PR}, {0x00AB, 0x00AB, LINE_BREAK_QU}, {0x00AD, 0x00AD, LINE_BREAK_BA},
+		{0x00B0, 0x00B0, LINE_BREAK_PO}, {0x00B1, 0x00B1, LINE_BREAK_PR}, {0x00B4, 0x00B4, LINE_BREAK_BB},
+		{0x00BB, 0x00BB, LINE_BREAK_QU}, {0x00BF, 0x00BF, LINE_BREAK_OP}, {0x0300, 0x036F, LINE_BREAK_CM},
+		{0x0483, 0x0489, LINE_BREAK_CM}, {0x0591, 0x05BD, LINE_BREAK_CM}, {0x0610, 0x061A, LINE_BREAK_CM},
+		{0x064B, 0x065F, LINE_BREAK_CM}, {0x0900, 0x0903, LINE_BREAK_CM}, {0x093A, 0x093C, LINE_BREAK_CM},
+		{0x093E, 0x094F, LINE_BREAK_CM}, {0x0964, 0x0964, LINE_BREAK_BA}, {0x0965, 0x0965, LINE_BREAK_BA},
+		{0x0E01, 0x0E30, LINE_BREAK_SA}, {0x0E31, 0x0E31, LINE_BREAK_CM}, {0x0E32, 0x0E33, LINE_BREAK_SA},
+		{0x0E34, 0x0E3A, LINE_BREAK_CM}, {0x0E3F, 0x0E3F, LINE_BREAK_PR}, {0x0E40, 0x0E44, LINE_BREAK_BB},
+		{0x0E45, 0x0E46, LINE_BREAK_SA}, {0x0E47, 0x0E4E, LINE_BREAK_CM}, {0x0E4F, 0x0E4F, LINE_BREAK_AL},
+		{0x0E50, 0x0E59, LINE_BREAK_NU}, {0x0E5A, 0x0E5B, LINE_BREAK_BA}, {0x0E81, 0x0EB0, LINE_BREAK_SA},
+		{0x0EB1, 0x0EB1, LINE_BREAK_CM}, {0x0EB2, 0x0EB3, LINE_BREAK_SA}, {0x0EB4, 0x0EBC, LINE_BREAK_CM},
+		{0x0EBD, 0x0EBF, LINE_BREAK_SA}, {0x0EC0, 0x0EC4, LINE_BREAK_BB}, {0x0EC5, 0x0EC6, LINE_BREAK_SA},
+		{0x0EC8, 0x0ECD, LINE_BREAK_CM}, {0x0ED0, 0x0ED9, LINE_BREAK_NU}, {0x0F0B, 0x0F0B, LINE_BREAK_BA},
+		{0x1000, 0x102A, LINE_BREAK_SA}, {0x102B, 0x103E, LINE_BREAK_CM}, {0x103F, 0x103F, LINE_BREAK_SA},
+		{0x1040, 0x1049, LINE_BREAK_NU}, {0x104A, 0x104B, LINE_BREAK_BA}, {0x1050, 0x1055, LINE_BREAK_SA},
+		{0x1056, 0x1059, LINE_BREAK_CM}, {0x1100, 0x115F, LINE_BREAK_ID}, {0x1160, 0x11FF, LINE_BREAK_CM},
+		{0x1780, 0x17B3, LINE_BREAK_SA}, {0x17B4, 0x17D3, LINE_BREAK_CM}, {0x17D4, 0x17D5, LINE_BREAK_BA},
+		{0x17D6, 0x17D6, LINE_BREAK_NS}, {0x17D7, 0x17D7, LINE_BREAK_SA}, {0x17D8, 0x17D8, LINE_BREAK_BA},
+		{0x17D9, 0x17D9, LINE_BREAK_AL}, {0x17DA, 0x17DA, LINE_BREAK_BA}, {0x17DB, 0x17DB, LINE_BREAK_PR},
+		{0x17DC, 0x17DC, LINE_BREAK_SA}, {0x17DD, 0x17DD, LINE_BREAK_CM},
+		{0x17E0, 0x17E9, LINE_BREAK_NU}, {0x1AB0, 0x1AFF, LINE_BREAK_CM}, {0x1DC0, 0x1DFF, LINE_BREAK_CM},
+		{0x2000, 0x2006, LINE_BREAK_BA}, {0x2007, 0x2007, LINE_BREAK_GL}, {0x2008, 0x200A, LINE_BREAK_BA},
+		{0x200B, 0x200B, LINE_BREAK_ZW}, {0x200C, 0x200D, LINE_BREAK_CM}, {0x2010, 0x2010, LINE_BREAK_BA},
+		{0x2011, 0x2011, LINE_BREAK_GL}, {0x2012, 0x2013, LINE_BREAK_BA}, {0x2014, 0x2014, LINE_BREAK_B2},
+		{0x2018, 0x2019, LINE_BREAK_QU}, {0x201A, 0x201A, LINE_BREAK_OP}, {0x201B, 0x201D, LINE_BREAK_QU},
+		{0x201E, 0x201E, LINE_BREAK_OP}, {0x201F, 0x201F, LINE_BREAK_QU}, {0x2024, 0x2026, LINE_BREAK_IN},
+		{0x2027, 0x2027, LINE_BREAK_BA}, {0x202F, 0x202F, LINE_BREAK_GL}, {0x2030, 0x2037, LINE_BREAK_PO},
+		{0x2039, 0x203A, LINE_BREAK_QU}, {0x203C, 0x203D, LINE_BREAK_NS}, {0x2044, 0x2044, LINE_BREAK_IS},
+		{0x2045, 0x2045, LINE_BREAK_OP}, {0x2046, 0x2046, LINE_BREAK_CL}, {0x2047, 0x2049, LINE_BREAK_NS},
+		{0x2060, 0x2060, LINE_BREAK_WJ}, {0x20A0, 0x20CF, LINE_BREAK_PR}, {0x20D0, 0x20FF, LINE_BREAK_CM},
+		{0x2E80, 0x2FFF, LINE_BREAK_ID}, {0x3000, 0x3000, LINE_BREAK_BA}, {0x3001, 0x3002, LINE_BREAK_CL},
+		{0x3003, 0x3004, LINE_BREAK_ID}, {0x3005, 0x3005, LINE_BREAK_NS}, {0x3006, 0x3007, LINE_BREAK_ID},
+		{0x3008, 0x3008, LINE_BREAK_OP}, {0x3009, 0x3009, LINE_BREAK_CL}, {0x300A, 0x300A, LINE_BREAK_OP},
+		{0x300B, 0x300B, LINE_BREAK_CL}, {0x300C, 0x300C, LINE_BREAK_OP}, {0x300D, 0x300D, LINE_BREAK_CL},
+		{0x300E, 0x300E, LINE_BREAK_OP}, {0x300F, 0x300F, LINE_BREAK_CL}, {0x3010, 0x3010, LINE_BREAK_OP},
+		{0x3011, 0x3011, LINE_BREAK_CL}, {0x3012, 0x3013, LINE_BREAK_ID}, {0x3014, 0x3014, LINE_BREAK_OP},
+		{0x3015, 0x3015, LINE_BREAK_CL}, {0x3016, 0x3016, LINE_BREAK_OP}, {0x3017, 0x3017, LINE_BREAK_CL},
+		{0x3018, 0x3018, LINE_BREAK_OP}, {0x3019, 0x3019, LINE_BREAK_CL}, {0x301A, 0x301A, LINE_BREAK_OP},
+		{0x301B, 0x301B, LINE_BREAK_CL}, {0x301C, 0x301C, LINE_BREAK_NS}, {0x301D, 0x301D, LINE_BREAK_OP},
+		{0x301E, 0x301F, LINE_BREAK_CL}, {0x3020, 0x3029, LINE_BREAK_ID}, {0x302A, 0x302F, LINE_BREAK_CM},
+		{0x3030, 0x303A, LINE_BREAK_ID}, {0x303B, 0x303B, LINE_BREAK_NS}, {0x303C, 0x303F, LINE_BREAK_ID},
+		{0x3040, 0x3040, LINE_BREAK_ID}, {0x3041, 0x3041, LINE_BREAK_NS}, {0x3042, 0x3042, LINE_BREAK_ID},
+		{0x3043, 0x3043, LINE_BREAK_NS}, {0x3044, 0x3044, LINE_BREAK_ID}, {0x3045, 0x3045, LINE_BREAK_NS},
+		{0x3046, 0x3046, LINE_BREAK_ID}, {0x3047, 0x3047, LINE_BREAK_NS}, {0x3048, 0x3048, LINE_BREAK_ID},
+		{0x3049, 0x3049, LINE_BREAK_NS}, {0x304A, 0x3062, LINE_BREAK_ID}, {0x3063, 0x3063, LINE_BREAK_NS},
+		{0x3064, 0x3082, LINE_BREAK_ID}, {0x3083, 0x3083, LINE_BREAK_NS}, {0x3084, 0x3084, LINE_BREAK_ID},
+		{0x3085, 0x3085, LINE_BREAK_NS}, {0x3086, 0x3086, LINE_BREAK_ID}, {0x3087, 0x3087, LINE_BREAK_NS},
+		{0x3088, 0x308D, LINE_BREAK_ID}, {0x308E, 0x308E, LINE_BREAK_NS}, {0x308F, 0x3094, LINE_BREAK_ID},
+		{0x3095, 0x3096, LINE_BREAK_NS}, {0x3097, 0x3098, LINE_BREAK_ID}, {0x3099, 0x309A, LINE_BREAK_CM},
+		{0x309B, 0x309E, LINE_BREAK_NS}, {0x309F, 0x309F, LINE_BREAK_ID}, {0x30A0, 0x30A0, LINE_BREAK_NS},
+		{0x30A1, 0x30A1, LINE_BREAK_NS}, {0x30A2, 0x30A2, LINE_BREAK_ID}, {0x30A3, 0x30A3, LINE_BREAK_NS},
+		{0x30A4, 0x30A4, LINE_BREAK_ID}, {0x30A5, 0x30A5, LINE_BREAK_NS}, {0x30A6, 0x30A6, LINE_BREAK_ID},
+		{0x30A7, 0x30A7, LINE_BREAK_NS}, {0x30A8, 0x30A8, LINE_BREAK_ID}, {0x30A9, 0x30A9, LINE_BREAK_NS},
+		{0x30AA, 0x30C2, LINE_BREAK_ID}, {0x30C3, 0x30C3, LINE_BREAK_NS}, {0x30C4, 0x30E2, LINE_BREAK_ID},
+		{0x30E3, 0x30E3, LINE_BREAK_NS}, {0x30E4, 0x30E4, LINE_BREAK_ID}, {0x30E5, 0x30E5, LINE_BREAK_NS},
+		{0x30E6, 0x30E6, LINE_BREAK_ID}, {0x30E7, 0x30E7, LINE_BREAK_NS}, {0x30E8, 0x30ED, LINE_BREAK_ID},
+		{0x30EE, 0x30EE, LINE_BREAK_NS}, {0x30EF, 0x30F4, LINE_BREAK_ID}, {0x30F5, 0x30F6, LINE_BREAK_NS},
+		{0x30F7, 0x30FA, LINE_BREAK_ID}, {0x30FB, 0x30FE, LINE_BREAK_NS}, {0x30FF, 0x30FF, LINE_BREAK_ID},
+		{0x3100, 0x31EF, LINE_BREAK_ID}, {0x31F0, 0x31FF, LINE_BREAK_NS}, {0x3200, 0x4DBF, LINE_BREAK_ID},
+		{0x4DC0, 0x4DFF, LINE_BREAK_AL}, {0x4E00, 0x9FFF, LINE_BREAK_ID}, {0xA000, 0xA4CF, LINE_BREAK_ID},
+		{0xAC00, 0xD7A3, LINE_BREAK_ID}, {0xF900, 0xFAFF, LINE_BREAK_ID}, {0xFE00, 0xFE0F, LINE_BREAK_CM},
+		{0xFE10, 0xFE10, LINE_BREAK_IS}, {0xFE11, 0xFE12, LINE_BREAK_CL}, {0xFE13, 0xFE14, LINE_BREAK_IS},
+		{0xFE15, 0xFE16, LINE_BREAK_EX}, {0xFE17, 0xFE17, LINE_BREAK_OP}, {0xFE18, 0xFE18, LINE_BREAK_CL},
+		{0xFE19, 0xFE19, LINE_BREAK_IN}, {0xFE20, 0xFE2F, LINE_BREAK_CM}, {0xFE30, 0xFE4F, LINE_BREAK_ID},
+		{0xFEFF, 0xFEFF, LINE_BREAK_WJ}, {0xFF01, 0xFF01, LINE_BREAK_EX}, {0xFF02, 0xFF03, LINE_BREAK_ID},
+		{0xFF04, 0xFF04, LINE_BREAK_PR}, {0xFF05, 0xFF05, LINE_BREAK_PO}, {0xFF06, 0xFF07, LINE_BREAK_ID},
+		{0xFF08, 0xFF08, LINE_BREAK_OP}, {0xFF09, 0xFF09, LINE_BREAK_CL}, {0xFF0A, 0xFF0B, LINE_BREAK_ID},
+		{0xFF0C, 0xFF0C, LINE_BREAK_CL}, {0xFF0D, 0xFF0D, LINE_BREAK_ID}, {0xFF0E, 0xFF0E, LINE_BREAK_CL},
+		{0xFF0F, 0xFF19, LINE_BREAK_ID}, {0xFF1A, 0xFF1A, LINE_BREAK_NS}, {0xFF1B, 0xFF1B, LINE_BREAK_NS},
+		{0xFF1C, 0xFF1E, LINE_BREAK_ID}, {0xFF1F, 0xFF1F, LINE_BREAK_EX}, {0xFF20, 0xFF3A, LINE_BREAK_ID},
+		{0xFF3B, 0xFF3B, LINE_BREAK_OP}, {0xFF3C, 0xFF3C, LINE_BREAK_ID}, {0xFF3D, 0xFF3D, LINE_BREAK_CL},
+		{0xFF3E, 0xFF5A, LINE_BREAK_ID}, {0xFF5B, 0xFF5B, LINE_BREAK_OP}, {0xFF5C, 0xFF5C, LINE_BREAK_ID},
+		{0xFF5D, 0xFF5D, LINE_BREAK_CL}, {0xFF5E, 0xFF5E, LINE_BREAK_ID}, {0xFF5F, 0xFF5F, LINE_BREAK_OP},
+		{0xFF60, 0xFF60, LINE_BREAK_CL}, {0xFF61, 0xFF61, LINE_BREAK_CL}, {0xFF62, 0xFF62, LINE_BREAK_OP},
+		{0xFF63, 0xFF63, LINE_BREAK_CL}, {0xFF64, 0xFF64, LINE_BREAK_CL}, {0xFF65, 0xFF65, LINE_BREAK_NS},
+		{0xFF66, 0xFF66, LINE_BREAK_AL}, {0xFF67, 0xFF70, LINE_BREAK_NS}, {0xFF71, 0xFF9D, LINE_BREAK_AL},
+		{0xFF9E, 0xFF9F, LINE_BREAK_NS}, {0xFFE0, 0xFFE0, LINE_BREAK_PO}, {0xFFE1, 0xFFE1, LINE_BREAK_PR},
+		{0xFFE2, 0xFFE4, LINE_BREAK_ID}, {0xFFE5, 0xFFE6, LINE_BREAK_PR}, {0x1F000, 0x1FAFF, LINE_BREAK_ID},
+		{0x20000, 0x2FFFD, LINE_BREAK_ID}, {0x30000, 0x3FFFD, LINE_BREAK_ID}, {0xE0100, 0xE01EF, LINE_BREAK_CM},
+	};
+
+	// 1 where a break is allowed directly between two characters (before class in rows, after class in columns)
+	static const unsigned char _lineBreakPairs[LINE_BREAK_COUNT][LINE_BREAK_COUNT] =
+	{
+		{0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}, // OP
+		{1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 0, 0, 1, 1, 0, 0, 0, 1}, // CL
+		{1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 0, 0}, // CP
+		{0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}, // QU
+		{0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}, // GL
+		{1, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 0, 0, 1, 1, 0, 0, 0, 1}, // NS
+		{1, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 0, 0, 0, 1, 1, 0, 0, 0, 1}, // EX
+		{1, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 0, 1, 1, 1, 0, 0, 1, 1, 0, 0, 0, 1}, // SY
+		{1, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 0, 0}, // IS
+		{0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 0, 0, 0, 1, 0, 0, 1, 1, 0, 0, 0, 0}, // PR
+		{0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 0, 0}, // PO
+		{0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 1, 1, 0, 0, 0, 0}, // NU
+		{0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 1, 1, 0, 0, 0, 0}, // AL
+		{1, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 1, 1, 1, 0, 0, 0, 1, 1, 0, 0, 0, 1}, // ID
+		{1, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 0, 0, 0, 1, 1, 0, 0, 0, 1}, // IN
+		{1, 0, 0, 0, 1, 0, 0, 0, 0, 1, 1, 0, 1, 1, 1, 0, 0, 1, 1, 0, 0, 0, 1}, // HY
+		{1, 0, 0, 0, 1, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 0, 0, 1, 1, 0, 0, 0, 1}, // BA
+		{0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}, // BB
+		{1, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 0, 0, 1, 0, 0, 0, 0, 1}, // B2
+		{1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 1, 1, 1}, // ZW
+		{0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 1, 1, 0, 0, 0, 0}, // CM
+		{0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}, // WJ
+		{0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 1, 1, 0, 0, 0, 1}, // SA
+	};
+
+	static inline int _getWordEnd(const RenderWord& word)
+	{
+		// icons are represented by a placeholder character in the unformatted text
+		return (word.start + (!word.icon ? word.count : _iconPlaceholder.size()));
+	}
+
+	static inline bool _hasFontChanges(const harray<FormatTag>& tags)
+	{
+		// by convention, the first tag is the font name
+		for_iter (i, 1, tags.size())
+		{
+			if (tags[i].type == FormatTag::Type::Font)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/// @brief Checks for signs that stack the following consonant below the previous one (Myanmar virama, Khmer coeng).
+	static inline bool _isStackingSign(unsigned int code)
+	{
+		return (code == 0x1039u || code == 0x17D2u);
+	}
+
+	static inline unsigned char _getLineBreakClass(unsigned int code)
+	{
+		if (code < 128)
+		{
+			return _asciiLineBreakClasses[code];
+		}
+		int minIndex = 0;
+		int maxIndex = (int)(sizeof(_lineBreakRanges) / sizeof(LineBreakRange)) - 1;
+		int index = 0;
+		while (minIndex <= maxIndex)
+		{
+			index = (minIndex + maxIndex) / 2;
+			if (code < _lineBreakRanges[index].first)
+			{
+				maxIndex = index - 1;
+			}
+			else if (code > _lineBreakRanges[index].last)
+			{
+				minIndex = index + 1;
+			}
+			else
+			{
+				return _lineBreakRanges[index].lineBreakClass;
+			}
+		}
+		return LINE_BREAK_AL;
+	}
+
+	/// @brief Shared state of a batched layout.
+	class LayoutBatch
+	{
+	public:
+		Renderer* renderer;
+		const harray<LayoutRequest>* requests;
+		harray<LayoutResult>* results;
+		harray<int> indices;
+		harray<hstr> texts;
+		harray<harray<FormatTag> > tags;
+		int next;
+		hmutex mutex;
+
+		LayoutBatch() : renderer(NULL), requests(NULL), results(NULL), next(0)
+		{
+		}
+
+		// takes requests until there are none left
+		void process(LayoutContext& context)
+		{
+			int index = 0;
+			int size = this->indices.size();
+			while (true)
+			{
+				this->mutex.lock();
+				index = this->next;
+				++this->next;
+				this->mutex.unlock();
+				if (index >= size)
+				{
+					break;
+				}
+				const LayoutRequest& request = (*this->requests)[this->indices[index]];
+				this->renderer->createRenderLines(context, request.rect, this->texts[index], this->tags[index],
+					request.horizontal, request.vertical, request.offset).swap((*this->results)[this->indices[index]].lines);
+			}
+		}
+
+	};
+
+	/// @brief Persistent worker thread of batched layouts with its own layout context.
+	class LayoutWorker : public hthread
+	{
+	public:
+		LayoutWorker() : hthread(&LayoutWorker::_execute, "atres layout"), batch(NULL), busy(false)
+		{
+		}
+
+		// hands a batch over to the worker without waiting
+		void assign(LayoutBatch* batch)
+		{
+			hmutex::ScopeLock lock(&this->mutex);
+			this->batch = batch;
+		}
+
+		// waits until the worker finished its part of the batch or takes the batch back if the worker didn't start yet
+		void finish()
+		{
+			while (true)
+			{
+				this->mutex.lock();
+				if (!this->busy)
+				{
+					this->batch = NULL;
+					this->mutex.unlock();
+					break;
+				}
+				this->mutex.unlock();
+				hthread::yield();
+			}
+		}
+
+	protected:
+		LayoutBatch* batch;
+		bool busy;
+		hmutex mutex;
+		LayoutContext context;
+
+		static void _execute(hthread* thread)
+		{
+			LayoutWorker* worker = (LayoutWorker*)thread;
+			LayoutBatch* batch = NULL;
+			int idleCount = 0;
+			while (worker->isRunning())
+			{
+				worker->mutex.lock();
+				batch = worker->batch;
+				worker->batch = NULL;
+				worker->busy = (batch != NULL);
+				worker->mutex.unlock();
+				if (batch != NULL)
+				{
+					batch->process(worker->context);
+					worker->mutex.lock();
+					worker->busy = false;
+					worker->mutex.unlock();
+					idleCount = 0;
+				}
+				else if (idleCount < LAYOUT_WORKER_SPIN_COUNT)
+				{
+					++idleCount;
+					hthread::yield();
+				}
+				else
+				{
+					hthread::sleep(1.0f);
+				}
+			}
+		}
+
+	};
+
 	Renderer* renderer = NULL;
 
-	Renderer::Renderer() :
+	LayoutContext::LayoutContext() :
 		_characters(_dummyCharacters),
 		_dummyCharacters(hmap<unsigned int, CharacterDefinition*>()),
 		_icons(_dummyIcons),
 		_dummyIcons(hmap<hstr, IconDefinition*>())
 	{
-		// init
-		this->shadowOffset.set(1.0f, 1.0f);
-		this->shadowColor = april::Color::Black;
-		this->borderThickness = 1.0f;
-		this->strikeThroughThickness = 2.0f;
-		this->underlineThickness = 2.0f;
-		this->borderColor = april::Color::Black;
-		this->globalOffsets = false;
-		this->useLegacyLineBreakParsing = false;
-		this->useIdeographWords = false;
-		this->justifiedDefault = Horizontal::Justified;
-		this->defaultFont = NULL;
-		// misc init
 		this->_font = NULL;
 		this->_iconFont = NULL;
 		this->_texture = NULL;
@@ -160,11 +529,41 @@ namespace atres
 		this->_alpha = -1;
 		this->_texture = NULL;
 		this->_code = 0;
+		this->_glyphIndex = 0;
+		this->_renderLine = NULL;
+		this->_renderWord = NULL;
+		for_iter (i, 0, 128)
+		{
+			this->_asciiCharacters[i] = NULL;
+		}
+	}
+
+	Renderer::Renderer()
+	{
+		// init
+		this->shadowOffset.set(1.0f, 1.0f);
+		this->shadowColor = april::Color::Black;
+		this->borderThickness = 1.0f;
+		this->strikeThroughThickness = 2.0f;
+		this->underlineThickness = 2.0f;
+		this->borderColor = april::Color::Black;
+		this->globalOffsets = false;
+		this->useLegacyLineBreakParsing = false;
+		this->useIdeographWords = false;
+		this->scaleInvariantLayout = false;
+		this->justifiedDefault = Horizontal::Justified;
+		this->defaultFont = NULL;
 		// cache
 		this->cacheText = new Cache<CacheEntryText>();
 		this->cacheTextUnformatted = new Cache<CacheEntryText>();
 		this->cacheLines = new Cache<CacheEntryLines>();
 		this->cacheLinesUnformatted = new Cache<CacheEntryLines>();
+		this->cacheLineBreaks = new Cache<CacheEntryLineBreaks>();
+		this->cacheLineBreaksUnformatted = new Cache<CacheEntryLineBreaks>();
+		this->cacheWords = new Cache<CacheEntryWords>();
+		this->cacheWordsUnformatted = new Cache<CacheEntryWords>();
+		this->cacheGeneration = 0;
+		this->formattedTextId = 0;
 	}
 
 	Renderer::~Renderer()
@@ -174,6 +573,15 @@ namespace atres
 		delete this->cacheTextUnformatted;
 		delete this->cacheLines;
 		delete this->cacheLinesUnformatted;
+		delete this->cacheLineBreaks;
+		delete this->cacheLineBreaksUnformatted;
+		delete this->cacheWords;
+		delete this->cacheWordsUnformatted;
+		foreach (LayoutWorker*, it, this->layoutWorkers)
+		{
+			(*it)->join();
+			delete (*it);
+		}
 	}
 
 	void Renderer::setShadowOffset(cgvec2f value)
@@ -248,6 +656,15 @@ namespace atres
 		}
 	}
 
+	void Renderer::setScaleInvariantLayout(bool value)
+	{
+		if (this->scaleInvariantLayout != value)
+		{
+			this->scaleInvariantLayout = value;
+			this->clearCache();
+		}
+	}
+
 	void Renderer::setJustifiedDefault(Horizontal value)
 	{
 		if (this->justifiedDefault != value)
@@ -288,6 +705,10 @@ namespace atres
 		this->cacheTextUnformatted->setMaxSize(value);
 		this->cacheLines->setMaxSize(value);
 		this->cacheLinesUnformatted->setMaxSize(value);
+		this->cacheLineBreaks->setMaxSize(value);
+		this->cacheLineBreaksUnformatted->setMaxSize(value);
+		this->cacheWords->setMaxSize(value);
+		this->cacheWordsUnformatted->setMaxSize(value);
 	}
 
 	bool Renderer::hasFont(chstr name) const
@@ -343,7 +764,7 @@ namespace atres
 		{
 			throw ResourceAlreadyExistsException("font", alias, "atres");
 		}
-		Font* font = this->getFont(name);
+		Font* font = this->resolveFont(name).font;
 		if (font != NULL)
 		{
 			hlog::writef(logTag, "Registering font alias '%s' for '%s'.", alias.cStr(), font->getName().cStr());
@@ -378,34 +799,65 @@ namespace atres
 	}
 
 	Font* Renderer::getFont(chstr name)
+	{
+		ResolvedFont result = this->resolveFont(name);
+		if (result.font != NULL)
+		{
+			result.font->setScale(result.scale);
+		}
+		return result.font;
+	}
+
+	ResolvedFont Renderer::resolveFont(chstr name)
+	{
+		hmutex::ScopeLock lock(&this->resolvedFontsMutex);
+		if (this->resolvedFonts.hasKey(name))
+		{
+			return this->resolvedFonts[name];
+		}
+		ResolvedFont result = this->_resolveFont(name);
+		if (result.font != NULL)
+		{
+			this->resolvedFonts[name] = result;
+		}
+		return result;
+	}
+
+	ResolvedFont Renderer::_resolveFont(chstr name)
 	{
 		if (name == "" && this->defaultFont != NULL)
 		{
-			this->defaultFont->setScale(1.0f);
-			return this->defaultFont;
+			return ResolvedFont(this->defaultFont, 1.0f);
 		}
-		Font* font = NULL;
 		if (this->fonts.hasKey(name))
 		{
-			font = this->fonts[name];
-			font->setScale(1.0f);
-			return font;
+			return ResolvedFont(this->fonts[name], 1.0f);
 		}
+		ResolvedFont result;
 		int position = (int)name.indexOf(":");
 		if (position >= 0)
 		{
-			font = this->getFont(name(0, position));
-			if (font != NULL)
+			result = this->_resolveFont(name(0, position));
+			if (result.font != NULL)
 			{
 				++position;
-				font->setScale((float)(name(position, name.size() - position)));
+				result.font = result.font->getScaledInstance((float)(name(position, name.size() - position)), result.scale);
 			}
 		}
-		return font;
+		return result;
 	}
 	
+	ResolvedFont Renderer::_resolveTagFont(const FormatTag& tag)
+	{
+		return (tag.resolved ? tag.font : this->resolveFont(tag.data));
+	}
+
 	void Renderer::clearCache()
 	{
+		++this->cacheGeneration;
+		this->resolvedFontsMutex.lock();
+		this->resolvedFonts.clear();
+		this->resolvedFontsMutex.unlock();
 		if (this->cacheText->getSize() > 0)
 		{
 			hlog::writef(logTag, "Clearing %d text cache entries...", this->cacheText->getSize());
@@ -426,49 +878,97 @@ namespace atres
 			hlog::writef(logTag, "Clearing %d unformatted lines cache entries...", this->cacheLinesUnformatted->getSize());
 			this->cacheLinesUnformatted->clear();
 		}
+		if (this->cacheLineBreaks->getSize() > 0)
+		{
+			hlog::writef(logTag, "Clearing %d line break cache entries...", this->cacheLineBreaks->getSize());
+			this->cacheLineBreaks->clear();
+		}
+		if (this->cacheLineBreaksUnformatted->getSize() > 0)
+		{
+			hlog::writef(logTag, "Clearing %d unformatted line break cache entries...", this->cacheLineBreaksUnformatted->getSize());
+			this->cacheLineBreaksUnformatted->clear();
+		}
+		if (this->cacheWords->getSize() > 0)
+		{
+			hlog::writef(logTag, "Clearing %d words cache entries...", this->cacheWords->getSize());
+			this->cacheWords->clear();
+		}
+		if (this->cacheWordsUnformatted->getSize() > 0)
+		{
+			hlog::writef(logTag, "Clearing %d unformatted words cache entries...", this->cacheWordsUnformatted->getSize());
+			this->cacheWordsUnformatted->clear();
+		}
 	}
 	
 	void Renderer::analyzeText(chstr fontName, chstr text)
 	{
 		// makes sure dynamically allocated characters are loaded
-		std::ustring chars = text.uStr();
-		Font* font = this->getFont(fontName);
+		Font* font = this->resolveFont(fontName).font;
 		if (font != NULL)
 		{
-			for_itert (unsigned int, i, 0, chars.size())
+			const char* str = text.cStr();
+			int size = text.size();
+			int index = 0;
+			int end = 0;
+			int byteSize = 0;
+			bool checked[128] = {false};
+			while (index < size)
 			{
-				font->hasCharacter(chars[i]);
+				// ASCII runs are checked byte by byte, every ASCII character only once
+				end = _findNonAsciiByte(str, index, size);
+				for_iter (i, index, end)
+				{
+					if (!checked[(unsigned char)str[i]])
+					{
+						checked[(unsigned char)str[i]] = true;
+						font->hasCharacter((unsigned char)str[i]);
+					}
+				}
+				if (end >= size)
+				{
+					break;
+				}
+				font->hasCharacter(text.firstUnicodeChar(end, &byteSize));
+				index = end + hmax(byteSize, 1);
 			}
 		}
 	}
 
 	hstr Renderer::analyzeFormatting(chstr text, harray<FormatTag>& tags)
 	{
-		std::ustring uText = text.uStr();
-		const unsigned int* str = uText.c_str();
+		const char* str = text.cStr();
+		int size = text.size();
 		int start = 0;
 		int end = 0;
+		int index = 0;
+		int offset = 0;
+		int dataStart = 0;
 		bool ignoreFormatting = false;
+		bool hasPreviousTag = false;
 		harray<char> stack;
 		FormatTag tag;
-		harray<FormatTag> foundTags;
-		// parse formatting in Unicode
+		hstr result;
+		result.reserve(size);
+		// single pass over the UTF-8 bytes, '[' and ']' can never be part of a multi-byte sequence
 		while (true)
 		{
-			start = (int)uText.find_first_of('[', start);
-			if (start < 0)
+			while (start < size && str[start] != '[')
 			{
-				break;
+				++start;
 			}
-			end = (int)uText.find_first_of(']', start);
-			if (end < 0)
+			end = start + 1;
+			while (end < size && str[end] != ']')
+			{
+				++end;
+			}
+			if (end >= size)
 			{
 				break;
 			}
 			++end;
 			tag.data = "";
-			tag.start = text.utf8SubString(0, start).size();
-			tag.count = text.utf8SubString(start, end - start).size();
+			tag.start = start;
+			tag.count = end - start;
 			if (ignoreFormatting)
 			{
 				if (str[start + 1] != '/' || str[start + 2] != '-')
@@ -478,14 +978,7 @@ namespace atres
 				}
 				ignoreFormatting = false;
 				stack.removeLast();
-				if (str[start + 2] != 'i')
-				{
-					tag.type = FormatTag::Type::Close;
-				}
-				else
-				{
-					tag.type = FormatTag::Type::CloseConsume;
-				}
+				tag.type = FormatTag::Type::Close;
 			}
 			else if (end - start == 2) // empty command
 			{
@@ -493,10 +986,10 @@ namespace atres
 			}
 			else if (str[start + 1] == '/') // closing command
 			{
-				if (stack.size() == 0 || (unsigned int)stack.last() != str[start + 2]) // interleaving, ignore the tag
+				if (stack.size() == 0 || stack.last() != str[start + 2]) // interleaving, ignore the tag
 				{
-					start = end;
 					hlog::warnf(logTag, "Closing tag that was not opened ('[/%c]' in '%s')!", str[start + 2], str);
+					start = end;
 					continue;
 				}
 				stack.removeLast();
@@ -555,55 +1048,84 @@ namespace atres
 					continue;
 				}
 				stack += str[start + 1];
-				if (end - start > 4)
+				// the data starts after the separator character which could be a multi-byte sequence
+				dataStart = start + 2 + _utf8CharSize(str[start + 2]);
+				if (dataStart < end - 1)
 				{
-					tag.data = text.utf8SubString(start + 3, end - start - 4);
+					tag.data = text(dataStart, end - 1 - dataStart);
 				}
 			}
-			foundTags += tag;
-			start = end;
-		}
-		// add closing tags where missing
-		hstr result;
-		int index = 0;
-		int count = 0;
-		bool hasPreviousTag = false;
-		foreach (FormatTag, it, foundTags)
-		{
-			if ((*it).type != FormatTag::Type::CloseConsume)
+			// copy the text before the tag right away
+			if (tag.type != FormatTag::Type::CloseConsume)
 			{
-				result += text(index, (*it).start - index);
+				result.append(str + index, start - index);
 			}
 			else if (hasPreviousTag)
 			{
-				tags.last().consumedData = text(index, (*it).start - index);
-				count += (*it).start - index;
+				tags.last().consumedData = text(index, start - index);
+				offset += start - index;
 				hasPreviousTag = false;
 			}
-			index = (*it).start + (*it).count;
-			if ((*it).type == FormatTag::Type::Escape)
+			index = end;
+			if (tag.type == FormatTag::Type::Escape)
 			{
-				--count;
+				--offset;
 				result += '[';
 			}
 			else
 			{
-				(*it).start -= count;
-				if ((*it).type == FormatTag::Type::Icon)
+				tag.start -= offset;
+				if (tag.type == FormatTag::Type::Icon)
 				{
 					hasPreviousTag = true;
 					// using a non-breaking space to indicate an icon being rendered here
-					count -= _iconPlaceholder.size();
+					offset -= _iconPlaceholder.size();
 					result += _iconPlaceholder;
 				}
-				tags += (*it);
+				tags += tag;
 			}
-			count += (*it).count;
+			offset += tag.count;
+			start = end;
 		}
-		count = text.size() - index;
-		if (count > 0)
+		if (index < size)
+		{
+			result.append(str + index, size - index);
+		}
+		return result;
+	}
+
+	FormattedText Renderer::makeFormattedText(chstr fontName, chstr text)
+	{
+		FormattedText result;
+		result.text = text;
+		result.fontName = fontName;
+		result.unformattedText = this->analyzeFormatting(text, result.tags);
+		result.textHash = CacheEntryBasicText::hashText(text);
+		this->formattedTextIdMutex.lock();
+		result.textId = ++this->formattedTextId;
+		this->formattedTextIdMutex.unlock();
+		result.font = this->resolveFont(fontName);
+		result.cacheGeneration = this->cacheGeneration;
+		hstr hex;
+		foreach (FormatTag, it, result.tags)
 		{
-			result += text(index, count);
+			if ((*it).type == FormatTag::Type::Font || (*it).type == FormatTag::Type::Icon)
+			{
+				(*it).font = this->resolveFont((*it).data);
+				(*it).resolved = ((*it).font.font != NULL);
+			}
+			else if ((*it).type == FormatTag::Type::Color)
+			{
+				if (!april::findSymbolicColor((*it).data.lowered(), hex))
+				{
+					hex = (*it).data;
+				}
+				if ((hex.size() == 6 || hex.size() == 8) && hex.isHex())
+				{
+					(*it).color.set(hex);
+					(*it).resolved = true;
+				}
+			}
 		}
 		return result;
 	}
@@ -758,823 +1280,892 @@ namespace atres
 		}
 	}
 
-	void Renderer::_initializeFormatTags(const harray<FormatTag>& tags)
+	void Renderer::_initializeFormatTags(LayoutContext& context, const harray<FormatTag>& tags)
 	{
-		this->_tags = tags;
-		this->_stack.clear();
-		this->_currentTag = FormatTag();
-		this->_nextTag = this->_tags.first();
-		this->_fontName = "";
-		this->_font = NULL;
-		this->_iconFont = NULL;
-		this->_texture = NULL;
-		this->_characters = this->_dummyCharacters;
-		this->_icons = this->_dummyIcons;
-		this->_character = NULL;
-		this->_borderCharacter = NULL;
-		this->_icon = NULL;
-		this->_borderIcon = NULL;
-		this->_height = 0.0f;
-		this->_lineHeight = 0.0f;
-		this->_descender = 0.0f;
-		this->_internalDescender = 0.0f;
-		this->_strikeThroughOffset = 0.0f;
-		this->_underlineOffset = 0.0f;
-		this->_italicSkewRatio = 0.3f;
-		this->_fontScale = 1.0f;
-		this->_fontBaseScale = 1.0f;
-		this->_iconFontScale = 1.0f;
-		this->_iconFontBearingX = 0.0f;
-		this->_iconFontOffsetY = 0.0f;
-		this->_textScale = 1.0f;
-		this->_scale = 1.0f;
-		this->_shadowOffset.set(1.0f, 1.0f);
-		this->_textShadowOffset.set(1.0f, 1.0f);
-		this->_borderThickness = 1.0f;
-		this->_borderFontThickness = 1.0f;
-		this->_textBorderThickness = 1.0f;
-		this->_strikeThroughActive = false;
-		this->_strikeThroughThickness = 1.0f;
-		this->_textStrikeThroughThickness = 1.0f;
-		this->_underlineActive = false;
-		this->_underlineThickness = 1.0f;
-		this->_textUnderlineThickness = 1.0f;
-		this->_italicActive = false;
-		this->_hideActive = false;
-		this->_code = 0;
+		context._tags = tags;
+		context._stack.clear();
+		context._currentTag = FormatTag();
+		context._nextTag = context._tags.first();
+		context._fontName = "";
+		context._font = NULL;
+		context._resolvedFont = ResolvedFont();
+		context._iconFont = NULL;
+		context._texture = NULL;
+		this->_setCharacters(context, context._dummyCharacters);
+		context._icons = context._dummyIcons;
+		context._character = NULL;
+		context._borderCharacter = NULL;
+		context._icon = NULL;
+		context._borderIcon = NULL;
+		context._height = 0.0f;
+		context._lineHeight = 0.0f;
+		context._descender = 0.0f;
+		context._internalDescender = 0.0f;
+		context._strikeThroughOffset = 0.0f;
+		context._underlineOffset = 0.0f;
+		context._italicSkewRatio = 0.3f;
+		context._fontScale = 1.0f;
+		context._fontBaseScale = 1.0f;
+		context._iconFontScale = 1.0f;
+		context._iconFontBearingX = 0.0f;
+		context._iconFontOffsetY = 0.0f;
+		context._textScale = 1.0f;
+		context._scale = 1.0f;
+		context._shadowOffset.set(1.0f, 1.0f);
+		context._textShadowOffset.set(1.0f, 1.0f);
+		context._borderThickness = 1.0f;
+		context._borderFontThickness = 1.0f;
+		context._textBorderThickness = 1.0f;
+		context._strikeThroughActive = false;
+		context._strikeThroughThickness = 1.0f;
+		context._textStrikeThroughThickness = 1.0f;
+		context._underlineActive = false;
+		context._underlineThickness = 1.0f;
+		context._textUnderlineThickness = 1.0f;
+		context._italicActive = false;
+		context._hideActive = false;
+		context._code = 0;
 	}
 
-	void Renderer::_initializeRenderSequences()
-	{
-		this->_textSequences.clear();
-		this->_textSequence = RenderSequence();
-		this->_shadowSequences.clear();
-		this->_shadowSequence = RenderSequence();
-		this->_borderSequences.clear();
-		this->_borderSequence = RenderSequence();
-		this->_renderRect = RenderRectangle();
-		this->_textLiningSequences.clear();
-		this->_textStrikeThroughSequence = RenderLiningSequence();
-		this->_textUnderlineSequence = RenderLiningSequence();
-		this->_shadowLiningSequences.clear();
-		this->_shadowStrikeThroughSequence = RenderLiningSequence();
-		this->_shadowStrikeThroughSequence.color = this->shadowColor;
-		this->_shadowUnderlineSequence = RenderLiningSequence();
-		this->_shadowUnderlineSequence.color = this->shadowColor;
-		this->_borderLiningSequences.clear();
-		this->_borderStrikeThroughSequence = RenderLiningSequence();
-		this->_borderStrikeThroughSequence.color = this->borderColor;
-		this->_borderUnderlineSequence = RenderLiningSequence();
-		this->_borderUnderlineSequence.color = this->borderColor;
-		this->_textColor = april::Color::White;
-		this->_shadowColor = this->shadowColor;
-		this->_borderColor = this->borderColor;
-		this->_strikeThroughColor = april::Color::White;
-		this->_underlineColor = april::Color::White;
-		this->_hex = "";
-		this->_effectMode = 0;
-		this->_strikeThroughActive = false;
-		this->_strikeThroughThickness = 1.0f;
-		this->_textStrikeThroughThickness = 1.0f;
-		this->_underlineActive = false;
-		this->_underlineThickness = 1.0f;
-		this->_textUnderlineThickness = 1.0f;
-		this->_italicActive = false;
-		this->_hideActive = false;
-		this->_alpha = -1;
+	void Renderer::_initializeRenderSequences(LayoutContext& context)
+	{
+		// the working sequences are cleared instead of recreated so their memory is reused by the next layout
+		context._textSequences.clear();
+		this->_resetRenderSequence(context._textSequence);
+		context._shadowSequences.clear();
+		this->_resetRenderSequence(context._shadowSequence);
+		context._borderSequences.clear();
+		this->_resetRenderSequence(context._borderSequence);
+		context._renderRect = RenderRectangle();
+		context._renderFonts.clear();
+		context._glyphIndex = 0;
+		context._textLiningSequences.clear();
+		this->_resetRenderLiningSequence(context._textStrikeThroughSequence, april::Color());
+		this->_resetRenderLiningSequence(context._textUnderlineSequence, april::Color());
+		context._shadowLiningSequences.clear();
+		this->_resetRenderLiningSequence(context._shadowStrikeThroughSequence, this->shadowColor);
+		this->_resetRenderLiningSequence(context._shadowUnderlineSequence, this->shadowColor);
+		context._borderLiningSequences.clear();
+		this->_resetRenderLiningSequence(context._borderStrikeThroughSequence, this->borderColor);
+		this->_resetRenderLiningSequence(context._borderUnderlineSequence, this->borderColor);
+		context._textColor = april::Color::White;
+		context._shadowColor = this->shadowColor;
+		context._borderColor = this->borderColor;
+		context._strikeThroughColor = april::Color::White;
+		context._underlineColor = april::Color::White;
+		context._hex = "";
+		context._effectMode = 0;
+		context._strikeThroughActive = false;
+		context._strikeThroughThickness = 1.0f;
+		context._textStrikeThroughThickness = 1.0f;
+		context._underlineActive = false;
+		context._underlineThickness = 1.0f;
+		context._textUnderlineThickness = 1.0f;
+		context._italicActive = false;
+		context._hideActive = false;
+		context._alpha = -1;
+	}
+
+	void Renderer::_resetRenderSequence(RenderSequence& sequence)
+	{
+		sequence.clear();
+		sequence.texture = NULL;
+		sequence.lastAlpha = 0;
+		sequence.multiplyAlpha = false;
+	}
+
+	void Renderer::_resetRenderLiningSequence(RenderLiningSequence& sequence, const april::Color& color)
+	{
+		sequence.clear();
+		sequence.color = color;
+	}
+
+	void Renderer::_setCharacters(LayoutContext& context, const hmap<unsigned int, CharacterDefinition*>& characters)
+	{
+		if (&characters != &context._characters)
+		{
+			context._characters = characters;
+		}
+		// ASCII characters are looked up directly without hashing
+		for_itert (unsigned int, i, 0, 128)
+		{
+			context._asciiCharacters[i] = context._characters.tryGet(i, NULL);
+		}
+	}
+
+	CharacterDefinition* Renderer::_findCharacter(LayoutContext& context, unsigned int code)
+	{
+		return (code < 128 ? context._asciiCharacters[code] : context._characters.tryGet(code, NULL));
 	}
 
-	void Renderer::_initializeLineProcessing(const harray<RenderLine>& lines)
+	void Renderer::_initializeLineProcessing(LayoutContext& context)
 	{
-		this->_lines = lines;
-		this->_line = RenderLine();
-		this->_word = RenderWord();
+		context._lines.clear();
+		context._line = RenderLine();
+		context._word = RenderWord();
+		context._renderLine = NULL;
+		context._renderWord = NULL;
 	}
 
-	void Renderer::_checkFormatTags(chstr text, int index)
+	void Renderer::_checkFormatTags(LayoutContext& context, chstr text, int index)
 	{
-		while (this->_tags.size() > 0 && index >= this->_nextTag.start)
+		while (context._tags.size() > 0 && index >= context._nextTag.start)
 		{
-			if (this->_nextTag.type == FormatTag::Type::Close || this->_nextTag.type == FormatTag::Type::CloseConsume)
+			if (context._nextTag.type == FormatTag::Type::Close || context._nextTag.type == FormatTag::Type::CloseConsume)
 			{
-				this->_currentTag = this->_stack.removeLast();
-				if (this->_currentTag.type == FormatTag::Type::Font)
+				context._currentTag = context._stack.removeLast();
+				if (context._currentTag.type == FormatTag::Type::Font)
 				{
-					this->_fontName = this->_currentTag.data;
-					this->_font = this->getFont(this->_fontName);
-					this->_characters = this->_font->getCharacters();
-					this->_icons = this->_font->getIcons();
-					this->_fontScale = this->_font->getScale();
-					this->_fontBaseScale = this->_font->getBaseScale();
+					context._fontName = context._currentTag.data;
+					context._resolvedFont = this->resolveFont(context._fontName);
+					context._font = context._resolvedFont.font;
+					this->_setCharacters(context, context._font->getCharacters());
+					context._icons = context._font->getIcons();
+					context._fontScale = context._resolvedFont.getScale();
+					context._fontBaseScale = context._font->getBaseScale();
 				}
-				else if (this->_currentTag.type == FormatTag::Type::Icon)
+				else if (context._currentTag.type == FormatTag::Type::Icon)
 				{
-					this->_fontName = this->_currentTag.data;
-					this->_font = this->getFont(this->_fontName);
-					this->_characters = this->_font->getCharacters();
-					this->_icons = this->_font->getIcons();
-					this->_fontScale = this->_font->getScale();
-					this->_fontBaseScale = this->_font->getBaseScale();
+					context._fontName = context._currentTag.data;
+					context._resolvedFont = this->resolveFont(context._fontName);
+					context._font = context._resolvedFont.font;
+					this->_setCharacters(context, context._font->getCharacters());
+					context._icons = context._font->getIcons();
+					context._fontScale = context._resolvedFont.getScale();
+					context._fontBaseScale = context._font->getBaseScale();
+					context._iconFont = NULL; // the icon was already laid out, unless all tags before a text range are caught up at once
 				}
-				else if (this->_currentTag.type == FormatTag::Type::Scale)
+				else if (context._currentTag.type == FormatTag::Type::Scale)
 				{
-					this->_textScale = this->_currentTag.data;
+					context._textScale = context._currentTag.data;
 				}
-				else if (this->_currentTag.type == FormatTag::Type::Italic)
+				else if (context._currentTag.type == FormatTag::Type::Italic)
 				{
-					this->_italicActive = false;
+					context._italicActive = false;
 				}
-				else if (this->_currentTag.type == FormatTag::Type::Hide)
+				else if (context._currentTag.type == FormatTag::Type::Hide)
 				{
-					this->_hideActive = false;
+					context._hideActive = false;
 				}
 			}
-			else if (this->_nextTag.type == FormatTag::Type::Font)
+			else if (context._nextTag.type == FormatTag::Type::Font)
 			{
-				this->_currentTag.type = FormatTag::Type::Font;
-				this->_currentTag.data = this->_fontName;
-				this->_stack += this->_currentTag;
-				if (this->_font == NULL) // if there is no previous font, some special values have to be obtained as well
+				context._currentTag.type = FormatTag::Type::Font;
+				context._currentTag.data = context._fontName;
+				context._stack += context._currentTag;
+				if (context._font == NULL) // if there is no previous font, some special values have to be obtained as well
 				{
-					this->_font = this->getFont(this->_nextTag.data);
-					if (this->_font != NULL)
+					context._resolvedFont = this->_resolveTagFont(context._nextTag);
+					context._font = context._resolvedFont.font;
+					if (context._font != NULL)
 					{
-						this->_height = this->_font->getHeight();
-						this->_lineHeight = this->_font->getLineHeight();
-						this->_descender = this->_font->getDescender();
-						this->_internalDescender = this->_font->getInternalDescender();
-						this->_strikeThroughOffset = this->_font->getStrikeThroughOffset();
-						this->_underlineOffset = this->_font->getUnderlineOffset();
-						this->_italicSkewRatio = this->_font->getItalicSkewRatio();
+						context._height = context._resolvedFont.getHeight();
+						context._lineHeight = context._resolvedFont.getLineHeight();
+						context._descender = context._resolvedFont.getDescender();
+						context._internalDescender = context._resolvedFont.getInternalDescender();
+						context._strikeThroughOffset = context._resolvedFont.getStrikeThroughOffset();
+						context._underlineOffset = context._resolvedFont.getUnderlineOffset();
+						context._italicSkewRatio = context._font->getItalicSkewRatio();
 					}
 				}
 				else
 				{
-					this->_font = this->getFont(this->_nextTag.data);
+					context._resolvedFont = this->_resolveTagFont(context._nextTag);
+					context._font = context._resolvedFont.font;
 				}
-				if (this->_font != NULL)
+				if (context._font != NULL)
 				{
-					this->_fontName = this->_nextTag.data;
-					this->_characters = this->_font->getCharacters();
-					this->_fontScale = this->_font->getScale();
-					this->_fontBaseScale = this->_font->getBaseScale();
+					context._fontName = context._nextTag.data;
+					this->_setCharacters(context, context._font->getCharacters());
+					context._fontScale = context._resolvedFont.getScale();
+					context._fontBaseScale = context._font->getBaseScale();
 				}
 				else
 				{
-					hlog::warnf(logTag, "Font '%s' does not exist!", this->_nextTag.data.cStr());
+					hlog::warnf(logTag, "Font '%s' does not exist!", context._nextTag.data.cStr());
 				}
 			}
-			else if (this->_nextTag.type == FormatTag::Type::Icon)
+			else if (context._nextTag.type == FormatTag::Type::Icon)
 			{
-				this->_currentTag.type = FormatTag::Type::Icon;
-				this->_currentTag.data = this->_fontName;
-				this->_currentTag.consumedData = this->_fontIconName;
-				this->_stack += this->_currentTag;
-				this->_iconFont = dynamic_cast<FontIconMap*>(this->getFont(this->_nextTag.data));
-				if (this->_iconFont != NULL)
+				context._currentTag.type = FormatTag::Type::Icon;
+				context._currentTag.data = context._fontName;
+				context._currentTag.consumedData = context._fontIconName;
+				context._stack += context._currentTag;
+				ResolvedFont iconFont = this->_resolveTagFont(context._nextTag);
+				context._iconFont = dynamic_cast<FontIconMap*>(iconFont.font);
+				if (context._iconFont != NULL)
 				{
-					if (this->_font == NULL) // if there is no previous font, some special values have to be obtained as well
+					if (context._font == NULL) // if there is no previous font, some special values have to be obtained as well
 					{
-						this->_height = this->_iconFont->getHeight();
-						this->_lineHeight = this->_iconFont->getLineHeight();
-						this->_descender = this->_iconFont->getDescender();
-						this->_internalDescender = this->_iconFont->getInternalDescender();
-						this->_strikeThroughOffset = this->_iconFont->getStrikeThroughOffset();
-						this->_underlineOffset = this->_iconFont->getUnderlineOffset();
-						this->_italicSkewRatio = this->_iconFont->getItalicSkewRatio();
+						context._height = iconFont.getHeight();
+						context._lineHeight = iconFont.getLineHeight();
+						context._descender = iconFont.getDescender();
+						context._internalDescender = iconFont.getInternalDescender();
+						context._strikeThroughOffset = iconFont.getStrikeThroughOffset();
+						context._underlineOffset = iconFont.getUnderlineOffset();
+						context._italicSkewRatio = context._iconFont->getItalicSkewRatio();
 					}
-					this->_fontName = this->_nextTag.data;
-					this->_fontIconName = this->_nextTag.consumedData;
-					this->_iconFont->hasIcon(this->_fontIconName);
-					this->_icons = this->_iconFont->getIcons();
-					this->_iconFontScale = this->_iconFont->getScale() * this->_fontScale / this->_fontBaseScale;
-					this->_iconFontBearingX = this->_iconFont->getBearingX();
-					this->_iconFontOffsetY = this->_iconFont->getOffsetY();
-					this->_iconFontCustomFontOffsets = this->_iconFont->getCustomFontOffsets();
+					context._fontName = context._nextTag.data;
+					context._fontIconName = context._nextTag.consumedData;
+					context._iconFont->hasIcon(context._fontIconName);
+					context._icons = context._iconFont->getIcons();
+					context._iconFontScale = iconFont.getScale() * context._fontScale / context._fontBaseScale;
+					context._iconFontBearingX = context._iconFont->getBearingX();
+					context._iconFontOffsetY = context._iconFont->getOffsetY();
+					context._iconFontCustomFontOffsets = context._iconFont->getCustomFontOffsets();
 				}
 				else
 				{
-					hlog::warnf(logTag, "Font '%s' does not exist!", this->_nextTag.data.cStr());
+					hlog::warnf(logTag, "Font '%s' does not exist!", context._nextTag.data.cStr());
 				}
 			}
-			else if (this->_nextTag.type == FormatTag::Type::Color)
+			else if (context._nextTag.type == FormatTag::Type::Color)
 			{
-				this->_currentTag.type = FormatTag::Type::Color;
-				this->_stack += this->_currentTag;
+				context._currentTag.type = FormatTag::Type::Color;
+				context._stack += context._currentTag;
 			}
-			else if (this->_nextTag.type == FormatTag::Type::Scale)
+			else if (context._nextTag.type == FormatTag::Type::Scale)
 			{
-				this->_currentTag.type = FormatTag::Type::Scale;
-				this->_currentTag.data = this->_textScale;
-				this->_stack += this->_currentTag;
-				this->_textScale = this->_nextTag.data;
+				context._currentTag.type = FormatTag::Type::Scale;
+				context._currentTag.data = context._textScale;
+				context._stack += context._currentTag;
+				context._textScale = context._nextTag.data;
 			}
-			else if (this->_nextTag.type == FormatTag::Type::Italic)
+			else if (context._nextTag.type == FormatTag::Type::Italic)
 			{
-				this->_currentTag.type = FormatTag::Type::Italic;
-				this->_stack += this->_currentTag;
-				this->_italicActive = true;
+				context._currentTag.type = FormatTag::Type::Italic;
+				context._stack += context._currentTag;
+				context._italicActive = true;
 			}
-			else if (this->_nextTag.type == FormatTag::Type::Hide)
+			else if (context._nextTag.type == FormatTag::Type::Hide)
 			{
-				this->_currentTag.type = FormatTag::Type::Hide;
-				this->_stack += this->_currentTag;
-				this->_hideActive = true;
+				context._currentTag.type = FormatTag::Type::Hide;
+				context._stack += context._currentTag;
+				context._hideActive = true;
 			}
 			else
 			{
-				this->_currentTag.type = FormatTag::Type::NoEffect;
-				this->_stack += this->_currentTag;
+				context._currentTag.type = FormatTag::Type::NoEffect;
+				context._stack += context._currentTag;
 			}
-			this->_tags.removeFirst();
-			if (this->_tags.size() > 0)
+			context._tags.removeFirst();
+			if (context._tags.size() > 0)
 			{
-				this->_nextTag = this->_tags.first();
+				context._nextTag = context._tags.first();
 			}
 			else
 			{
-				this->_nextTag.start = text.size() + 1;
+				context._nextTag.start = text.size() + 1;
 			}
 		}
 	}
 
-	void Renderer::_processFormatTags(chstr text, int index)
+	void Renderer::_processFormatTags(LayoutContext& context, chstr text, int index)
 	{
-		while (this->_tags.size() > 0 && this->_word.start + index >= this->_nextTag.start)
+		while (context._tags.size() > 0 && context._renderWord->start + index >= context._nextTag.start)
 		{
-			if (this->_nextTag.type == FormatTag::Type::Close || this->_nextTag.type == FormatTag::Type::CloseConsume)
+			if (context._nextTag.type == FormatTag::Type::Close || context._nextTag.type == FormatTag::Type::CloseConsume)
 			{
-				this->_currentTag = this->_stack.removeLast();
-				if (this->_currentTag.type == FormatTag::Type::Font)
+				context._currentTag = context._stack.removeLast();
+				if (context._currentTag.type == FormatTag::Type::Font)
 				{
-					this->_fontName = this->_currentTag.data;
-					this->_font = this->getFont(this->_fontName);
-					this->_characters = this->_font->getCharacters();
-					this->_icons = this->_font->getIcons();
-					this->_fontScale = this->_font->getScale();
-					this->_fontBaseScale = this->_font->getBaseScale();
+					context._fontName = context._currentTag.data;
+					context._resolvedFont = this->resolveFont(context._fontName);
+					context._font = context._resolvedFont.font;
+					this->_setCharacters(context, context._font->getCharacters());
+					context._icons = context._font->getIcons();
+					context._fontScale = context._resolvedFont.getScale();
+					context._fontBaseScale = context._font->getBaseScale();
 				}
-				else if (this->_currentTag.type == FormatTag::Type::Icon)
+				else if (context._currentTag.type == FormatTag::Type::Icon)
 				{
-					this->_fontName = this->_currentTag.data;
-					this->_fontIconName = this->_currentTag.consumedData;
-					this->_font = this->getFont(this->_fontName);
-					this->_characters = this->_font->getCharacters();
-					this->_icons = this->_font->getIcons();
-					this->_fontScale = this->_font->getScale();
-					this->_fontBaseScale = this->_font->getBaseScale();
-					this->_iconFont = NULL;
+					context._fontName = context._currentTag.data;
+					context._fontIconName = context._currentTag.consumedData;
+					context._resolvedFont = this->resolveFont(context._fontName);
+					context._font = context._resolvedFont.font;
+					this->_setCharacters(context, context._font->getCharacters());
+					context._icons = context._font->getIcons();
+					context._fontScale = context._resolvedFont.getScale();
+					context._fontBaseScale = context._font->getBaseScale();
+					context._iconFont = NULL;
 				}
-				else if (this->_currentTag.type == FormatTag::Type::Color)
+				else if (context._currentTag.type == FormatTag::Type::Color)
 				{
-					if (!april::findSymbolicColor(this->_currentTag.data.lowered(), this->_hex))
+					if (!april::findSymbolicColor(context._currentTag.data.lowered(), context._hex))
 					{
-						this->_hex = this->_currentTag.data;
+						context._hex = context._currentTag.data;
 					}
-					if ((this->_hex.size() == 6 || this->_hex.size() == 8) && this->_hex.isHex())
+					if ((context._hex.size() == 6 || context._hex.size() == 8) && context._hex.isHex())
 					{
-						if (this->_textColor == this->_strikeThroughColor)
+						if (context._textColor == context._strikeThroughColor)
 						{
-							this->_strikeThroughColor.set(this->_hex);
+							context._strikeThroughColor.set(context._hex);
 						}
-						if (this->_textColor == this->_underlineColor)
+						if (context._textColor == context._underlineColor)
 						{
-							this->_underlineColor.set(this->_hex);
+							context._underlineColor.set(context._hex);
 						}
-						this->_textColor.set(this->_hex);
+						context._textColor.set(context._hex);
 					}
 				}
-				else if (this->_currentTag.type == FormatTag::Type::Scale)
+				else if (context._currentTag.type == FormatTag::Type::Scale)
 				{
-					this->_textScale = this->_currentTag.data;
+					context._textScale = context._currentTag.data;
 				}
-				else if (this->_currentTag.type == FormatTag::Type::NoEffect)
+				else if (context._currentTag.type == FormatTag::Type::NoEffect)
 				{
-					this->_effectMode = EFFECT_MODE_NORMAL;
+					context._effectMode = EFFECT_MODE_NORMAL;
 				}
-				else if (this->_currentTag.type == FormatTag::Type::Shadow)
+				else if (context._currentTag.type == FormatTag::Type::Shadow)
 				{
-					this->_effectMode = EFFECT_MODE_SHADOW;
-					if (this->_currentTag.data.count(',') == 2)
+					context._effectMode = EFFECT_MODE_SHADOW;
+					if (context._currentTag.data.count(',') == 2)
 					{
-						this->_currentTag.data.split(',', this->_parameterString0, this->_parameterString1);
-						this->_textShadowOffset = april::hstrToGvec2<float>(this->_parameterString1);
+						context._currentTag.data.split(',', context._parameterString0, context._parameterString1);
+						context._textShadowOffset = april::hstrToGvec2<float>(context._parameterString1);
 					}
 					else
 					{
-						this->_parameterString0 = this->_currentTag.data;
+						context._parameterString0 = context._currentTag.data;
 					}
-					if (!april::findSymbolicColor(this->_parameterString0.lowered(), this->_hex))
+					if (!april::findSymbolicColor(context._parameterString0.lowered(), context._hex))
 					{
-						this->_hex = this->_parameterString0;
+						context._hex = context._parameterString0;
 					}
-					if ((this->_hex.size() == 6 || this->_hex.size() == 8) && this->_hex.isHex())
+					if ((context._hex.size() == 6 || context._hex.size() == 8) && context._hex.isHex())
 					{
-						this->_shadowColor.set(this->_hex);
+						context._shadowColor.set(context._hex);
 					}
 				}
-				else if (this->_currentTag.type == FormatTag::Type::Border)
+				else if (context._currentTag.type == FormatTag::Type::Border)
 				{
-					this->_effectMode = EFFECT_MODE_BORDER;
-					if (this->_currentTag.data.count(',') == 1)
+					context._effectMode = EFFECT_MODE_BORDER;
+					if (context._currentTag.data.count(',') == 1)
 					{
-						this->_currentTag.data.split(',', this->_parameterString0, this->_parameterString1);
-						this->_textBorderThickness = (float)this->_parameterString1;
+						context._currentTag.data.split(',', context._parameterString0, context._parameterString1);
+						context._textBorderThickness = (float)context._parameterString1;
 					}
 					else
 					{
-						this->_parameterString0 = this->_currentTag.data;
+						context._parameterString0 = context._currentTag.data;
 					}
-					if (!april::findSymbolicColor(this->_parameterString0.lowered(), this->_hex))
+					if (!april::findSymbolicColor(context._parameterString0.lowered(), context._hex))
 					{
-						this->_hex = this->_parameterString0;
+						context._hex = context._parameterString0;
 					}
-					if ((this->_hex.size() == 6 || this->_hex.size() == 8) && this->_hex.isHex())
+					if ((context._hex.size() == 6 || context._hex.size() == 8) && context._hex.isHex())
 					{
-						this->_borderColor.set(this->_hex);
+						context._borderColor.set(context._hex);
 					}
 				}
-				else if (this->_currentTag.type == FormatTag::Type::StrikeThrough)
+				else if (context._currentTag.type == FormatTag::Type::StrikeThrough)
 				{
-					this->_strikeThroughActive = false;
-					if (this->_currentTag.data.count(',') == 1)
+					context._strikeThroughActive = false;
+					if (context._currentTag.data.count(',') == 1)
 					{
-						this->_currentTag.data.split(',', this->_parameterString0, this->_parameterString1);
-						this->_textStrikeThroughThickness = (float)this->_parameterString1;
+						context._currentTag.data.split(',', context._parameterString0, context._parameterString1);
+						context._textStrikeThroughThickness = (float)context._parameterString1;
 					}
 					else
 					{
-						this->_parameterString0 = this->_currentTag.data;
+						context._parameterString0 = context._currentTag.data;
 					}
-					if (!april::findSymbolicColor(this->_parameterString0.lowered(), this->_hex))
+					if (!april::findSymbolicColor(context._parameterString0.lowered(), context._hex))
 					{
-						this->_hex = this->_parameterString0;
+						context._hex = context._parameterString0;
 					}
-					if ((this->_hex.size() == 6 || this->_hex.size() == 8) && this->_hex.isHex())
+					if ((context._hex.size() == 6 || context._hex.size() == 8) && context._hex.isHex())
 					{
-						this->_strikeThroughColor.set(this->_hex);
+						context._strikeThroughColor.set(context._hex);
 					}
 
 				}
-				else if (this->_currentTag.type == FormatTag::Type::Underline)
+				else if (context._currentTag.type == FormatTag::Type::Underline)
 				{
-					this->_underlineActive = false;
-					if (this->_currentTag.data.count(',') == 1)
+					context._underlineActive = false;
+					if (context._currentTag.data.count(',') == 1)
 					{
-						this->_currentTag.data.split(',', this->_parameterString0, this->_parameterString1);
-						this->_textUnderlineThickness = (float)this->_parameterString1;
+						context._currentTag.data.split(',', context._parameterString0, context._parameterString1);
+						context._textUnderlineThickness = (float)context._parameterString1;
 					}
 					else
 					{
-						this->_parameterString0 = this->_currentTag.data;
+						context._parameterString0 = context._currentTag.data;
 					}
-					if (!april::findSymbolicColor(this->_parameterString0.lowered(), this->_hex))
+					if (!april::findSymbolicColor(context._parameterString0.lowered(), context._hex))
 					{
-						this->_hex = this->_parameterString0;
+						context._hex = context._parameterString0;
 					}
-					if ((this->_hex.size() == 6 || this->_hex.size() == 8) && this->_hex.isHex())
+					if ((context._hex.size() == 6 || context._hex.size() == 8) && context._hex.isHex())
 					{
-						this->_underlineColor.set(this->_hex);
+						context._underlineColor.set(context._hex);
 					}
 				}
-				else if (this->_currentTag.type == FormatTag::Type::Italic)
+				else if (context._currentTag.type == FormatTag::Type::Italic)
 				{
-					this->_italicActive = false;
+					context._italicActive = false;
 				}
-				else if (this->_currentTag.type == FormatTag::Type::Hide)
+				else if (context._currentTag.type == FormatTag::Type::Hide)
 				{
-					this->_hideActive = false;
+					context._hideActive = false;
 				}
 			}
 			else
 			{
-				if (this->_nextTag.type == FormatTag::Type::Font)
+				if (context._nextTag.type == FormatTag::Type::Font)
 				{
-					this->_currentTag.type = this->_nextTag.type;
-					this->_currentTag.data = this->_fontName;
-					this->_stack += this->_currentTag;
-					if (this->_font == NULL) // if there is no previous font, some special values have to be obtained as well
+					context._currentTag.type = context._nextTag.type;
+					context._currentTag.data = context._fontName;
+					context._stack += context._currentTag;
+					if (context._font == NULL) // if there is no previous font, some special values have to be obtained as well
 					{
-						this->_font = this->getFont(this->_nextTag.data);
-						if (this->_font != NULL)
+						context._resolvedFont = this->_resolveTagFont(context._nextTag);
+						context._font = context._resolvedFont.font;
+						if (context._font != NULL)
 						{
-							this->_height = this->_font->getHeight();
-							this->_lineHeight = this->_font->getLineHeight();
-							this->_descender = this->_font->getDescender();
-							this->_internalDescender = this->_font->getInternalDescender();
-							this->_strikeThroughOffset = this->_font->getStrikeThroughOffset();
-							this->_underlineOffset = this->_font->getUnderlineOffset();
-							this->_italicSkewRatio = this->_font->getItalicSkewRatio();
+							context._height = context._resolvedFont.getHeight();
+							context._lineHeight = context._resolvedFont.getLineHeight();
+							context._descender = context._resolvedFont.getDescender();
+							context._internalDescender = context._resolvedFont.getInternalDescender();
+							context._strikeThroughOffset = context._resolvedFont.getStrikeThroughOffset();
+							context._underlineOffset = context._resolvedFont.getUnderlineOffset();
+							context._italicSkewRatio = context._font->getItalicSkewRatio();
 						}
 					}
 					else
 					{
-						this->_font = this->getFont(this->_nextTag.data);
+						context._resolvedFont = this->_resolveTagFont(context._nextTag);
+						context._font = context._resolvedFont.font;
 					}
-					if (this->_font != NULL)
+					if (context._font != NULL)
 					{
-						this->_fontName = this->_nextTag.data;
-						this->_characters = this->_font->getCharacters();
-						this->_fontScale = this->_font->getScale();
-						this->_fontBaseScale = this->_font->getBaseScale();
+						context._fontName = context._nextTag.data;
+						this->_setCharacters(context, context._font->getCharacters());
+						context._fontScale = context._resolvedFont.getScale();
+						context._fontBaseScale = context._font->getBaseScale();
 					}
 					else
 					{
-						hlog::warnf(logTag, "Font '%s' does not exist!", this->_nextTag.data.cStr());
+						hlog::warnf(logTag, "Font '%s' does not exist!", context._nextTag.data.cStr());
 					}
 				}
-				else if (this->_nextTag.type == FormatTag::Type::Icon)
+				else if (context._nextTag.type == FormatTag::Type::Icon)
 				{
-					this->_currentTag.type = FormatTag::Type::Icon;
-					this->_currentTag.data = this->_fontName;
-					this->_currentTag.consumedData = this->_fontIconName;
-					this->_stack += this->_currentTag;
-					this->_iconFont = dynamic_cast<FontIconMap*>(this->getFont(this->_nextTag.data));
-					if (this->_iconFont != NULL)
+					context._currentTag.type = FormatTag::Type::Icon;
+					context._currentTag.data = context._fontName;
+					context._currentTag.consumedData = context._fontIconName;
+					context._stack += context._currentTag;
+					ResolvedFont iconFont = this->_resolveTagFont(context._nextTag);
+					context._iconFont = dynamic_cast<FontIconMap*>(iconFont.font);
+					if (context._iconFont != NULL)
 					{
-						if (this->_font == NULL) // if there is no previous font, some special values have to be obtained as well
+						if (context._font == NULL) // if there is no previous font, some special values have to be obtained as well
 						{
-							this->_height = this->_iconFont->getHeight();
-							this->_lineHeight = this->_iconFont->getLineHeight();
-							this->_descender = this->_iconFont->getDescender();
-							this->_internalDescender = this->_iconFont->getInternalDescender();
-							this->_strikeThroughOffset = this->_font->getStrikeThroughOffset();
-							this->_underlineOffset = this->_font->getUnderlineOffset();
-							this->_italicSkewRatio = this->_font->getItalicSkewRatio();
+							context._height = iconFont.getHeight();
+							context._lineHeight = iconFont.getLineHeight();
+							context._descender = iconFont.getDescender();
+							context._internalDescender = iconFont.getInternalDescender();
+							context._strikeThroughOffset = iconFont.getStrikeThroughOffset();
+							context._underlineOffset = iconFont.getUnderlineOffset();
+							context._italicSkewRatio = context._iconFont->getItalicSkewRatio();
 						}
-						this->_fontName = this->_nextTag.data;
-						this->_fontIconName = this->_nextTag.consumedData;
-						this->_iconFont->hasIcon(this->_fontIconName);
-						this->_icons = this->_iconFont->getIcons();
-						this->_iconFontScale = this->_iconFont->getScale() * this->_fontScale / this->_fontBaseScale;
-						this->_iconFontBearingX = this->_iconFont->getBearingX();
-						this->_iconFontOffsetY = this->_iconFont->getOffsetY();
-						this->_iconFontCustomFontOffsets = this->_iconFont->getCustomFontOffsets();
+						context._fontName = context._nextTag.data;
+						context._fontIconName = context._nextTag.consumedData;
+						context._iconFont->hasIcon(context._fontIconName);
+						context._icons = context._iconFont->getIcons();
+						context._iconFontScale = iconFont.getScale() * context._fontScale / context._fontBaseScale;
+						context._iconFontBearingX = context._iconFont->getBearingX();
+						context._iconFontOffsetY = context._iconFont->getOffsetY();
+						context._iconFontCustomFontOffsets = context._iconFont->getCustomFontOffsets();
 					}
 					else
 					{
-						hlog::warnf(logTag, "Font '%s' does not exist!", this->_nextTag.data.cStr());
+						hlog::warnf(logTag, "Font '%s' does not exist!", context._nextTag.data.cStr());
 					}
 				}
-				else if (this->_nextTag.type == FormatTag::Type::Color)
+				else if (context._nextTag.type == FormatTag::Type::Color)
 				{
-					this->_currentTag.type = FormatTag::Type::Color;
-					this->_currentTag.data = this->_textColor.hex();
-					this->_stack += this->_currentTag;
-					if (!april::findSymbolicColor(this->_nextTag.data.lowered(), this->_hex))
+					context._currentTag.type = FormatTag::Type::Color;
+					context._currentTag.data = context._textColor.hex();
+					context._stack += context._currentTag;
+					if (!context._nextTag.resolved)
 					{
-						this->_hex = this->_nextTag.data;
-					}
-					if ((this->_hex.size() == 6 || this->_hex.size() == 8) && this->_hex.isHex())
-					{
-						if (this->_textColor == this->_strikeThroughColor)
+						if (!april::findSymbolicColor(context._nextTag.data.lowered(), context._hex))
+						{
+							context._hex = context._nextTag.data;
+						}
+						if ((context._hex.size() == 6 || context._hex.size() == 8) && context._hex.isHex())
 						{
-							this->_strikeThroughColor.set(this->_hex);
+							context._nextTag.color.set(context._hex);
+							context._nextTag.resolved = true;
 						}
-						if (this->_textColor == this->_underlineColor)
+						else
 						{
-							this->_underlineColor.set(this->_hex);
+							hlog::warnf(logTag, "Color '%s' does not exist!", context._hex.cStr());
 						}
-						this->_textColor.set(this->_hex);
-						this->_alpha == -1 ? this->_alpha = this->_textColor.a : this->_textColor.a = (unsigned char)(this->_alpha * this->_textColor.a_f());
 					}
-					else
+					if (context._nextTag.resolved)
 					{
-						hlog::warnf(logTag, "Color '%s' does not exist!", this->_hex.cStr());
+						if (context._textColor == context._strikeThroughColor)
+						{
+							context._strikeThroughColor = context._nextTag.color;
+						}
+						if (context._textColor == context._underlineColor)
+						{
+							context._underlineColor = context._nextTag.color;
+						}
+						context._textColor = context._nextTag.color;
+						context._alpha == -1 ? context._alpha = context._textColor.a : context._textColor.a = (unsigned char)(context._alpha * context._textColor.a_f());
 					}
 				}
-				else if (this->_nextTag.type == FormatTag::Type::Scale)
+				else if (context._nextTag.type == FormatTag::Type::Scale)
 				{
-					this->_currentTag.type = FormatTag::Type::Scale;
-					this->_currentTag.data = this->_textScale;
-					this->_stack += this->_currentTag;
-					this->_textScale = this->_nextTag.data;
+					context._currentTag.type = FormatTag::Type::Scale;
+					context._currentTag.data = context._textScale;
+					context._stack += context._currentTag;
+					context._textScale = context._nextTag.data;
 				}
-				else if (this->_nextTag.type == FormatTag::Type::NoEffect)
+				else if (context._nextTag.type == FormatTag::Type::NoEffect)
 				{
-					this->_currentTag.type = (this->_effectMode == EFFECT_MODE_BORDER ? FormatTag::Type::Border : (this->_effectMode == EFFECT_MODE_SHADOW ? FormatTag::Type::Shadow : FormatTag::Type::NoEffect));
-					this->_stack += this->_currentTag;
-					this->_effectMode = EFFECT_MODE_NORMAL;
+					context._currentTag.type = (context._effectMode == EFFECT_MODE_BORDER ? FormatTag::Type::Border : (context._effectMode == EFFECT_MODE_SHADOW ? FormatTag::Type::Shadow : FormatTag::Type::NoEffect));
+					context._stack += context._currentTag;
+					context._effectMode = EFFECT_MODE_NORMAL;
 				}
-				else if (this->_nextTag.type == FormatTag::Type::Shadow)
+				else if (context._nextTag.type == FormatTag::Type::Shadow)
 				{
-					this->_currentTag.type = (this->_effectMode == EFFECT_MODE_BORDER ? FormatTag::Type::Border : (this->_effectMode == EFFECT_MODE_SHADOW ? FormatTag::Type::Shadow : FormatTag::Type::NoEffect));
-					this->_currentTag.data = this->_shadowColor.hex() + "," + april::gvec2ToHstr<float>(this->_textShadowOffset);
-					this->_stack += this->_currentTag;
-					this->_effectMode = EFFECT_MODE_SHADOW;
-					this->_shadowColor = this->shadowColor;
-					if (this->_nextTag.data != "")
+					context._currentTag.type = (context._effectMode == EFFECT_MODE_BORDER ? FormatTag::Type::Border : (context._effectMode == EFFECT_MODE_SHADOW ? FormatTag::Type::Shadow : FormatTag::Type::NoEffect));
+					context._currentTag.data = context._shadowColor.hex() + "," + april::gvec2ToHstr<float>(context._textShadowOffset);
+					context._stack += context._currentTag;
+					context._effectMode = EFFECT_MODE_SHADOW;
+					context._shadowColor = this->shadowColor;
+					if (context._nextTag.data != "")
 					{
-						this->_parameterString1 = "";
-						if (this->_nextTag.data.count(',') == 2)
+						context._parameterString1 = "";
+						if (context._nextTag.data.count(',') == 2)
 						{
-							this->_nextTag.data.split(',', this->_parameterString0, this->_parameterString1);
-							this->_textShadowOffset = april::hstrToGvec2<float>(this->_parameterString1);
+							context._nextTag.data.split(',', context._parameterString0, context._parameterString1);
+							context._textShadowOffset = april::hstrToGvec2<float>(context._parameterString1);
 						}
 						else
 						{
-							this->_parameterString0 = this->_nextTag.data;
+							context._parameterString0 = context._nextTag.data;
 						}
-						if (!april::findSymbolicColor(this->_parameterString0.lowered(), this->_hex))
+						if (!april::findSymbolicColor(context._parameterString0.lowered(), context._hex))
 						{
-							this->_hex = this->_parameterString0;
+							context._hex = context._parameterString0;
 						}
-						if ((this->_hex.size() == 6 || this->_hex.size() == 8) && this->_hex.isHex())
+						if ((context._hex.size() == 6 || context._hex.size() == 8) && context._hex.isHex())
 						{
-							this->_shadowColor.set(this->_hex);
+							context._shadowColor.set(context._hex);
 						}
-						else if (this->_parameterString1 == "" || this->_hex != "")
+						else if (context._parameterString1 == "" || context._hex != "")
 						{
-							hlog::warnf(logTag, "Color '%s' does not exist!", this->_hex.cStr());
+							hlog::warnf(logTag, "Color '%s' does not exist!", context._hex.cStr());
 						}
 					}
 				}
-				else if (this->_nextTag.type == FormatTag::Type::Border)
+				else if (context._nextTag.type == FormatTag::Type::Border)
 				{
-					this->_currentTag.type = (this->_effectMode == EFFECT_MODE_BORDER ? FormatTag::Type::Border : (this->_effectMode == EFFECT_MODE_SHADOW ? FormatTag::Type::Shadow : FormatTag::Type::NoEffect));
-					this->_currentTag.data = this->_borderColor.hex() + "," + hstr(this->_textBorderThickness);
-					this->_stack += this->_currentTag;
-					this->_effectMode = EFFECT_MODE_BORDER;
-					this->_borderColor = this->borderColor;
-					if (this->_nextTag.data != "")
+					context._currentTag.type = (context._effectMode == EFFECT_MODE_BORDER ? FormatTag::Type::Border : (context._effectMode == EFFECT_MODE_SHADOW ? FormatTag::Type::Shadow : FormatTag::Type::NoEffect));
+					context._currentTag.data = context._borderColor.hex() + "," + hstr(context._textBorderThickness);
+					context._stack += context._currentTag;
+					context._effectMode = EFFECT_MODE_BORDER;
+					context._borderColor = this->borderColor;
+					if (context._nextTag.data != "")
 					{
-						this->_parameterString1 = "";
-						if (this->_nextTag.data.count(',') == 1)
+						context._parameterString1 = "";
+						if (context._nextTag.data.count(',') == 1)
 						{
-							this->_nextTag.data.split(',', this->_parameterString0, this->_parameterString1);
-							this->_textBorderThickness = (float)this->_parameterString1;
+							context._nextTag.data.split(',', context._parameterString0, context._parameterString1);
+							context._textBorderThickness = (float)context._parameterString1;
 						}
 						else
 						{
-							this->_parameterString0 = this->_nextTag.data;
+							context._parameterString0 = context._nextTag.data;
 						}
-						if (!april::findSymbolicColor(this->_parameterString0.lowered(), this->_hex))
+						if (!april::findSymbolicColor(context._parameterString0.lowered(), context._hex))
 						{
-							this->_hex = this->_parameterString0;
+							context._hex = context._parameterString0;
 						}
-						if ((this->_hex.size() == 6 || this->_hex.size() == 8) && this->_hex.isHex())
+						if ((context._hex.size() == 6 || context._hex.size() == 8) && context._hex.isHex())
 						{
-							this->_borderColor.set(this->_hex);
+							context._borderColor.set(context._hex);
 						}
-						else if (this->_parameterString1 == "" || this->_hex != "")
+						else if (context._parameterString1 == "" || context._hex != "")
 						{
-							hlog::warnf(logTag, "Color '%s' does not exist!", this->_hex.cStr());
+							hlog::warnf(logTag, "Color '%s' does not exist!", context._hex.cStr());
 						}
 					}
 				}
-				else if (this->_nextTag.type == FormatTag::Type::StrikeThrough)
+				else if (context._nextTag.type == FormatTag::Type::StrikeThrough)
 				{
-					this->_currentTag.type = FormatTag::Type::StrikeThrough;
-					this->_currentTag.data = this->_strikeThroughColor.hex() + "," + hstr(this->_textStrikeThroughThickness);
-					this->_stack += this->_currentTag;
-					this->_strikeThroughActive = true;
-					if (this->_nextTag.data != "")
+					context._currentTag.type = FormatTag::Type::StrikeThrough;
+					context._currentTag.data = context._strikeThroughColor.hex() + "," + hstr(context._textStrikeThroughThickness);
+					context._stack += context._currentTag;
+					context._strikeThroughActive = true;
+					if (context._nextTag.data != "")
 					{
-						this->_parameterString1 = "";
-						if (this->_nextTag.data.count(',') == 1)
+						context._parameterString1 = "";
+						if (context._nextTag.data.count(',') == 1)
 						{
-							this->_nextTag.data.split(',', this->_parameterString0, this->_parameterString1);
-							this->_textStrikeThroughThickness = (float)this->_parameterString1;
+							context._nextTag.data.split(',', context._parameterString0, context._parameterString1);
+							context._textStrikeThroughThickness = (float)context._parameterString1;
 						}
 						else
 						{
-							this->_parameterString0 = this->_nextTag.data;
+							context._parameterString0 = context._nextTag.data;
 						}
-						if (!april::findSymbolicColor(this->_parameterString0.lowered(), this->_hex))
+						if (!april::findSymbolicColor(context._parameterString0.lowered(), context._hex))
 						{
-							this->_hex = this->_parameterString0;
+							context._hex = context._parameterString0;
 						}
-						if ((this->_hex.size() == 6 || this->_hex.size() == 8) && this->_hex.isHex())
+						if ((context._hex.size() == 6 || context._hex.size() == 8) && context._hex.isHex())
 						{
-							this->_strikeThroughColor.set(this->_hex);
+							context._strikeThroughColor.set(context._hex);
 						}
-						else if (this->_parameterString1 == "" || this->_hex != "")
+						else if (context._parameterString1 == "" || context._hex != "")
 						{
-							hlog::warnf(logTag, "Color '%s' does not exist!", this->_hex.cStr());
+							hlog::warnf(logTag, "Color '%s' does not exist!", context._hex.cStr());
 						}
 					}
 				}
-				else if (this->_nextTag.type == FormatTag::Type::Underline)
+				else if (context._nextTag.type == FormatTag::Type::Underline)
 				{
-					this->_currentTag.type = FormatTag::Type::Underline;
-					this->_currentTag.data = this->_underlineColor.hex() + "," + hstr(this->_textUnderlineThickness);
-					this->_stack += this->_currentTag;
-					this->_underlineActive = true;
-					if (this->_nextTag.data != "")
+					context._currentTag.type = FormatTag::Type::Underline;
+					context._currentTag.data = context._underlineColor.hex() + "," + hstr(context._textUnderlineThickness);
+					context._stack += context._currentTag;
+					context._underlineActive = true;
+					if (context._nextTag.data != "")
 					{
-						this->_parameterString1 = "";
-						if (this->_nextTag.data.count(',') == 1)
+						context._parameterString1 = "";
+						if (context._nextTag.data.count(',') == 1)
 						{
-							this->_nextTag.data.split(',', this->_parameterString0, this->_parameterString1);
-							this->_textUnderlineThickness = (float)this->_parameterString1;
+							context._nextTag.data.split(',', context._parameterString0, context._parameterString1);
+							context._textUnderlineThickness = (float)context._parameterString1;
 						}
 						else
 						{
-							this->_parameterString0 = this->_nextTag.data;
+							context._parameterString0 = context._nextTag.data;
 						}
-						if (!april::findSymbolicColor(this->_parameterString0.lowered(), this->_hex))
+						if (!april::findSymbolicColor(context._parameterString0.lowered(), context._hex))
 						{
-							this->_hex = this->_parameterString0;
+							context._hex = context._parameterString0;
 						}
-						if ((this->_hex.size() == 6 || this->_hex.size() == 8) && this->_hex.isHex())
+						if ((context._hex.size() == 6 || context._hex.size() == 8) && context._hex.isHex())
 						{
-							this->_underlineColor.set(this->_hex);
+							context._underlineColor.set(context._hex);
 						}
-						else if (this->_parameterString1 == "" || this->_hex != "")
+						else if (context._parameterString1 == "" || context._hex != "")
 						{
-							hlog::warnf(logTag, "Color '%s' does not exist!", this->_hex.cStr());
+							hlog::warnf(logTag, "Color '%s' does not exist!", context._hex.cStr());
 						}
 					}
 				}
-				else if (this->_nextTag.type == FormatTag::Type::Italic)
+				else if (context._nextTag.type == FormatTag::Type::Italic)
 				{
-					this->_currentTag.type = FormatTag::Type::Italic;
-					this->_stack += this->_currentTag;
-					this->_italicActive = true;
+					context._currentTag.type = FormatTag::Type::Italic;
+					context._stack += context._currentTag;
+					context._italicActive = true;
 				}
-				else if (this->_nextTag.type == FormatTag::Type::Hide)
+				else if (context._nextTag.type == FormatTag::Type::Hide)
 				{
-					this->_currentTag.type = FormatTag::Type::Hide;
-					this->_stack += this->_currentTag;
-					this->_hideActive = true;
+					context._currentTag.type = FormatTag::Type::Hide;
+					context._stack += context._currentTag;
+					context._hideActive = true;
 				}
-				else if (this->_nextTag.type == FormatTag::Type::IgnoreFormatting)
+				else if (context._nextTag.type == FormatTag::Type::IgnoreFormatting)
 				{
-					this->_currentTag.type = FormatTag::Type::IgnoreFormatting;
-					this->_stack += this->_currentTag;
+					context._currentTag.type = FormatTag::Type::IgnoreFormatting;
+					context._stack += context._currentTag;
 				}
 			}
-			this->_tags.removeFirst();
-			if (this->_tags.size() > 0)
+			context._tags.removeFirst();
+			if (context._tags.size() > 0)
 			{
-				this->_nextTag = this->_tags.first();
+				context._nextTag = context._tags.first();
 			}
-			else if (this->_lines.size() > 0)
+			else if (context._renderLine != NULL)
 			{
-				this->_nextTag.start = this->_line.words.last().start + this->_line.words.last().text.size() + 1;
+				context._nextTag.start = context._renderLine->words.last().start + context._renderLine->words.last().text.size() + 1;
 			}
 			else
 			{
-				this->_nextTag.start = this->_word.start + this->_word.text.size() + 1;
+				context._nextTag.start = context._renderWord->start + context._renderWord->text.size() + 1;
 			}
-			if (this->_iconFont != NULL)
+			if (context._iconFont != NULL)
 			{
-				this->_texture = this->_iconFont->getTexture(this->_fontIconName);
-				this->_checkSequenceSwitch();
+				context._texture = context._iconFont->getTexture(context._fontIconName);
+				this->_checkSequenceSwitch(context);
 			}
-			else if (this->_font != NULL)
+			else if (context._font != NULL)
 			{
-				this->_texture = this->_font->getTexture(this->_code);
-				this->_checkSequenceSwitch();
+				context._texture = context._font->getTexture(context._code);
+				this->_checkSequenceSwitch(context);
 			}
 		}
-		if (this->_tags.size() == 0)
+		if (context._tags.size() == 0)
 		{
-			if (this->_lines.size() > 0)
+			if (context._renderLine != NULL)
 			{
-				this->_nextTag.start = this->_line.words.last().start + this->_line.words.last().text.size() + 1;
+				context._nextTag.start = context._renderLine->words.last().start + context._renderLine->words.last().text.size() + 1;
 			}
 			else
 			{
-				this->_nextTag.start = this->_word.start + this->_word.text.size() + 1;
+				context._nextTag.start = context._renderWord->start + context._renderWord->text.size() + 1;
 			}
 		}
 		// this additional check is required in case the texture had to be changed
-		if (this->_iconFont != NULL)
+		if (context._iconFont != NULL)
 		{
-			this->_texture = this->_iconFont->getTexture(this->_fontIconName);
-			this->_checkSequenceSwitch();
+			context._texture = context._iconFont->getTexture(context._fontIconName);
+			this->_checkSequenceSwitch(context);
 		}
-		else if (this->_font != NULL)
+		else if (context._font != NULL)
 		{
-			this->_texture = this->_font->getTexture(this->_code);
-			this->_checkSequenceSwitch();
+			context._texture = context._font->getTexture(context._code);
+			this->_checkSequenceSwitch(context);
 		}
 	}
 
-	void Renderer::_checkSequenceSwitch()
+	void Renderer::_checkSequenceSwitch(LayoutContext& context)
 	{
-		if (this->_textSequence.texture != this->_texture)
+		if (context._textSequence.texture != context._texture)
 		{
-			if (this->_textSequence.vertices.size() > 0)
+			if (context._textSequence.vertices.size() > 0)
+			{
+				context._textSequences += context._textSequence;
+				context._textSequence.clear();
+			}
+			context._textSequence.texture = context._texture;
+			// textures belong to the font that is currently active
+			Font* font = (context._iconFont != NULL ? context._iconFont : context._font);
+			if (font != NULL && !context._renderFonts.has(font))
 			{
-				this->_textSequences += this->_textSequence;
-				this->_textSequence.clear();
+				context._renderFonts += font;
 			}
-			this->_textSequence.texture = this->_texture;
 		}
-		if (this->_shadowSequence.texture != this->_texture)
+		if (context._shadowSequence.texture != context._texture)
 		{
-			if (this->_shadowSequence.vertices.size() > 0)
+			if (context._shadowSequence.vertices.size() > 0)
 			{
-				this->_shadowSequences += this->_shadowSequence;
-				this->_shadowSequence.clear();
+				context._shadowSequences += context._shadowSequence;
+				context._shadowSequence.clear();
 			}
-			this->_shadowSequence.texture = this->_texture;
+			context._shadowSequence.texture = context._texture;
 		}
-		if (this->_borderSequence.texture != this->_texture)
+		if (context._borderSequence.texture != context._texture)
 		{
-			if (this->_borderSequence.vertices.size() > 0)
+			if (context._borderSequence.vertices.size() > 0)
 			{
-				this->_borderSequences += this->_borderSequence;
-				this->_borderSequence.clear();
+				context._borderSequences += context._borderSequence;
+				context._borderSequence.clear();
 			}
-			this->_borderSequence.texture = this->_texture;
+			context._borderSequence.texture = context._texture;
 		}
-		if (this->_textStrikeThroughSequence.color != this->_strikeThroughColor)
+		if (context._textStrikeThroughSequence.color != context._strikeThroughColor)
 		{
-			if (this->_textStrikeThroughSequence.vertices.size() > 0)
+			if (context._textStrikeThroughSequence.vertices.size() > 0)
 			{
-				this->_textLiningSequences += this->_textStrikeThroughSequence;
-				this->_textStrikeThroughSequence.clear();
+				context._textLiningSequences += context._textStrikeThroughSequence;
+				context._textStrikeThroughSequence.clear();
 			}
-			this->_textStrikeThroughSequence.color = this->_strikeThroughColor;
+			context._textStrikeThroughSequence.color = context._strikeThroughColor;
 		}
-		if (this->_textUnderlineSequence.color != this->_underlineColor)
+		if (context._textUnderlineSequence.color != context._underlineColor)
 		{
-			if (this->_textUnderlineSequence.vertices.size() > 0)
+			if (context._textUnderlineSequence.vertices.size() > 0)
 			{
-				this->_textLiningSequences += this->_textUnderlineSequence;
-				this->_textUnderlineSequence.clear();
+				context._textLiningSequences += context._textUnderlineSequence;
+				context._textUnderlineSequence.clear();
 			}
-			this->_textUnderlineSequence.color = this->_underlineColor;
+			context._textUnderlineSequence.color = context._underlineColor;
 		}
-		if (this->_shadowStrikeThroughSequence.color != this->_shadowColor)
+		if (context._shadowStrikeThroughSequence.color != context._shadowColor)
 		{
-			if (this->_shadowStrikeThroughSequence.vertices.size() > 0)
+			if (context._shadowStrikeThroughSequence.vertices.size() > 0)
 			{
-				this->_shadowLiningSequences += this->_shadowStrikeThroughSequence;
-				this->_shadowStrikeThroughSequence.clear();
+				context._shadowLiningSequences += context._shadowStrikeThroughSequence;
+				context._shadowStrikeThroughSequence.clear();
 			}
-			this->_shadowStrikeThroughSequence.color = this->_shadowColor;
-			if (this->_shadowUnderlineSequence.vertices.size() > 0)
+			context._shadowStrikeThroughSequence.color = context._shadowColor;
+			if (context._shadowUnderlineSequence.vertices.size() > 0)
 			{
-				this->_shadowLiningSequences += this->_shadowUnderlineSequence;
-				this->_shadowUnderlineSequence.clear();
+				context._shadowLiningSequences += context._shadowUnderlineSequence;
+				context._shadowUnderlineSequence.clear();
 			}
-			this->_shadowUnderlineSequence.color = this->_shadowColor;
+			context._shadowUnderlineSequence.color = context._shadowColor;
 		}
-		if (this->_borderStrikeThroughSequence.color != this->_borderColor)
+		if (context._borderStrikeThroughSequence.color != context._borderColor)
 		{
-			if (this->_borderStrikeThroughSequence.vertices.size() > 0)
+			if (context._borderStrikeThroughSequence.vertices.size() > 0)
 			{
-				this->_borderLiningSequences += this->_borderStrikeThroughSequence;
-				this->_borderStrikeThroughSequence.clear();
+				context._borderLiningSequences += context._borderStrikeThroughSequence;
+				context._borderStrikeThroughSequence.clear();
 			}
-			this->_borderStrikeThroughSequence.color = this->_borderColor;
-			if (this->_borderUnderlineSequence.vertices.size() > 0)
+			context._borderStrikeThroughSequence.color = context._borderColor;
+			if (context._borderUnderlineSequence.vertices.size() > 0)
 			{
-				this->_borderLiningSequences += this->_borderUnderlineSequence;
-				this->_borderUnderlineSequence.clear();
+				context._borderLiningSequences += context._borderUnderlineSequence;
+				context._borderUnderlineSequence.clear();
 			}
-			this->_borderUnderlineSequence.color = this->_borderColor;
+			context._borderUnderlineSequence.color = context._borderColor;
 		}
 	}
 
-	void Renderer::_updateLiningSequenceSwitch(bool force)
+	void Renderer::_updateLiningSequenceSwitch(LayoutContext& context, bool force)
 	{
-		if (!this->_strikeThroughActive || force)
+		if (!context._strikeThroughActive || force)
 		{
-			if (this->_textStrikeThroughSequence.vertices.size() > 0)
+			if (context._textStrikeThroughSequence.vertices.size() > 0)
 			{
-				this->_textLiningSequences += this->_textStrikeThroughSequence;
-				this->_textStrikeThroughSequence.clear();
+				context._textLiningSequences += context._textStrikeThroughSequence;
+				context._textStrikeThroughSequence.clear();
 			}
-			if (this->_shadowStrikeThroughSequence.vertices.size() > 0)
+			if (context._shadowStrikeThroughSequence.vertices.size() > 0)
 			{
-				this->_shadowLiningSequences += this->_shadowStrikeThroughSequence;
-				this->_shadowStrikeThroughSequence.clear();
+				context._shadowLiningSequences += context._shadowStrikeThroughSequence;
+				context._shadowStrikeThroughSequence.clear();
 			}
-			if (this->_borderStrikeThroughSequence.vertices.size() > 0)
+			if (context._borderStrikeThroughSequence.vertices.size() > 0)
 			{
-				this->_borderLiningSequences += this->_borderStrikeThroughSequence;
-				this->_borderStrikeThroughSequence.clear();
+				context._borderLiningSequences += context._borderStrikeThroughSequence;
+				context._borderStrikeThroughSequence.clear();
 			}
 		}
-		if (!this->_underlineActive || force)
+		if (!context._underlineActive || force)
 		{
-			if (this->_textUnderlineSequence.vertices.size() > 0)
+			if (context._textUnderlineSequence.vertices.size() > 0)
 			{
-				this->_textLiningSequences += this->_textUnderlineSequence;
-				this->_textUnderlineSequence.clear();
+				context._textLiningSequences += context._textUnderlineSequence;
+				context._textUnderlineSequence.clear();
 			}
-			if (this->_shadowUnderlineSequence.vertices.size() > 0)
+			if (context._shadowUnderlineSequence.vertices.size() > 0)
 			{
-				this->_shadowLiningSequences += this->_shadowUnderlineSequence;
-				this->_shadowUnderlineSequence.clear();
+				context._shadowLiningSequences += context._shadowUnderlineSequence;
+				context._shadowUnderlineSequence.clear();
 			}
-			if (this->_borderUnderlineSequence.vertices.size() > 0)
+			if (context._borderUnderlineSequence.vertices.size() > 0)
 			{
-				this->_borderLiningSequences += this->_borderUnderlineSequence;
-				this->_borderUnderlineSequence.clear();
+				context._borderLiningSequences += context._borderUnderlineSequence;
+				context._borderUnderlineSequence.clear();
 			}
 		}
 	}
 
 	harray<RenderWord> Renderer::createRenderWords(cgrectf rect, chstr text, const harray<FormatTag>& tags)
 	{
-		this->_initializeFormatTags(tags);
-		hstr initialFontName = this->_tags.first().data; // by convention, the first tag is the font name
+		return this->createRenderWords(this->layoutContext, rect, text, tags);
+	}
+
+	harray<RenderWord> Renderer::createRenderWords(LayoutContext& context, cgrectf rect, chstr text, const harray<FormatTag>& tags)
+	{
+		return this->_createRenderWords(context, rect, text, tags, 0, -1);
+	}
+
+	harray<RenderWord> Renderer::_createRenderWords(LayoutContext& context, cgrectf rect, chstr text, const harray<FormatTag>& tags, int textStart, int textEnd)
+	{
+		this->_initializeFormatTags(context, tags);
+		hstr initialFontName = context._tags.first().data; // by convention, the first tag is the font name
 		int actualSize = text.indexOf('\0');
 		if (actualSize < 0)
 		{
@@ -1584,8 +2175,16 @@ namespace atres
 		{
 			hlog::warnf(logTag, "Text '%s' has \\0 character before the actual end!", text.cStr());
 		}
+		if (textEnd >= 0 && textEnd < actualSize)
+		{
+			actualSize = textEnd;
+		}
 		harray<RenderWord> result;
 		RenderWord word;
+		const char* str = text.cStr();
+		unsigned char lineBreakClass = LINE_BREAK_AL;
+		unsigned char previousLineBreakClass = LINE_BREAK_AL;
+		CharacterDefinition* character = NULL;
 		unsigned int code = 0;
 		unsigned int previousCode = 0;
 		harray<hstr> iconNames;
@@ -1600,30 +2199,29 @@ namespace atres
 		float wordBearingX = 0.0f;
 		float kerning = 0.0f;
 		int start = 0;
-		int i = 0;
-		int chars = 0;
+		int i = textStart;
 		int byteSize = 0;
 		bool checkingSpaces = true;
 		bool icon = false;
 		bool tooLong = false;
 		hstr iconName;
-		harray<float> charXs;
-		harray<float> charHeights;
-		harray<float> charAdvanceXs;
-		harray<float> segmentWidths;
+		float maxCharHeight = 0.0f;
+		int glyphIndex = 0;
+		GlyphRun& glyphs = context._glyphRun;
+		glyphs.clear();
 		word.rect.x = rect.x;
 		word.rect.y = rect.y;
-		word.rect.h = this->_height;
+		word.rect.h = context._height;
 		// checking all words
 		while (i < actualSize)
 		{
 			start = i;
-			chars = 0;
 			charX = 0.0f;
 			charHeight = 0.0f;
 			wordWidth = 0.0f;
 			wordBearingX = 0.0f;
 			icon = false;
+			glyphIndex = glyphs.size();
 			// checking a whole word
 			while (i < actualSize)
 			{
@@ -1633,54 +2231,51 @@ namespace atres
 				addW = 0.0f;
 #endif
 				previousCode = code;
-				code = text.firstUnicodeChar(i, &byteSize);
-				this->_checkFormatTags(text, i);
-				if (this->_iconFont != NULL)
+				code = _decodeChar(text, str, i, &byteSize);
+				this->_checkFormatTags(context, text, i);
+				if (context._iconFont != NULL)
 				{
 					if (i > start)
 					{
 						break;
 					}
 					icon = true;
-					if (this->_icons.hasKey(this->_fontIconName))
+					if (context._icons.hasKey(context._fontIconName))
 					{
-						this->_icon = this->_icons[this->_fontIconName];
-						this->_scale = this->_iconFontScale * this->_textScale;
-						ax = this->_icon->advance * this->_scale;
-						if (this->_iconFontBearingX < 0.0f)
+						context._icon = context._icons[context._fontIconName];
+						context._scale = context._iconFontScale * context._textScale;
+						ax = context._icon->advance * context._scale;
+						if (context._iconFontBearingX < 0.0f)
 						{
-							ax -= this->_iconFontBearingX * this->_scale;
-							bearingX = charX + this->_iconFontBearingX * this->_scale;
+							ax -= context._iconFontBearingX * context._scale;
+							bearingX = charX + context._iconFontBearingX * context._scale;
 							if (bearingX < 0)
 							{
-								aw = (this->_icon->rect.w - charX) * this->_scale;
+								aw = (context._icon->rect.w - charX) * context._scale;
 								charX = 0.0f;
 								wordBearingX = hmin(wordBearingX, bearingX);
-								foreach (float, it, charXs)
-								{
-									(*it) -= bearingX;
-								}
-								foreach (float, it, segmentWidths)
+								for_iter (j, glyphIndex, glyphs.size())
 								{
-									(*it) -= bearingX;
+									glyphs.charXs[j] -= bearingX;
+									glyphs.segmentWidths[j] -= bearingX;
 								}
 							}
 							else
 							{
 								charX = bearingX;
-								aw = this->_icon->rect.w * this->_scale;
+								aw = context._icon->rect.w * context._scale;
 							}
 						}
 						else
 						{
-							aw = (this->_icon->rect.w + this->_iconFontBearingX) * this->_scale;
+							aw = (context._icon->rect.w + context._iconFontBearingX) * context._scale;
 						}
-						if (this->_italicActive)
+						if (context._italicActive)
 						{
-							aw += this->_icon->rect.h * this->_scale * this->_italicSkewRatio;
+							aw += context._icon->rect.h * context._scale * context._italicSkewRatio;
 						}
 						addW = hmax(ax, aw);
-						charHeight = (this->_iconFontOffsetY + this->_icon->rect.h) * this->_scale;
+						charHeight = (context._iconFontOffsetY + context._icon->rect.h) * context._scale;
 					}
 					previousWordWidth = wordWidth;
 					wordWidth = hmax(charX + addW, wordWidth);
@@ -1690,14 +2285,11 @@ namespace atres
 						tooLong = true;
 						break;
 					}
-					charXs += charX;
-					charHeights += charHeight;
+					glyphs.add(charX, ax, wordWidth);
+					maxCharHeight = hmax(maxCharHeight, charHeight);
 					charX += ax;
-					charAdvanceXs += ax;
-					segmentWidths += wordWidth;
 					i += byteSize;
-					++chars;
-					this->_iconFont = NULL;
+					context._iconFont = NULL;
 					break;
 				}
 				if (code == UNICODE_CHAR_NEWLINE)
@@ -1705,7 +2297,6 @@ namespace atres
 					if (i == start)
 					{
 						i += byteSize;
-						++chars;
 					}
 					break;
 				}
@@ -1713,60 +2304,81 @@ namespace atres
 				{
 					break;
 				}
+				// break opportunities within words are decided in one pass using the previous character's line-break class
+				if (!checkingSpaces && !this->useLegacyLineBreakParsing)
+				{
+					lineBreakClass = _getLineBreakClass(code);
+					if (lineBreakClass == LINE_BREAK_ID && !this->useIdeographWords)
+					{
+						lineBreakClass = LINE_BREAK_AL;
+					}
+					if (i == start)
+					{
+						previousLineBreakClass = (lineBreakClass != LINE_BREAK_CM ? lineBreakClass : (unsigned char)LINE_BREAK_AL);
+					}
+					else if (lineBreakClass != LINE_BREAK_CM) // combining marks always stay with the previous character
+					{
+						// a stacked consonant belongs to the cluster of the previous one
+						if (_lineBreakPairs[previousLineBreakClass][lineBreakClass] != 0 && !_isStackingSign(previousCode))
+						{
+							break;
+						}
+						previousLineBreakClass = lineBreakClass;
+					}
+				}
 				// non-initial font might need character table update
-				if (initialFontName != this->_fontName && !this->_characters.hasKey(code) && this->_font->hasCharacter(code))
+				character = this->_findCharacter(context, code);
+				if (initialFontName != context._fontName && character == NULL && context._font->hasCharacter(code))
 				{
-					this->_characters = this->_font->getCharacters();
+					this->_setCharacters(context, context._font->getCharacters());
+					character = this->_findCharacter(context, code);
 				}
-				if (this->_characters.hasKey(code))
+				if (character != NULL)
 				{
-					this->_character = this->_characters[code];
-					this->_scale = this->_fontScale * this->_textScale;
+					context._character = character;
+					context._scale = context._fontScale * context._textScale;
 					kerning = 0.0f;
-					if (this->_font != NULL)
+					if (context._font != NULL)
 					{
-						kerning = this->_font->getKerning(previousCode, code);
+						kerning = context._font->getKerning(previousCode, code);
 					}
-					ax = (this->_character->advance - this->_character->bearing.x + kerning) * this->_scale;
-					if (this->_character->bearing.x < 0.0f)
+					ax = (context._character->advance - context._character->bearing.x + kerning) * context._scale;
+					if (context._character->bearing.x < 0.0f)
 					{
-						bearingX = charX + this->_character->bearing.x * this->_scale;
+						bearingX = charX + context._character->bearing.x * context._scale;
 						if (bearingX < 0)
 						{
-							aw = (this->_character->rect.w - charX + kerning) * this->_scale;
+							aw = (context._character->rect.w - charX + kerning) * context._scale;
 							charX = 0.0f;
 							wordBearingX = hmin(wordBearingX, bearingX);
-							foreach (float, it, charXs)
-							{
-								(*it) -= bearingX;
-							}
-							foreach (float, it, segmentWidths)
+							for_iter (j, glyphIndex, glyphs.size())
 							{
-								(*it) -= bearingX;
+								glyphs.charXs[j] -= bearingX;
+								glyphs.segmentWidths[j] -= bearingX;
 							}
 						}
 						else
 						{
 							charX = bearingX;
-							aw = (this->_character->rect.w + kerning) * this->_scale;
+							aw = (context._character->rect.w + kerning) * context._scale;
 						}
 					}
 					else
 					{
-						charX += this->_character->bearing.x * this->_scale;
-						aw = (this->_character->rect.w + kerning) * this->_scale;
+						charX += context._character->bearing.x * context._scale;
+						aw = (context._character->rect.w + kerning) * context._scale;
 					}
-					if (this->_italicActive)
+					if (context._italicActive)
 					{
-						aw += this->_character->rect.h * this->_scale * this->_italicSkewRatio;
+						aw += context._character->rect.h * context._scale * context._italicSkewRatio;
 					}
 					addW = hmax(ax, aw);
-					charHeight = (this->_character->offsetY + this->_character->bearing.y + this->_character->rect.h) * this->_scale;
+					charHeight = (context._character->offsetY + context._character->bearing.y + context._character->rect.h) * context._scale;
 				}
 				else
 				{
-					addW = this->_font->getHeight() * 0.5f;
-					charHeight = this->_font->getHeight();
+					addW = context._resolvedFont.getHeight() * 0.5f;
+					charHeight = context._resolvedFont.getHeight();
 				}
 				previousWordWidth = wordWidth;
 				wordWidth = hmax(charX + addW, wordWidth);
@@ -1779,65 +2391,33 @@ namespace atres
 					}
 					break;
 				}
-				charXs += charX;
-				charHeights += charHeight;
+				glyphs.add(charX, ax, wordWidth);
+				maxCharHeight = hmax(maxCharHeight, charHeight);
 				charX += ax;
-				charAdvanceXs += ax;
-				segmentWidths += wordWidth;
 				i += byteSize;
-				++chars;
-				if (!checkingSpaces && i < actualSize)
+				if (!checkingSpaces && i < actualSize && this->useLegacyLineBreakParsing && IS_PUNCTUATION_CHAR(code))
 				{
-					if (!this->useLegacyLineBreakParsing)
-					{
-						if (!this->useIdeographWords)
-						{
-							if (chars >= 2 && IS_PUNCTUATION_CHAR(code))
-							{
-								unsigned int nextCode = text.firstUnicodeChar(i);
-								if (nextCode == UNICODE_CHAR_SPACE || nextCode == 0)
-								{
-									break;
-								}
-							}
-						}
-						else if (IS_IDEOGRAPH(code) || IS_PUNCTUATION_CHAR(code))
-						{
-							unsigned int nextCode = text.firstUnicodeChar(i);
-							if (!IS_PUNCTUATION_CHAR(nextCode))
-							{
-								break;
-							}
-						}
-					}
-					else if (IS_PUNCTUATION_CHAR(code))
-					{
-						break;
-					}
+					break;
 				}
 			}
 			if (i > start)
 			{
 				word.text = (!icon ? text(start, i - start) : "");
 				word.rect.w = wordWidth + wordBearingX;
-				word.rect.h = hmax(this->_height, (charHeights.size() > 0 ? charHeights.max() : 0.0f));
+				word.rect.h = hmax(context._height, maxCharHeight);
 				word.advanceX = charX + wordBearingX;
 				word.bearingX = wordBearingX;
 				word.start = start;
 				word.count = (!icon ? i - start : 0);
 				word.spaces = (!icon && checkingSpaces ? i - start : 0);
 				word.icon = icon;
-				foreach (float, it, charXs)
+				word.glyphIndex = glyphIndex;
+				word.glyphCount = glyphs.size() - glyphIndex;
+				for_iter (j, glyphIndex, glyphs.size())
 				{
-					(*it) += wordBearingX;
+					glyphs.charXs[j] += wordBearingX;
 				}
-				word.charXs = charXs;
-				word.charAdvanceXs = charAdvanceXs;
-				word.segmentWidths = segmentWidths;
 				result += word;
-				charXs.clear();
-				charAdvanceXs.clear();
-				segmentWidths.clear();
 			}
 			else if (tooLong) // this prevents an infinite loop if not at least one character fits in the line
 			{
@@ -1845,7 +2425,7 @@ namespace atres
 				break;
 			}
 			tooLong = false;
-			if (this->_iconFont != NULL)
+			if (context._iconFont != NULL)
 			{
 				checkingSpaces = false;
 			}
@@ -1859,9 +2439,115 @@ namespace atres
 
 	harray<RenderLine> Renderer::createRenderLines(cgrectf rect, chstr text, const harray<FormatTag>& tags, const Horizontal& horizontal, const Vertical& vertical, cgvec2f offset)
 	{
+		return this->createRenderLines(this->layoutContext, rect, text, tags, horizontal, vertical, offset);
+	}
+
+	harray<RenderLine> Renderer::createRenderLines(LayoutContext& context, cgrectf rect, chstr text, const harray<FormatTag>& tags, const Horizontal& horizontal, const Vertical& vertical, cgvec2f offset)
+	{
+		harray<RenderLine> result;
+		this->_createRenderLines(context, result, rect, text, tags, horizontal, vertical, offset);
+		return result;
+	}
+
+	void Renderer::_createRenderLines(LayoutContext& context, harray<RenderLine>& result, cgrectf rect, chstr text, const harray<FormatTag>& tags, const Horizontal& horizontal, const Vertical& vertical, cgvec2f offset)
+	{
+		this->_createLineBreaks(context, result, rect.w, text, tags, horizontal);
+		this->_placeRenderLines(result, rect, horizontal, vertical, offset, context._lineHeight, context._descender, context._internalDescender);
+	}
+
+	void Renderer::_createLineBreaks(LayoutContext& context, harray<RenderLine>& result, float width, chstr text, const harray<FormatTag>& tags, const Horizontal& horizontal)
+	{
+		// breaking only depends on the width, lines are created at the origin and placed afterwards
+		grectf rect(0.0f, 0.0f, width, CHECK_RECT_SIZE);
 		this->analyzeText(tags.first().data, text); // by convention, the first tag is the font name
-		harray<RenderWord> words = this->createRenderWords(rect, text, tags);
-		this->_initializeLineProcessing();
+		harray<RenderWord> words = this->createRenderWords(context, rect, text, tags);
+		this->_breakRenderWords(context, result, words, width, horizontal);
+	}
+
+	bool Renderer::_createScaledLineBreaks(LayoutContext& context, Cache<CacheEntryWords>* wordsCache, harray<RenderLine>& result, const CacheEntryBasicText& entry, chstr text, const harray<FormatTag>& tags, const Horizontal& horizontal)
+	{
+		// other fonts within the text would not follow the scale of the first font
+		if (_hasFontChanges(tags))
+		{
+			return false;
+		}
+		hstr fontName = tags.first().data; // by convention, the first tag is the font name
+		hstr baseFontName = fontName;
+		if (fontName != "" && !this->fonts.hasKey(fontName))
+		{
+			int position = (int)fontName.indexOf(":");
+			if (position < 0)
+			{
+				return false;
+			}
+			baseFontName = fontName(0, position);
+		}
+		ResolvedFont font = this->resolveFont(fontName);
+		ResolvedFont baseFont = this->resolveFont(baseFontName);
+		// sized font instances have their own metrics that don't scale linearly
+		if (font.font == NULL || font.font != baseFont.font)
+		{
+			return false;
+		}
+		CacheEntryWords* wordsEntry = this->_makeRenderWords(context, wordsCache, entry.text, entry.textHash, baseFontName, text, tags);
+		harray<RenderWord> words;
+		if (!this->_scaleRenderWords(context, *wordsEntry, font.getScale() / baseFont.getScale(), entry.rect.w, words))
+		{
+			return false;
+		}
+		this->_breakRenderWords(context, result, words, entry.rect.w, horizontal);
+		return true;
+	}
+
+	CacheEntryWords* Renderer::_makeRenderWords(LayoutContext& context, Cache<CacheEntryWords>* wordsCache, chstr text, unsigned int textHash, chstr fontName, chstr unformattedText, const harray<FormatTag>& tags)
+	{
+		this->_cacheEntryWordsData.set(text, textHash, fontName, grectf(), Horizontal::Left, Vertical::Top, april::Color::White, gvec2f());
+		this->_cacheEntryWords = wordsCache->get(this->_cacheEntryWordsData);
+		if (this->_cacheEntryWords == NULL)
+		{
+			harray<FormatTag> fontTags = tags;
+			fontTags.first().data = fontName;
+			this->analyzeText(fontName, unformattedText);
+			this->_cacheEntryWords = wordsCache->add(this->_cacheEntryWordsData);
+			this->_cacheEntryWords->value = this->createRenderWords(context, grectf(0.0f, 0.0f, CHECK_RECT_SIZE, CHECK_RECT_SIZE), unformattedText, fontTags);
+			this->_cacheEntryWords->glyphs = context._glyphRun;
+			this->_cacheEntryWords->height = context._height;
+			this->_cacheEntryWords->lineHeight = context._lineHeight;
+			this->_cacheEntryWords->descender = context._descender;
+			this->_cacheEntryWords->internalDescender = context._internalDescender;
+			wordsCache->update();
+		}
+		return this->_cacheEntryWords;
+	}
+
+	bool Renderer::_scaleRenderWords(LayoutContext& context, const CacheEntryWords& entry, float scale, float width, harray<RenderWord>& words)
+	{
+		words = entry.value;
+		foreach (RenderWord, it, words)
+		{
+			(*it).rect.w *= scale;
+			(*it).rect.h *= scale;
+			(*it).advanceX *= scale;
+			(*it).bearingX *= scale;
+			// words that are too long for the line would have been split up during measuring
+			if ((*it).rect.w - (*it).bearingX > width)
+			{
+				return false;
+			}
+		}
+		context._glyphRun = entry.glyphs;
+		context._glyphRun.scale(scale);
+		context._height = entry.height * scale;
+		context._lineHeight = entry.lineHeight * scale;
+		context._descender = entry.descender * scale;
+		context._internalDescender = entry.internalDescender * scale;
+		return true;
+	}
+
+	void Renderer::_breakRenderWords(LayoutContext& context, harray<RenderLine>& result, harray<RenderWord>& words, float width, const Horizontal& horizontal)
+	{
+		grectf rect(0.0f, 0.0f, width, CHECK_RECT_SIZE);
+		this->_initializeLineProcessing(context);
 		// helper variables
 		bool wrapped = horizontal.isWrapped();
 		bool untrimmed = horizontal.isUntrimmed();
@@ -1872,8 +2558,8 @@ namespace atres
 		bool nextLine = false;
 		bool forcedNextLine = false;
 		bool addWord = false;
-		this->_line.rect.x = rect.x;
-		this->_line.rect.h = this->_height;
+		context._line.rect.x = rect.x;
+		context._line.rect.h = context._height;
 		// iterate through each word
 		for_iter (i, 0, words.size())
 		{
@@ -1887,13 +2573,13 @@ namespace atres
 				nextLine = true;
 				forcedNextLine = true;
 			}
-			else if (this->_line.words.size() == 0 && words[i].spaces > 0 && wrapped && !untrimmed)
+			else if (context._line.words.size() == 0 && words[i].spaces > 0 && wrapped && !untrimmed)
 			{
 				addWord = false;
 			}
 			else if (currentLineWidth + words[i].rect.w > rect.w && wrapped)
 			{
-				if (this->_line.words.size() > 0)
+				if (context._line.words.size() > 0)
 				{
 					addWord = false;
 					--i;
@@ -1901,15 +2587,18 @@ namespace atres
 				// else the whole word is the only one in the line and doesn't fit, so just chop it off
 				nextLine = true;
 			}
-			if (this->_line.words.size() == 0) // if no words yet, this word's start becomes the line start
+			if (context._line.words.size() == 0) // if no words yet, this word's start becomes the line start
 			{
-				this->_line.start = words[i].start;
+				context._line.start = words[i].start;
 			}
 			if (addWord)
 			{
-				words[i].rect.y += this->_lines.size() * this->_lineHeight;
-				this->_line.words += words[i];
-				this->_line.count += words[i].count;
+				words[i].rect.y += context._lines.size() * context._lineHeight;
+				// per-character data is moved into the line's glyph run
+				context._line.glyphs.addFrom(context._glyphRun, words[i].glyphIndex, words[i].glyphCount);
+				words[i].glyphIndex = context._line.glyphs.size() - words[i].glyphCount;
+				context._line.words += words[i];
+				context._line.count += words[i].count;
 				lineWidth = currentLineWidth;
 				lineWidth += words[i].advanceX;
 			}
@@ -1918,66 +2607,137 @@ namespace atres
 				// remove spaces at beginning and end in wrapped formatting styles
 				if (wrapped && !untrimmed)
 				{
-					while (this->_line.words.size() > 0 && this->_line.words.first().spaces > 0)
+					while (context._line.words.size() > 0 && context._line.words.first().spaces > 0)
 					{
-						this->_line.words.removeFirst();
+						context._line.words.removeFirst();
 					}
-					while (this->_line.words.size() > 0 && this->_line.words.last().spaces > 0)
+					while (context._line.words.size() > 0 && context._line.words.last().spaces > 0)
 					{
-						this->_line.words.removeLast();
+						context._line.words.removeLast();
 					}
 				}
-				if (this->_line.words.size() > 0)
+				if (context._line.words.size() > 0)
 				{
-					bearingX = this->_line.words.first().bearingX;
-					x = this->_line.words.first().rect.x - bearingX;
-					this->_line.advanceX = -bearingX;
-					foreach (RenderWord, it, this->_line.words)
+					bearingX = context._line.words.first().bearingX;
+					x = context._line.words.first().rect.x - bearingX;
+					context._line.advanceX = -bearingX;
+					foreach (RenderWord, it, context._line.words)
 					{
-						this->_line.text += (*it).text;
-						this->_line.spaces += (*it).spaces;
-						this->_line.advanceX += (*it).advanceX;
+						context._line.text += (*it).text;
+						context._line.spaces += (*it).spaces;
+						context._line.advanceX += (*it).advanceX;
 						(*it).rect.x = x;
 						x += (*it).advanceX;
 					}
-					this->_line.rect.w = this->_line.advanceX + hmax(this->_line.words.last().rect.w - this->_line.words.last().advanceX, 0.0f);
+					context._line.rect.w = context._line.advanceX + hmax(context._line.words.last().rect.w - context._line.words.last().advanceX, 0.0f);
 				}
-				this->_line.rect.y = rect.y + this->_lines.size() * this->_lineHeight;
-				this->_line.rect.h = this->_lineHeight;
-				foreach (RenderWord, it, this->_line.words)
+				context._line.rect.y = rect.y + context._lines.size() * context._lineHeight;
+				context._line.rect.h = context._lineHeight;
+				foreach (RenderWord, it, context._line.words)
 				{
-					this->_line.rect.h = hmax(this->_line.rect.h, (*it).rect.h);
+					context._line.rect.h = hmax(context._line.rect.h, (*it).rect.h);
 				}
-				this->_line.terminated = forcedNextLine;
-				if (this->_line.words.size() > 0 || this->_line.terminated) // prevents empty lines with only spaces to be used
+				context._line.terminated = forcedNextLine;
+				if (context._line.words.size() > 0 || context._line.terminated) // prevents empty lines with only spaces to be used
 				{
-					this->_lines += this->_line;
+					// words and glyphs are swapped into the result instead of copying them
+					context._lines += RenderLine();
+					RenderLine& line = context._lines.last();
+					line.text = context._line.text;
+					line.rect = context._line.rect;
+					line.start = context._line.start;
+					line.count = context._line.count;
+					line.spaces = context._line.spaces;
+					line.advanceX = context._line.advanceX;
+					line.terminated = context._line.terminated;
+					line.words.swap(context._line.words);
+					line.glyphs.swap(context._line.glyphs);
 				}
 				// reset
-				this->_line.text = "";
-				this->_line.start = 0;
-				this->_line.count = 0;
-				this->_line.spaces = 0;
-				this->_line.advanceX = 0.0f;
-				this->_line.terminated = false;
-				this->_line.rect.w = 0.0f;
-				this->_line.words.clear();
+				context._line.text = "";
+				context._line.start = 0;
+				context._line.count = 0;
+				context._line.spaces = 0;
+				context._line.advanceX = 0.0f;
+				context._line.terminated = false;
+				context._line.rect.w = 0.0f;
+				context._line.words.clear();
+				context._line.glyphs.clear();
 				lineWidth = 0.0f;
 			}
 		}
-		if (this->_lines.size() > 0)
+		// swapping hands over the lines without copying them
+		result.clear();
+		result.swap(context._lines);
+	}
+
+	void Renderer::_placeRenderLines(harray<RenderLine>& lines, cgrectf rect, const Horizontal& horizontal, const Vertical& vertical, cgvec2f offset, float lineHeight, float descender, float internalDescender)
+	{
+		if (lines.size() == 0)
+		{
+			return;
+		}
+		if (rect.x != 0.0f || rect.y != 0.0f)
 		{
-			this->verticalCorrection(this->_lines, rect, vertical, offset.y, this->_lineHeight, this->_descender, this->_internalDescender);
-			this->_lines = this->removeOutOfBoundLines(this->_lines, rect);
-			if (this->_lines.size() > 0)
+			foreach (RenderLine, it, lines)
+			{
+				(*it).rect.x += rect.x;
+				(*it).rect.y += rect.y;
+				foreach (RenderWord, it2, (*it).words)
+				{
+					(*it2).rect.x += rect.x;
+					(*it2).rect.y += rect.y;
+				}
+			}
+		}
+		this->verticalCorrection(lines, rect, vertical, offset.y, lineHeight, descender, internalDescender);
+		this->removeOutOfBoundLines(lines, rect).swap(lines);
+		if (lines.size() > 0)
+		{
+			this->horizontalCorrection(lines, rect, horizontal, offset.x);
+		}
+	}
+
+	void Renderer::_makeRenderLines(LayoutContext& context, Cache<CacheEntryLineBreaks>* lineBreaksCache, Cache<CacheEntryWords>* wordsCache, const CacheEntryBasicText& entry, harray<RenderLine>& result, chstr text, const harray<FormatTag>& tags)
+	{
+		// only the wrapping mode of the alignment affects where lines are broken
+		Horizontal breakHorizontal = Horizontal::Left;
+		if (entry.horizontal.isWrapped())
+		{
+			breakHorizontal = (entry.horizontal.isUntrimmed() ? Horizontal::LeftWrappedUntrimmed : Horizontal::LeftWrapped);
+		}
+		this->_cacheEntryLineBreaksData.set(entry.text, entry.textHash, entry.fontName, grectf(0.0f, 0.0f, entry.rect.w, 0.0f), breakHorizontal, Vertical::Top, april::Color::White, gvec2f());
+		this->_cacheEntryLineBreaks = lineBreaksCache->get(this->_cacheEntryLineBreaksData);
+		if (this->_cacheEntryLineBreaks == NULL)
+		{
+			this->_cacheEntryLineBreaks = lineBreaksCache->add(this->_cacheEntryLineBreaksData);
+			if (!this->scaleInvariantLayout || !this->_createScaledLineBreaks(context, wordsCache, this->_cacheEntryLineBreaks->value, entry, text, tags, breakHorizontal))
 			{
-				this->horizontalCorrection(this->_lines, rect, horizontal, offset.x);
+				this->_createLineBreaks(context, this->_cacheEntryLineBreaks->value, entry.rect.w, text, tags, breakHorizontal);
 			}
+			this->_cacheEntryLineBreaks->lineHeight = context._lineHeight;
+			this->_cacheEntryLineBreaks->descender = context._descender;
+			this->_cacheEntryLineBreaks->internalDescender = context._internalDescender;
+			lineBreaksCache->update();
 		}
-		return this->_lines;
+		result = this->_cacheEntryLineBreaks->value;
+		this->_placeRenderLines(result, entry.rect, entry.horizontal, entry.vertical, entry.offset, this->_cacheEntryLineBreaks->lineHeight,
+			this->_cacheEntryLineBreaks->descender, this->_cacheEntryLineBreaks->internalDescender);
 	}
 	
 	RenderText Renderer::createRenderText(cgrectf rect, chstr text, const harray<RenderLine>& lines, const harray<FormatTag>& tags, const ColorData* colorData)
+	{
+		return this->createRenderText(this->layoutContext, rect, text, lines, tags, colorData);
+	}
+
+	RenderText Renderer::createRenderText(LayoutContext& context, cgrectf rect, chstr text, const harray<RenderLine>& lines, const harray<FormatTag>& tags, const ColorData* colorData)
+	{
+		RenderText result;
+		this->_createRenderText(context, result, rect, text, lines, tags, colorData);
+		return result;
+	}
+
+	void Renderer::_createRenderText(LayoutContext& context, RenderText& result, cgrectf rect, chstr text, const harray<RenderLine>& lines, const harray<FormatTag>& tags, const ColorData* colorData)
 	{
 		// by convention, the first tag is the font name
 		hstr firstFontName = tags.first().data.split(':').first();
@@ -1986,9 +2746,14 @@ namespace atres
 			firstFontName = this->getDefaultFontName();
 		}
 		this->analyzeText(tags.first().data, text);
-		this->_initializeFormatTags(tags);
-		this->_initializeRenderSequences();
-		this->_initializeLineProcessing(lines);
+		this->_preloadBorderCharacters(text, tags);
+		this->_initializeFormatTags(context, tags);
+		this->_initializeRenderSequences(context);
+		this->_initializeLineProcessing(context);
+		// usually there is one rectangle per byte at most, so the working sequence rarely needs to grow
+		context._textSequence.vertices.reserve(text.size() * 6);
+		context._textSequence.colors.reserve(text.size() * 6);
+		context._textSequence.glyphs.reserve(text.size());
 		// helper variables
 		int byteSize = 0;
 		float characterX = 0.0f;
@@ -2001,6 +2766,7 @@ namespace atres
 		april::Color colorBottomLeft;
 		april::Color colorBottomRight;
 		int index = 0;
+		CharacterDefinition* character = NULL;
 		float italicSkewOffset = 0.0f;
 		grectf boundingRect = rect;
 		if (colorData != NULL)
@@ -2009,174 +2775,175 @@ namespace atres
 			{
 				float minX = boundingRect.right();
 				float maxX = boundingRect.x;
-				for_iter (i, 0, this->_lines.size())
+				for_iter (i, 0, lines.size())
 				{
-					minX = hmin(minX, this->_lines[i].rect.x);
-					maxX = hmax(maxX, this->_lines[i].rect.right());
+					minX = hmin(minX, lines[i].rect.x);
+					maxX = hmax(maxX, lines[i].rect.right());
 				}
 				boundingRect.x = minX;
 				boundingRect.w = maxX - minX;
 			}
-			if (colorData->verticalColorFit && this->_lines.size() > 0)
+			if (colorData->verticalColorFit && lines.size() > 0)
 			{
-				float rectHeight = this->_lines.size() * this->_lines[0].rect.h;
+				float rectHeight = lines.size() * lines[0].rect.h;
 				boundingRect.y += (boundingRect.h - rectHeight) * 0.5f;
 				boundingRect.h = rectHeight;
 			}
 		}
 		// basic text with borders, shadows and icons
-		for_iter (j, 0, this->_lines.size())
+		for_iter (j, 0, lines.size())
 		{
-			this->_line = this->_lines[j];
-			foreach (RenderWord, it, this->_line.words)
+			// lines and words are only referenced, never copied
+			context._renderLine = &lines[j];
+			foreachc (RenderWord, it, context._renderLine->words)
 			{
-				this->_word = (*it);
+				context._renderWord = &(*it);
 				index = 0;
-				if (this->_word.icon)
+				if (context._renderWord->icon)
 				{
 					// checking first formatting tag changes
-					this->_processFormatTags(this->_word.text, 0);
-					this->_iconName = this->_fontIconName;
+					this->_processFormatTags(context, context._renderWord->text, 0);
+					context._iconName = context._fontIconName;
 					// if icon exists in current font
-					if (this->_icons.hasKey(this->_iconName) && !this->_hideActive)
+					if (context._icons.hasKey(context._iconName) && !context._hideActive)
 					{
 						// checking the particular character
-						this->_scale = this->_iconFontScale * this->_textScale;
-						this->_icon = this->_icons[this->_iconName];
-						this->_shadowOffset = this->shadowOffset * this->_textShadowOffset;
-						this->_borderThickness = this->borderThickness * this->_textBorderThickness;
-						this->_borderFontThickness = this->_borderThickness;
-						this->_strikeThroughThickness = this->strikeThroughThickness * this->_textStrikeThroughThickness;
-						this->_underlineThickness = this->underlineThickness * this->_textUnderlineThickness;
-						italicSkewOffset = (this->_italicActive ? this->_lineHeight * this->_italicSkewRatio : 0.0f);
-						area = this->_word.rect;
-						area.x += this->_word.charXs[index];
+						context._scale = context._iconFontScale * context._textScale;
+						context._icon = context._icons[context._iconName];
+						context._shadowOffset = this->shadowOffset * context._textShadowOffset;
+						context._borderThickness = this->borderThickness * context._textBorderThickness;
+						context._borderFontThickness = context._borderThickness;
+						context._strikeThroughThickness = this->strikeThroughThickness * context._textStrikeThroughThickness;
+						context._underlineThickness = this->underlineThickness * context._textUnderlineThickness;
+						italicSkewOffset = (context._italicActive ? context._lineHeight * context._italicSkewRatio : 0.0f);
+						area = context._renderWord->rect;
+						area.x += context._renderLine->glyphs.charXs[context._renderWord->glyphIndex + index];
 						characterX = area.x;
-						area.y += (this->_lineHeight - this->_height) * 0.5f + this->_iconFontOffsetY * this->_scale;
-						area.w = this->_icon->rect.w * this->_scale;
-						area.h = this->_icon->rect.h * this->_scale;
-						area.y += this->_lineHeight * (1.0f - this->_textScale) * 0.5f;
-						area.y += (this->_height - this->_icon->rect.h * this->_scale) * 0.5f;
-						area.y += this->_iconFontCustomFontOffsets.tryGet(firstFontName, 0.0f) * this->_scale;
+						area.y += (context._lineHeight - context._height) * 0.5f + context._iconFontOffsetY * context._scale;
+						area.w = context._icon->rect.w * context._scale;
+						area.h = context._icon->rect.h * context._scale;
+						area.y += context._lineHeight * (1.0f - context._textScale) * 0.5f;
+						area.y += (context._height - context._icon->rect.h * context._scale) * 0.5f;
+						area.y += context._iconFontCustomFontOffsets.tryGet(firstFontName, 0.0f) * context._scale;
 						drawRect = rect;
-						if (this->_iconFont != NULL)
+						if (context._iconFont != NULL)
 						{
-							this->_renderRect = this->_iconFont->makeRenderRectangle(drawRect, area, this->_iconName);
-							if (this->_renderRect.src.w > 0.0f && this->_renderRect.src.h > 0.0f && this->_renderRect.dest.w > 0.0f && this->_renderRect.dest.h > 0.0f)
+							context._renderRect = context._iconFont->makeRenderRectangle(drawRect, area, context._iconName);
+							if (context._renderRect.src.w > 0.0f && context._renderRect.src.h > 0.0f && context._renderRect.dest.w > 0.0f && context._renderRect.dest.h > 0.0f)
 							{
 								if (colorData == NULL)
 								{
-									this->_textSequence.addRenderRectangle(this->_renderRect, april::Color(this->_textColor, 255), italicSkewOffset);
+									context._textSequence.addRenderRectangle(context._renderRect, april::Color(context._textColor, 255), italicSkewOffset, context._glyphIndex);
 								}
 								else
 								{
-									this->_makeGradientColors(boundingRect, colorData, colorTopLeft, colorTopRight, colorBottomLeft, colorBottomRight);
-									this->_textSequence.addRenderRectangle(this->_renderRect, colorTopLeft, colorTopRight, colorBottomLeft, colorBottomRight, italicSkewOffset);
+									this->_makeGradientColors(context, boundingRect, colorData, colorTopLeft, colorTopRight, colorBottomLeft, colorBottomRight);
+									context._textSequence.addRenderRectangle(context._renderRect, colorTopLeft, colorTopRight, colorBottomLeft, colorBottomRight, italicSkewOffset, context._glyphIndex);
 								}
-								switch (this->_effectMode)
+								switch (context._effectMode)
 								{
 								case EFFECT_MODE_SHADOW: // shadow
-									this->_renderRect.dest += this->_shadowOffset * (this->globalOffsets ? 1.0f : this->_scale);
-									this->_shadowSequence.addRenderRectangle(this->_renderRect, this->_shadowColor, italicSkewOffset);
+									context._renderRect.dest += context._shadowOffset * (this->globalOffsets ? 1.0f : context._scale);
+									context._shadowSequence.addRenderRectangle(context._renderRect, context._shadowColor, italicSkewOffset, context._glyphIndex);
 									break;
 								case EFFECT_MODE_BORDER: // border
-									if (this->_iconFont->getBorderMode() == Font::BorderMode::Software || !this->_iconFont->hasBorderIcon(this->_iconName, this->_borderFontThickness))
+									if (context._iconFont->getBorderMode() == Font::BorderMode::Software || !context._iconFont->hasBorderIcon(context._iconName, context._borderFontThickness))
 									{
-										currentRect = this->_renderRect;
-										this->_renderRect.dest = currentRect.dest + gvec2f(-this->_borderThickness * sqrt05, -this->_borderThickness * sqrt05);
-										this->_borderSequence.addRenderRectangle(this->_renderRect, this->_borderColor, italicSkewOffset);
-										this->_renderRect.dest = currentRect.dest + gvec2f(this->_borderThickness * sqrt05, -this->_borderThickness * sqrt05);
-										this->_borderSequence.addRenderRectangle(this->_renderRect, this->_borderColor, italicSkewOffset);
-										this->_renderRect.dest = currentRect.dest + gvec2f(-this->_borderThickness * sqrt05, this->_borderThickness * sqrt05);
-										this->_borderSequence.addRenderRectangle(this->_renderRect, this->_borderColor, italicSkewOffset);
-										this->_renderRect.dest = currentRect.dest + gvec2f(this->_borderThickness * sqrt05, this->_borderThickness * sqrt05);
-										this->_borderSequence.addRenderRectangle(this->_renderRect, this->_borderColor, italicSkewOffset);
-										this->_renderRect.dest = currentRect.dest + gvec2f(0.0f, -this->_borderThickness);
-										this->_borderSequence.addRenderRectangle(this->_renderRect, this->_borderColor, italicSkewOffset);
-										this->_renderRect.dest = currentRect.dest + gvec2f(-this->_borderThickness, 0.0f);
-										this->_borderSequence.addRenderRectangle(this->_renderRect, this->_borderColor, italicSkewOffset);
-										this->_renderRect.dest = currentRect.dest + gvec2f(this->_borderThickness, 0.0f);
-										this->_borderSequence.addRenderRectangle(this->_renderRect, this->_borderColor, italicSkewOffset);
-										this->_renderRect.dest = currentRect.dest + gvec2f(0.0f, this->_borderThickness);
-										this->_borderSequence.addRenderRectangle(this->_renderRect, this->_borderColor, italicSkewOffset);
-										this->_borderSequence.multiplyAlpha = true;
+										currentRect = context._renderRect;
+										context._renderRect.dest = currentRect.dest + gvec2f(-context._borderThickness * sqrt05, -context._borderThickness * sqrt05);
+										context._borderSequence.addRenderRectangle(context._renderRect, context._borderColor, italicSkewOffset, context._glyphIndex);
+										context._renderRect.dest = currentRect.dest + gvec2f(context._borderThickness * sqrt05, -context._borderThickness * sqrt05);
+										context._borderSequence.addRenderRectangle(context._renderRect, context._borderColor, italicSkewOffset, context._glyphIndex);
+										context._renderRect.dest = currentRect.dest + gvec2f(-context._borderThickness * sqrt05, context._borderThickness * sqrt05);
+										context._borderSequence.addRenderRectangle(context._renderRect, context._borderColor, italicSkewOffset, context._glyphIndex);
+										context._renderRect.dest = currentRect.dest + gvec2f(context._borderThickness * sqrt05, context._borderThickness * sqrt05);
+										context._borderSequence.addRenderRectangle(context._renderRect, context._borderColor, italicSkewOffset, context._glyphIndex);
+										context._renderRect.dest = currentRect.dest + gvec2f(0.0f, -context._borderThickness);
+										context._borderSequence.addRenderRectangle(context._renderRect, context._borderColor, italicSkewOffset, context._glyphIndex);
+										context._renderRect.dest = currentRect.dest + gvec2f(-context._borderThickness, 0.0f);
+										context._borderSequence.addRenderRectangle(context._renderRect, context._borderColor, italicSkewOffset, context._glyphIndex);
+										context._renderRect.dest = currentRect.dest + gvec2f(context._borderThickness, 0.0f);
+										context._borderSequence.addRenderRectangle(context._renderRect, context._borderColor, italicSkewOffset, context._glyphIndex);
+										context._renderRect.dest = currentRect.dest + gvec2f(0.0f, context._borderThickness);
+										context._borderSequence.addRenderRectangle(context._renderRect, context._borderColor, italicSkewOffset, context._glyphIndex);
+										context._borderSequence.multiplyAlpha = true;
 									}
 									else
 									{
-										this->_borderIcon = this->_iconFont->getBorderIcon(this->_iconName, this->_borderFontThickness);
-										area = this->_word.rect;
-										rectSize = (this->_borderIcon->rect.getSize() - this->_icon->rect.getSize()) * 0.5f * this->_scale;
-										area.x += this->_word.charXs[index] - rectSize.x;
-										area.y += (this->_lineHeight - this->_height) * 0.5f + this->_iconFontOffsetY * this->_scale - rectSize.y;
-										area.w = this->_borderIcon->rect.w * this->_scale;
-										area.h = this->_borderIcon->rect.h * this->_scale;
-										area.y += this->_lineHeight * (1.0f - this->_textScale) * 0.5f;
-										area.y += (this->_height - this->_icon->rect.h * this->_scale) * 0.5f;
-										area.y += this->_iconFontCustomFontOffsets.tryGet(firstFontName, 0.0f) * this->_scale;
+										context._borderIcon = context._iconFont->getBorderIcon(context._iconName, context._borderFontThickness);
+										area = context._renderWord->rect;
+										rectSize = (context._borderIcon->rect.getSize() - context._icon->rect.getSize()) * 0.5f * context._scale;
+										area.x += context._renderLine->glyphs.charXs[context._renderWord->glyphIndex + index] - rectSize.x;
+										area.y += (context._lineHeight - context._height) * 0.5f + context._iconFontOffsetY * context._scale - rectSize.y;
+										area.w = context._borderIcon->rect.w * context._scale;
+										area.h = context._borderIcon->rect.h * context._scale;
+										area.y += context._lineHeight * (1.0f - context._textScale) * 0.5f;
+										area.y += (context._height - context._icon->rect.h * context._scale) * 0.5f;
+										area.y += context._iconFontCustomFontOffsets.tryGet(firstFontName, 0.0f) * context._scale;
 										drawRect.x -= rectSize.x;
 										drawRect.y -= rectSize.y;
 										drawRect.w += rectSize.x * 2.0f;
 										drawRect.h += rectSize.y * 2.0f;
-										this->_renderRect = this->_iconFont->makeBorderRenderRectangle(drawRect, area, this->_iconName, this->_borderFontThickness);
-										this->_borderSequence.addRenderRectangle(this->_renderRect, this->_borderColor, italicSkewOffset);
-										this->_borderSequence.texture = this->_iconFont->getBorderTexture(this->_iconName, this->_borderFontThickness);
-										this->_borderSequence.multiplyAlpha = false;
+										context._renderRect = context._iconFont->makeBorderRenderRectangle(drawRect, area, context._iconName, context._borderFontThickness);
+										context._borderSequence.addRenderRectangle(context._renderRect, context._borderColor, italicSkewOffset, context._glyphIndex);
+										context._borderSequence.texture = context._iconFont->getBorderTexture(context._iconName, context._borderFontThickness);
+										context._borderSequence.multiplyAlpha = false;
 									}
 									break;
 								default:
 									break;
 								}
-								this->_updateLiningSequenceSwitch();
-								if (this->_strikeThroughActive)
+								this->_updateLiningSequenceSwitch(context);
+								if (context._strikeThroughActive)
 								{
-									this->_liningRect.x = characterX;
-									this->_liningRect.y = this->_word.rect.y + (this->_height - this->_strikeThroughThickness) * 0.5f + this->_strikeThroughOffset;
-									this->_liningRect.w = this->_word.charAdvanceXs[index];
-									this->_liningRect.h = this->_strikeThroughThickness;
-									this->_liningRect.clip(rect);
-									if (this->_liningRect.w > 0.0f && this->_liningRect.h > 0.0f)
+									context._liningRect.x = characterX;
+									context._liningRect.y = context._renderWord->rect.y + (context._height - context._strikeThroughThickness) * 0.5f + context._strikeThroughOffset;
+									context._liningRect.w = context._renderLine->glyphs.charAdvanceXs[context._renderWord->glyphIndex + index];
+									context._liningRect.h = context._strikeThroughThickness;
+									context._liningRect.clip(rect);
+									if (context._liningRect.w > 0.0f && context._liningRect.h > 0.0f)
 									{
-										this->_textStrikeThroughSequence.addRectangle(this->_liningRect);
-										switch (this->_effectMode)
+										context._textStrikeThroughSequence.addRectangle(context._liningRect, context._glyphIndex);
+										switch (context._effectMode)
 										{
 										case EFFECT_MODE_SHADOW: // shadow
-											this->_liningRect += this->_shadowOffset * (this->globalOffsets ? 1.0f : this->_scale);
-											this->_shadowStrikeThroughSequence.addRectangle(this->_liningRect);
+											context._liningRect += context._shadowOffset * (this->globalOffsets ? 1.0f : context._scale);
+											context._shadowStrikeThroughSequence.addRectangle(context._liningRect, context._glyphIndex);
 											break;
 										case EFFECT_MODE_BORDER: // border
-											this->_liningRect.x -= this->_borderThickness;
-											this->_liningRect.y -= this->_borderThickness;
-											this->_liningRect.w += this->_borderThickness * 2.0f;
-											this->_liningRect.h += this->_borderThickness * 2.0f;
-											this->_borderStrikeThroughSequence.addRectangle(this->_liningRect);
+											context._liningRect.x -= context._borderThickness;
+											context._liningRect.y -= context._borderThickness;
+											context._liningRect.w += context._borderThickness * 2.0f;
+											context._liningRect.h += context._borderThickness * 2.0f;
+											context._borderStrikeThroughSequence.addRectangle(context._liningRect, context._glyphIndex);
 											break;
 										default:
 											break;
 										}
 									}
 								}
-								if (this->_underlineActive)
+								if (context._underlineActive)
 								{
-									this->_liningRect.x = characterX;
-									this->_liningRect.y = this->_word.rect.y + this->_height + this->_underlineOffset;
-									this->_liningRect.w = this->_word.charAdvanceXs[index];
-									this->_liningRect.h = this->_underlineThickness;
-									this->_liningRect.clip(rect);
-									if (this->_liningRect.w > 0.0f && this->_liningRect.h > 0.0f)
+									context._liningRect.x = characterX;
+									context._liningRect.y = context._renderWord->rect.y + context._height + context._underlineOffset;
+									context._liningRect.w = context._renderLine->glyphs.charAdvanceXs[context._renderWord->glyphIndex + index];
+									context._liningRect.h = context._underlineThickness;
+									context._liningRect.clip(rect);
+									if (context._liningRect.w > 0.0f && context._liningRect.h > 0.0f)
 									{
-										this->_textUnderlineSequence.addRectangle(this->_liningRect);
-										switch (this->_effectMode)
+										context._textUnderlineSequence.addRectangle(context._liningRect, context._glyphIndex);
+										switch (context._effectMode)
 										{
 										case EFFECT_MODE_SHADOW: // shadow
-											this->_liningRect += this->_shadowOffset * (this->globalOffsets ? 1.0f : this->_scale);
-											this->_shadowUnderlineSequence.addRectangle(this->_liningRect);
+											context._liningRect += context._shadowOffset * (this->globalOffsets ? 1.0f : context._scale);
+											context._shadowUnderlineSequence.addRectangle(context._liningRect, context._glyphIndex);
 											break;
 										case EFFECT_MODE_BORDER: // border
-											this->_liningRect.x -= this->_borderThickness;
-											this->_liningRect.y -= this->_borderThickness;
-											this->_liningRect.w += this->_borderThickness * 2.0f;
-											this->_liningRect.h += this->_borderThickness * 2.0f;
-											this->_borderUnderlineSequence.addRectangle(this->_liningRect);
+											context._liningRect.x -= context._borderThickness;
+											context._liningRect.y -= context._borderThickness;
+											context._liningRect.w += context._borderThickness * 2.0f;
+											context._liningRect.h += context._borderThickness * 2.0f;
+											context._borderUnderlineSequence.addRectangle(context._liningRect, context._glyphIndex);
 											break;
 										default:
 											break;
@@ -2186,156 +2953,158 @@ namespace atres
 							}
 						}
 					}
+					++context._glyphIndex;
 				}
 				else
 				{
-					for_iter_step (i, 0, this->_word.text.size(), byteSize)
+					for_iter_step (i, 0, context._renderWord->text.size(), byteSize)
 					{
-						this->_code = this->_word.text.firstUnicodeChar(i, &byteSize);
+						context._code = _decodeChar(context._renderWord->text, context._renderWord->text.cStr(), i, &byteSize);
 						// checking first formatting tag changes
-						this->_processFormatTags(this->_word.text, i);
+						this->_processFormatTags(context, context._renderWord->text, i);
 						// if character exists in current font
-						if (this->_characters.hasKey(this->_code) && !this->_hideActive)
+						character = (!context._hideActive ? this->_findCharacter(context, context._code) : NULL);
+						if (character != NULL)
 						{
 							// checking the particular character
-							this->_scale = this->_fontScale * this->_textScale;
-							this->_character = this->_characters[this->_code];
-							this->_shadowOffset = this->shadowOffset * this->_textShadowOffset;
-							this->_borderThickness = this->borderThickness * this->_textBorderThickness;
-							this->_borderFontThickness = this->_borderThickness / this->_fontBaseScale;
-							this->_strikeThroughThickness = this->strikeThroughThickness * this->_textStrikeThroughThickness;
-							this->_underlineThickness = this->underlineThickness * this->_textUnderlineThickness;
-							italicSkewOffset = (this->_italicActive ? this->_lineHeight * this->_italicSkewRatio : 0.0f);
-							area = this->_word.rect;
-							area.x += this->_word.charXs[index];
+							context._scale = context._fontScale * context._textScale;
+							context._character = character;
+							context._shadowOffset = this->shadowOffset * context._textShadowOffset;
+							context._borderThickness = this->borderThickness * context._textBorderThickness;
+							context._borderFontThickness = context._borderThickness / context._fontBaseScale;
+							context._strikeThroughThickness = this->strikeThroughThickness * context._textStrikeThroughThickness;
+							context._underlineThickness = this->underlineThickness * context._textUnderlineThickness;
+							italicSkewOffset = (context._italicActive ? context._lineHeight * context._italicSkewRatio : 0.0f);
+							area = context._renderWord->rect;
+							area.x += context._renderLine->glyphs.charXs[context._renderWord->glyphIndex + index];
 							characterX = area.x;
-							area.y += (this->_lineHeight - this->_height) * 0.5f + this->_character->offsetY * this->_scale;
-							area.w = this->_character->rect.w * this->_scale;
-							area.h = this->_character->rect.h * this->_scale;
-							area.y += this->_lineHeight * (1.0f - this->_textScale) * 0.5f;
+							area.y += (context._lineHeight - context._height) * 0.5f + context._character->offsetY * context._scale;
+							area.w = context._character->rect.w * context._scale;
+							area.h = context._character->rect.h * context._scale;
+							area.y += context._lineHeight * (1.0f - context._textScale) * 0.5f;
 							drawRect = rect;
 							// optimization, don't render spaces, but do render their strike-throughs and underlines
-							if (this->_font != NULL && ((this->_code != UNICODE_CHAR_SPACE && this->_code != UNICODE_CHAR_ZERO_WIDTH_SPACE) || this->_strikeThroughActive || this->_underlineActive))
+							if (context._font != NULL && ((context._code != UNICODE_CHAR_SPACE && context._code != UNICODE_CHAR_ZERO_WIDTH_SPACE) || context._strikeThroughActive || context._underlineActive))
 							{
-								this->_renderRect = this->_font->makeRenderRectangle(drawRect, area, this->_code);
-								if (this->_renderRect.src.w > 0.0f && this->_renderRect.src.h > 0.0f && this->_renderRect.dest.w > 0.0f && this->_renderRect.dest.h > 0.0f)
+								context._renderRect = context._font->makeRenderRectangle(drawRect, area, context._code);
+								if (context._renderRect.src.w > 0.0f && context._renderRect.src.h > 0.0f && context._renderRect.dest.w > 0.0f && context._renderRect.dest.h > 0.0f)
 								{
-									if (this->_code != UNICODE_CHAR_SPACE && this->_code != UNICODE_CHAR_ZERO_WIDTH_SPACE)
+									if (context._code != UNICODE_CHAR_SPACE && context._code != UNICODE_CHAR_ZERO_WIDTH_SPACE)
 									{
-										this->_renderRect.dest.y -= this->_character->bearing.y * this->_scale;
+										context._renderRect.dest.y -= context._character->bearing.y * context._scale;
 										if (colorData == NULL)
 										{
-											this->_textSequence.addRenderRectangle(this->_renderRect, april::Color(this->_textColor, 255), italicSkewOffset);
+											context._textSequence.addRenderRectangle(context._renderRect, april::Color(context._textColor, 255), italicSkewOffset, context._glyphIndex);
 										}
 										else
 										{
-											this->_makeGradientColors(boundingRect, colorData, colorTopLeft, colorTopRight, colorBottomLeft, colorBottomRight);
-											this->_textSequence.addRenderRectangle(this->_renderRect, colorTopLeft, colorTopRight, colorBottomLeft, colorBottomRight, italicSkewOffset);
+											this->_makeGradientColors(context, boundingRect, colorData, colorTopLeft, colorTopRight, colorBottomLeft, colorBottomRight);
+											context._textSequence.addRenderRectangle(context._renderRect, colorTopLeft, colorTopRight, colorBottomLeft, colorBottomRight, italicSkewOffset, context._glyphIndex);
 										}
-										switch (this->_effectMode)
+										switch (context._effectMode)
 										{
 										case EFFECT_MODE_SHADOW: // shadow
-											this->_renderRect.dest += this->_shadowOffset * (this->globalOffsets ? 1.0f : this->_scale);
-											this->_shadowSequence.addRenderRectangle(this->_renderRect, this->_shadowColor, italicSkewOffset);
+											context._renderRect.dest += context._shadowOffset * (this->globalOffsets ? 1.0f : context._scale);
+											context._shadowSequence.addRenderRectangle(context._renderRect, context._shadowColor, italicSkewOffset, context._glyphIndex);
 											break;
 										case EFFECT_MODE_BORDER: // border
-											if (this->_font->getBorderMode() == Font::BorderMode::Software || !this->_font->hasBorderCharacter(this->_code, this->_borderFontThickness))
+											if (context._font->getBorderMode() == Font::BorderMode::Software || !context._font->hasBorderCharacter(context._code, context._borderFontThickness))
 											{
-												currentRect = this->_renderRect;
-												this->_renderRect.dest = currentRect.dest + gvec2f(-this->_borderThickness * sqrt05, -this->_borderThickness * sqrt05);
-												this->_borderSequence.addRenderRectangle(this->_renderRect, this->_borderColor, italicSkewOffset);
-												this->_renderRect.dest = currentRect.dest + gvec2f(this->_borderThickness * sqrt05, -this->_borderThickness * sqrt05);
-												this->_borderSequence.addRenderRectangle(this->_renderRect, this->_borderColor, italicSkewOffset);
-												this->_renderRect.dest = currentRect.dest + gvec2f(-this->_borderThickness * sqrt05, this->_borderThickness * sqrt05);
-												this->_borderSequence.addRenderRectangle(this->_renderRect, this->_borderColor, italicSkewOffset);
-												this->_renderRect.dest = currentRect.dest + gvec2f(this->_borderThickness * sqrt05, this->_borderThickness * sqrt05);
-												this->_borderSequence.addRenderRectangle(this->_renderRect, this->_borderColor, italicSkewOffset);
-												this->_renderRect.dest = currentRect.dest + gvec2f(0.0f, -this->_borderThickness);
-												this->_borderSequence.addRenderRectangle(this->_renderRect, this->_borderColor, italicSkewOffset);
-												this->_renderRect.dest = currentRect.dest + gvec2f(-this->_borderThickness, 0.0f);
-												this->_borderSequence.addRenderRectangle(this->_renderRect, this->_borderColor, italicSkewOffset);
-												this->_renderRect.dest = currentRect.dest + gvec2f(this->_borderThickness, 0.0f);
-												this->_borderSequence.addRenderRectangle(this->_renderRect, this->_borderColor, italicSkewOffset);
-												this->_renderRect.dest = currentRect.dest + gvec2f(0.0f, this->_borderThickness);
-												this->_borderSequence.addRenderRectangle(this->_renderRect, this->_borderColor, italicSkewOffset);
-												this->_borderSequence.multiplyAlpha = true;
+												currentRect = context._renderRect;
+												context._renderRect.dest = currentRect.dest + gvec2f(-context._borderThickness * sqrt05, -context._borderThickness * sqrt05);
+												context._borderSequence.addRenderRectangle(context._renderRect, context._borderColor, italicSkewOffset, context._glyphIndex);
+												context._renderRect.dest = currentRect.dest + gvec2f(context._borderThickness * sqrt05, -context._borderThickness * sqrt05);
+												context._borderSequence.addRenderRectangle(context._renderRect, context._borderColor, italicSkewOffset, context._glyphIndex);
+												context._renderRect.dest = currentRect.dest + gvec2f(-context._borderThickness * sqrt05, context._borderThickness * sqrt05);
+												context._borderSequence.addRenderRectangle(context._renderRect, context._borderColor, italicSkewOffset, context._glyphIndex);
+												context._renderRect.dest = currentRect.dest + gvec2f(context._borderThickness * sqrt05, context._borderThickness * sqrt05);
+												context._borderSequence.addRenderRectangle(context._renderRect, context._borderColor, italicSkewOffset, context._glyphIndex);
+												context._renderRect.dest = currentRect.dest + gvec2f(0.0f, -context._borderThickness);
+												context._borderSequence.addRenderRectangle(context._renderRect, context._borderColor, italicSkewOffset, context._glyphIndex);
+												context._renderRect.dest = currentRect.dest + gvec2f(-context._borderThickness, 0.0f);
+												context._borderSequence.addRenderRectangle(context._renderRect, context._borderColor, italicSkewOffset, context._glyphIndex);
+												context._renderRect.dest = currentRect.dest + gvec2f(context._borderThickness, 0.0f);
+												context._borderSequence.addRenderRectangle(context._renderRect, context._borderColor, italicSkewOffset, context._glyphIndex);
+												context._renderRect.dest = currentRect.dest + gvec2f(0.0f, context._borderThickness);
+												context._borderSequence.addRenderRectangle(context._renderRect, context._borderColor, italicSkewOffset, context._glyphIndex);
+												context._borderSequence.multiplyAlpha = true;
 											}
 											else
 											{
-												this->_borderCharacter = this->_font->getBorderCharacter(this->_code, this->_borderFontThickness);
-												area = this->_word.rect;
-												rectSize = (this->_borderCharacter->rect.getSize() - this->_character->rect.getSize()) * 0.5f * this->_scale;
-												area.x += this->_word.charXs[index] - rectSize.x;
-												area.y += (this->_lineHeight - this->_height) * 0.5f + this->_character->offsetY * this->_scale - rectSize.y;
-												area.w = this->_borderCharacter->rect.w * this->_scale;
-												area.h = this->_borderCharacter->rect.h * this->_scale;
-												area.y += this->_lineHeight * (1.0f - this->_textScale) * 0.5f;
+												context._borderCharacter = context._font->getBorderCharacter(context._code, context._borderFontThickness);
+												area = context._renderWord->rect;
+												rectSize = (context._borderCharacter->rect.getSize() - context._character->rect.getSize()) * 0.5f * context._scale;
+												area.x += context._renderLine->glyphs.charXs[context._renderWord->glyphIndex + index] - rectSize.x;
+												area.y += (context._lineHeight - context._height) * 0.5f + context._character->offsetY * context._scale - rectSize.y;
+												area.w = context._borderCharacter->rect.w * context._scale;
+												area.h = context._borderCharacter->rect.h * context._scale;
+												area.y += context._lineHeight * (1.0f - context._textScale) * 0.5f;
 												drawRect.x -= rectSize.x;
 												drawRect.y -= rectSize.y;
 												drawRect.w += rectSize.x * 2.0f;
 												drawRect.h += rectSize.y * 2.0f;
-												this->_renderRect = this->_font->makeBorderRenderRectangle(drawRect, area, this->_code, this->_borderFontThickness);
-												this->_renderRect.dest.y -= this->_character->bearing.y * this->_scale;
-												this->_borderSequence.addRenderRectangle(this->_renderRect, this->_borderColor, italicSkewOffset);
-												this->_borderSequence.texture = this->_font->getBorderTexture(this->_code, this->_borderFontThickness);
-												this->_borderSequence.multiplyAlpha = false;
+												context._renderRect = context._font->makeBorderRenderRectangle(drawRect, area, context._code, context._borderFontThickness);
+												context._renderRect.dest.y -= context._character->bearing.y * context._scale;
+												context._borderSequence.addRenderRectangle(context._renderRect, context._borderColor, italicSkewOffset, context._glyphIndex);
+												context._borderSequence.texture = context._font->getBorderTexture(context._code, context._borderFontThickness);
+												context._borderSequence.multiplyAlpha = false;
 											}
 											break;
 										default:
 											break;
 										}
 									}
-									this->_updateLiningSequenceSwitch();
-									if (this->_strikeThroughActive)
+									this->_updateLiningSequenceSwitch(context);
+									if (context._strikeThroughActive)
 									{
-										this->_liningRect.x = characterX;
-										this->_liningRect.y = this->_word.rect.y + (this->_height - this->_strikeThroughThickness) * 0.5f + this->_strikeThroughOffset;
-										this->_liningRect.w = this->_word.charAdvanceXs[index];
-										this->_liningRect.h = this->_strikeThroughThickness;
-										this->_liningRect.clip(rect);
-										if (this->_liningRect.w > 0.0f && this->_liningRect.h > 0.0f)
+										context._liningRect.x = characterX;
+										context._liningRect.y = context._renderWord->rect.y + (context._height - context._strikeThroughThickness) * 0.5f + context._strikeThroughOffset;
+										context._liningRect.w = context._renderLine->glyphs.charAdvanceXs[context._renderWord->glyphIndex + index];
+										context._liningRect.h = context._strikeThroughThickness;
+										context._liningRect.clip(rect);
+										if (context._liningRect.w > 0.0f && context._liningRect.h > 0.0f)
 										{
-											this->_textStrikeThroughSequence.addRectangle(this->_liningRect);
-											switch (this->_effectMode)
+											context._textStrikeThroughSequence.addRectangle(context._liningRect, context._glyphIndex);
+											switch (context._effectMode)
 											{
 											case EFFECT_MODE_SHADOW: // shadow
-												this->_liningRect += this->_shadowOffset * (this->globalOffsets ? 1.0f : this->_scale);
-												this->_shadowStrikeThroughSequence.addRectangle(this->_liningRect);
+												context._liningRect += context._shadowOffset * (this->globalOffsets ? 1.0f : context._scale);
+												context._shadowStrikeThroughSequence.addRectangle(context._liningRect, context._glyphIndex);
 												break;
 											case EFFECT_MODE_BORDER: // border
-												this->_liningRect.x -= this->_borderThickness;
-												this->_liningRect.y -= this->_borderThickness;
-												this->_liningRect.w += this->_borderThickness * 2.0f;
-												this->_liningRect.h += this->_borderThickness * 2.0f;
-												this->_borderStrikeThroughSequence.addRectangle(this->_liningRect);
+												context._liningRect.x -= context._borderThickness;
+												context._liningRect.y -= context._borderThickness;
+												context._liningRect.w += context._borderThickness * 2.0f;
+												context._liningRect.h += context._borderThickness * 2.0f;
+												context._borderStrikeThroughSequence.addRectangle(context._liningRect, context._glyphIndex);
 												break;
 											default:
 												break;
 											}
 										}
 									}
-									if (this->_underlineActive)
+									if (context._underlineActive)
 									{
-										this->_liningRect.x = characterX;
-										this->_liningRect.y = this->_word.rect.y + this->_height + this->_underlineOffset;
-										this->_liningRect.w = this->_word.charAdvanceXs[index];
-										this->_liningRect.h = this->_underlineThickness;
-										this->_liningRect.clip(rect);
-										if (this->_liningRect.w > 0.0f && this->_liningRect.h > 0.0f)
+										context._liningRect.x = characterX;
+										context._liningRect.y = context._renderWord->rect.y + context._height + context._underlineOffset;
+										context._liningRect.w = context._renderLine->glyphs.charAdvanceXs[context._renderWord->glyphIndex + index];
+										context._liningRect.h = context._underlineThickness;
+										context._liningRect.clip(rect);
+										if (context._liningRect.w > 0.0f && context._liningRect.h > 0.0f)
 										{
-											this->_textUnderlineSequence.addRectangle(this->_liningRect);
-											switch (this->_effectMode)
+											context._textUnderlineSequence.addRectangle(context._liningRect, context._glyphIndex);
+											switch (context._effectMode)
 											{
 											case EFFECT_MODE_SHADOW: // shadow
-												this->_liningRect += this->_shadowOffset * (this->globalOffsets ? 1.0f : this->_scale);
-												this->_shadowUnderlineSequence.addRectangle(this->_liningRect);
+												context._liningRect += context._shadowOffset * (this->globalOffsets ? 1.0f : context._scale);
+												context._shadowUnderlineSequence.addRectangle(context._liningRect, context._glyphIndex);
 												break;
 											case EFFECT_MODE_BORDER: // border
-												this->_liningRect.x -= this->_borderThickness;
-												this->_liningRect.y -= this->_borderThickness;
-												this->_liningRect.w += this->_borderThickness * 2.0f;
-												this->_liningRect.h += this->_borderThickness * 2.0f;
-												this->_borderUnderlineSequence.addRectangle(this->_liningRect);
+												context._liningRect.x -= context._borderThickness;
+												context._liningRect.y -= context._borderThickness;
+												context._liningRect.w += context._borderThickness * 2.0f;
+												context._liningRect.h += context._borderThickness * 2.0f;
+												context._borderUnderlineSequence.addRectangle(context._liningRect, context._glyphIndex);
 												break;
 											default:
 												break;
@@ -2346,44 +3115,52 @@ namespace atres
 							}
 						}
 						++index;
+						++context._glyphIndex;
 					}
 				}
 			}
 		}
-		if (this->_textSequence.vertices.size() > 0)
+		if (context._textSequence.vertices.size() > 0)
 		{
-			this->_textSequences += this->_textSequence;
-			this->_textSequence.clear();
+			context._textSequences += context._textSequence;
+			context._textSequence.clear();
 		}
-		if (this->_shadowSequence.vertices.size() > 0)
+		if (context._shadowSequence.vertices.size() > 0)
 		{
-			this->_shadowSequences += this->_shadowSequence;
-			this->_shadowSequence.clear();
+			context._shadowSequences += context._shadowSequence;
+			context._shadowSequence.clear();
 		}
-		if (this->_borderSequence.vertices.size() > 0)
+		if (context._borderSequence.vertices.size() > 0)
 		{
-			this->_borderSequences += this->_borderSequence;
-			this->_borderSequence.clear();
+			context._borderSequences += context._borderSequence;
+			context._borderSequence.clear();
 		}
-		this->_updateLiningSequenceSwitch(true);
+		this->_updateLiningSequenceSwitch(context, true);
 		// clear data and optimizations
-		this->_lines.clear();
-		RenderText result;
-		result.textSequences = this->optimizeSequences(this->_textSequences);
-		result.shadowSequences = this->optimizeSequences(this->_shadowSequences);
-		result.borderSequences = this->optimizeSequences(this->_borderSequences);
-		result.textLiningSequences = this->optimizeSequences(this->_textLiningSequences);
-		result.shadowLiningSequences = this->optimizeSequences(this->_shadowLiningSequences);
-		result.borderLiningSequences = this->optimizeSequences(this->_borderLiningSequences);
-		return result;
+		context._renderLine = NULL;
+		context._renderWord = NULL;
+		this->optimizeSequences(context._textSequences).swap(result.textSequences);
+		this->optimizeSequences(context._shadowSequences).swap(result.shadowSequences);
+		this->optimizeSequences(context._borderSequences).swap(result.borderSequences);
+		this->optimizeSequences(context._textLiningSequences).swap(result.textLiningSequences);
+		this->optimizeSequences(context._shadowLiningSequences).swap(result.shadowLiningSequences);
+		this->optimizeSequences(context._borderLiningSequences).swap(result.borderLiningSequences);
+		result.fonts = context._renderFonts;
+		result.textureGenerations.clear();
+		foreach (Font*, it, context._renderFonts)
+		{
+			result.textureGenerations += (*it)->getTextureGeneration();
+		}
+		context._renderFonts.clear();
+		result.glyphCount = context._glyphIndex;
 	}
 
-	void Renderer::_makeGradientColors(cgrectf drawRect, const ColorData* colorData, april::Color& topLeft, april::Color& topRight, april::Color& bottomLeft, april::Color& bottomRight)
+	void Renderer::_makeGradientColors(LayoutContext& context, cgrectf drawRect, const ColorData* colorData, april::Color& topLeft, april::Color& topRight, april::Color& bottomLeft, april::Color& bottomRight)
 	{
-		float ratioLeft = hclamp((this->_renderRect.dest.x - drawRect.x) / drawRect.w, 0.0f, 1.0f);
-		float ratioRight = hclamp((this->_renderRect.dest.right() - drawRect.x) / drawRect.w, 0.0f, 1.0f);
-		float ratioTop = hclamp((this->_renderRect.dest.y - drawRect.y) / drawRect.h, 0.0f, 1.0f);
-		float ratioBottom = hclamp((this->_renderRect.dest.bottom() - drawRect.y) / drawRect.h, 0.0f, 1.0f);
+		float ratioLeft = hclamp((context._renderRect.dest.x - drawRect.x) / drawRect.w, 0.0f, 1.0f);
+		float ratioRight = hclamp((context._renderRect.dest.right() - drawRect.x) / drawRect.w, 0.0f, 1.0f);
+		float ratioTop = hclamp((context._renderRect.dest.y - drawRect.y) / drawRect.h, 0.0f, 1.0f);
+		float ratioBottom = hclamp((context._renderRect.dest.bottom() - drawRect.y) / drawRect.h, 0.0f, 1.0f);
 		topLeft = (colorData->colorTopLeft * (1 - ratioLeft) + colorData->colorTopRight * ratioLeft) * (1 - ratioTop) +
 			(colorData->colorBottomLeft * (1 - ratioLeft) + colorData->colorBottomRight * ratioLeft) * ratioTop;
 		topLeft.a = 255;
@@ -2401,42 +3178,81 @@ namespace atres
 	harray<RenderSequence> Renderer::optimizeSequences(harray<RenderSequence>& sequences)
 	{
 		harray<RenderSequence> result;
-		RenderSequence current;
-		while (sequences.size() > 0)
+		int size = sequences.size();
+		harray<int> merged(0, size);
+		int vertexCount = 0;
+		for_iter (i, 0, size)
 		{
-			current = sequences.removeFirst();
-			for_iter (i, 0, sequences.size())
+			if (merged[i] != 0)
 			{
-				if (current.texture == sequences[i].texture && current.multiplyAlpha == sequences[i].multiplyAlpha)
+				continue;
+			}
+			// the final size is determined first so every merged sequence is allocated only once
+			vertexCount = 0;
+			for_iter (j, i, size)
+			{
+				if (merged[j] == 0 && sequences[i].texture == sequences[j].texture && sequences[i].multiplyAlpha == sequences[j].multiplyAlpha)
 				{
-					current.mergeFrom(sequences[i]);
-					sequences.removeAt(i);
-					--i;
+					vertexCount += sequences[j].vertices.size();
+				}
+			}
+			result += RenderSequence();
+			RenderSequence& current = result.last();
+			current.texture = sequences[i].texture;
+			current.multiplyAlpha = sequences[i].multiplyAlpha;
+			current.vertices.reserve(vertexCount);
+			current.colors.reserve(vertexCount);
+			current.glyphs.reserve(vertexCount / 6);
+			for_iter (j, i, size)
+			{
+				if (merged[j] == 0 && current.texture == sequences[j].texture && current.multiplyAlpha == sequences[j].multiplyAlpha)
+				{
+					current.mergeFrom(sequences[j]);
+					merged[j] = 1;
 				}
 			}
-			result += current;
 		}
+		sequences.clear();
 		return result;
 	}
 
 	harray<RenderLiningSequence> Renderer::optimizeSequences(harray<RenderLiningSequence>& sequences)
 	{
 		harray<RenderLiningSequence> result;
-		RenderLiningSequence current;
-		while (sequences.size() > 0)
+		int size = sequences.size();
+		harray<int> merged(0, size);
+		int vertexCount = 0;
+		for_iter (i, 0, size)
 		{
-			current = sequences.removeFirst();
-			for_iter (i, 0, sequences.size())
+			if (merged[i] != 0)
+			{
+				continue;
+			}
+			// the final size is determined first so every merged sequence is allocated only once
+			vertexCount = 0;
+			for_iter (j, i, size)
 			{
-				if (current.color.hex(true) == sequences[i].color.hex(true))
+				if (merged[j] == 0 && sequences[i].color.hex(true) == sequences[j].color.hex(true))
 				{
-					current.mergeFrom(sequences[i]);
-					sequences.removeAt(i);
-					--i;
+					vertexCount += sequences[j].vertices.size();
+				}
+			}
+			result += RenderLiningSequence();
+			RenderLiningSequence& current = result.last();
+			current.color = sequences[i].color;
+			current.vertices.reserve(vertexCount);
+			current.glyphs.reserve(vertexCount / 6);
+			current.lastGlyphs.reserve(vertexCount / 6);
+			for_iter (j, i, size)
+			{
+				if (merged[j] == 0 && current.color.hex(true) == sequences[j].color.hex(true))
+				{
+					current.mergeFrom(sequences[j]);
+					merged[j] = 1;
 				}
 			}
-			result += current;
 		}
+		sequences.clear();
 		return result;
 	}
 
@@ -2491,9 +3307,93 @@ namespace atres
 		}
 	}
 
-	void Renderer::_drawRenderSequence(RenderSequence& sequence, unsigned char alpha)
+	void Renderer::_drawRenderText(RenderText& renderText, const april::Color& color, int glyphCount)
+	{
+		if (glyphCount >= renderText.glyphCount)
+		{
+			this->_drawRenderText(renderText, color);
+			return;
+		}
+		if (glyphCount <= 0)
+		{
+			return;
+		}
+		foreach (RenderSequence, it, renderText.shadowSequences)
+		{
+			this->_drawRenderSequence((*it), color.a, (*it).getRevealedVertexCount(glyphCount));
+		}
+		foreach (RenderLiningSequence, it, renderText.shadowLiningSequences)
+		{
+			this->_drawRenderLiningSequence((*it), april::Color((*it).color, (unsigned char)((*it).color.a * color.a_f())), glyphCount);
+		}
+		foreach (RenderSequence, it, renderText.borderSequences)
+		{
+			if ((*it).multiplyAlpha)
+			{
+				this->_drawRenderSequence((*it), (unsigned char)(color.a * color.a_f()), (*it).getRevealedVertexCount(glyphCount));
+			}
+			else
+			{
+				this->_drawRenderSequence((*it), color.a, (*it).getRevealedVertexCount(glyphCount));
+			}
+		}
+		foreach (RenderLiningSequence, it, renderText.borderLiningSequences)
+		{
+			this->_drawRenderLiningSequence((*it), april::Color((*it).color, (unsigned char)((*it).color.a * color.a_f())), glyphCount);
+		}
+		foreach (RenderSequence, it, renderText.textSequences)
+		{
+			this->_drawRenderSequence((*it), color.a, (*it).getRevealedVertexCount(glyphCount));
+		}
+		foreach (RenderLiningSequence, it, renderText.textLiningSequences)
+		{
+			this->_drawRenderLiningSequence((*it), april::Color((*it).color, color.a), glyphCount);
+		}
+	}
+
+	void Renderer::_drawRenderTextRange(RenderText& renderText, const april::Color& color, int firstGlyph, int lastGlyph)
+	{
+		// rectangles are sorted by their glyphs so the range of each sequence can be found directly
+		int start = 0;
+		foreach (RenderSequence, it, renderText.shadowSequences)
+		{
+			start = (*it).getRevealedVertexCount(firstGlyph);
+			this->_drawRenderSequence((*it), color.a, (*it).getRevealedVertexCount(lastGlyph) - start, start);
+		}
+		foreach (RenderLiningSequence, it, renderText.shadowLiningSequences)
+		{
+			start = (*it).getRevealedVertexCount(firstGlyph);
+			this->_drawRenderLiningSequenceRange((*it), april::Color((*it).color, (unsigned char)((*it).color.a * color.a_f())), start, (*it).getRevealedVertexCount(lastGlyph) - start);
+		}
+		foreach (RenderSequence, it, renderText.borderSequences)
+		{
+			start = (*it).getRevealedVertexCount(firstGlyph);
+			this->_drawRenderSequence((*it), ((*it).multiplyAlpha ? (unsigned char)(color.a * color.a_f()) : color.a), (*it).getRevealedVertexCount(lastGlyph) - start, start);
+		}
+		foreach (RenderLiningSequence, it, renderText.borderLiningSequences)
+		{
+			start = (*it).getRevealedVertexCount(firstGlyph);
+			this->_drawRenderLiningSequenceRange((*it), april::Color((*it).color, (unsigned char)((*it).color.a * color.a_f())), start, (*it).getRevealedVertexCount(lastGlyph) - start);
+		}
+		foreach (RenderSequence, it, renderText.textSequences)
+		{
+			start = (*it).getRevealedVertexCount(firstGlyph);
+			this->_drawRenderSequence((*it), color.a, (*it).getRevealedVertexCount(lastGlyph) - start, start);
+		}
+		foreach (RenderLiningSequence, it, renderText.textLiningSequences)
+		{
+			start = (*it).getRevealedVertexCount(firstGlyph);
+			this->_drawRenderLiningSequenceRange((*it), april::Color((*it).color, color.a), start, (*it).getRevealedVertexCount(lastGlyph) - start);
+		}
+	}
+
+	void Renderer::_drawRenderSequence(RenderSequence& sequence, unsigned char alpha, int vertexCount, int vertexStart)
 	{
-		if (sequence.vertices.size() == 0 || sequence.texture == NULL || alpha == 0)
+		if (vertexCount < 0)
+		{
+			vertexCount = sequence.vertices.size();
+		}
+		if (vertexCount == 0 || sequence.texture == NULL || alpha == 0)
 		{
 			return;
 		}
@@ -2516,7 +3416,7 @@ namespace atres
 				sequence.vertices[i].color = april::rendersys->getNativeColorUInt(sequence.colors[i]);
 			}
 		}
-		april::rendersys->render(april::RenderOperation::TriangleList, (april::ColoredTexturedVertex*)sequence.vertices, sequence.vertices.size());
+		april::rendersys->render(april::RenderOperation::TriangleList, (april::ColoredTexturedVertex*)sequence.vertices + vertexStart, vertexCount);
 	}
 
 	void Renderer::_drawRenderLiningSequence(RenderLiningSequence& sequence, const april::Color& color)
@@ -2530,34 +3430,89 @@ namespace atres
 		april::rendersys->render(april::RenderOperation::TriangleList, (april::PlainVertex*)sequence.vertices, sequence.vertices.size(), color);
 	}
 
-	bool Renderer::_checkTextures()
+	void Renderer::_drawRenderLiningSequenceRange(RenderLiningSequence& sequence, const april::Color& color, int vertexStart, int vertexCount)
 	{
-		foreach (RenderSequence, it, this->_cacheEntryText->value.textSequences)
+		if (vertexCount <= 0 || color.a == 0)
 		{
-			if (!(*it).texture->isUploaded())
-			{
-				this->clearCache(); // font textures were deleted somewhere for some reason (e.g. Android's onPause), clear the cacheText
-				return false;
-			}
+			return;
 		}
-		foreach (RenderSequence, it, this->_cacheEntryText->value.shadowSequences)
+		april::rendersys->setBlendMode(april::BlendMode::Alpha);
+		april::rendersys->setColorMode(april::ColorMode::Multiply);
+		april::rendersys->render(april::RenderOperation::TriangleList, (april::PlainVertex*)sequence.vertices + vertexStart, vertexCount, color);
+	}
+
+	void Renderer::_drawRenderLiningSequence(RenderLiningSequence& sequence, const april::Color& color, int glyphCount)
+	{
+		if (sequence.vertices.size() == 0 || color.a == 0)
 		{
-			if (!(*it).texture->isUploaded())
-			{
-				this->clearCache(); // font textures were deleted somewhere for some reason (e.g. Android's onPause), clear the cacheText
-				return false;
-			}
+			return;
 		}
-		foreach (RenderSequence, it, this->_cacheEntryText->value.borderSequences)
+		int count = 0;
+		while (count < sequence.glyphs.size() && sequence.glyphs[count] < glyphCount)
 		{
-			if (!(*it).texture->isUploaded())
-			{
-				this->clearCache(); // font textures were deleted somewhere for some reason (e.g. Android's onPause), clear the cacheText
-				return false;
-			}
+			++count;
 		}
-		return true;
-	}
+		if (count == 0)
+		{
+			return;
+		}
+		april::rendersys->setBlendMode(april::BlendMode::Alpha);
+		april::rendersys->setColorMode(april::ColorMode::Multiply);
+		int first = sequence.glyphs[count - 1];
+		int last = sequence.lastGlyphs[count - 1];
+		if (last < glyphCount)
+		{
+			april::rendersys->render(april::RenderOperation::TriangleList, (april::PlainVertex*)sequence.vertices, count * 6, color);
+			return;
+		}
+		if (count > 1)
+		{
+			april::rendersys->render(april::RenderOperation::TriangleList, (april::PlainVertex*)sequence.vertices, (count - 1) * 6, color);
+		}
+		// a merged rectangle that is only partially revealed is shortened proportionally
+		april::PlainVertex vertices[6];
+		for_iter (i, 0, 6)
+		{
+			vertices[i] = sequence.vertices[(count - 1) * 6 + i];
+		}
+		float left = vertices[0].x;
+		vertices[1].x = vertices[3].x = vertices[5].x = left + (vertices[1].x - left) * (glyphCount - first) / (last - first + 1);
+		april::rendersys->render(april::RenderOperation::TriangleList, vertices, 6, color);
+	}
+
+	bool Renderer::_checkTextures()
+	{
+		return this->_checkTextures(this->_cacheEntryText->value);
+	}
+
+	bool Renderer::_checkTextures(const RenderText& renderText)
+	{
+		int size = renderText.fonts.size();
+		for_iter (i, 0, size)
+		{
+			// lost textures are only detected in checkTextures() which increases the texture generation, comparing generations is cheap enough for every draw
+			if (renderText.fonts[i]->getTextureGeneration() != renderText.textureGenerations[i])
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool Renderer::checkTextures()
+	{
+		bool result = true;
+		harray<Font*> fonts = this->fonts.values().removedDuplicates();
+		foreach (Font*, it, fonts)
+		{
+			if (!(*it)->checkTextures())
+			{
+				hlog::writef(logTag, "Textures of font '%s' were lost, text using them will be recreated.", (*it)->getName().cStr());
+				result = false;
+			}
+		}
+		return result;
+	}
 	
 	void Renderer::drawText(cgrectf rect, chstr text, const Horizontal& horizontal, const Vertical& vertical)
 	{
@@ -2601,13 +3556,12 @@ namespace atres
 			this->_cacheEntryLines = this->cacheLines->get(this->_cacheEntryLinesData);
 			if (this->_cacheEntryLines == NULL)
 			{
-				this->_cacheEntryLinesData.value = this->createRenderLines(rect, unformattedText, tags, horizontal, vertical, offset);
 				this->_cacheEntryLines = this->cacheLines->add(this->_cacheEntryLinesData);
+				this->_makeRenderLines(this->layoutContext, this->cacheLineBreaks, this->cacheWords, this->_cacheEntryLinesData, this->_cacheEntryLines->value, unformattedText, tags);
 				this->cacheLines->update();
 			}
-			this->_lines = this->_cacheEntryLines->value;
-			this->_cacheEntryTextData.value = this->createRenderText(rect, text, this->_lines, tags);
 			this->_cacheEntryText = this->cacheText->add(this->_cacheEntryTextData);
+			this->_createRenderText(this->layoutContext, this->_cacheEntryText->value, rect, text, this->_cacheEntryLines->value, tags);
 			this->cacheText->update();
 		}
 		this->_drawRenderText(this->_cacheEntryText->value, color);
@@ -2624,13 +3578,12 @@ namespace atres
 			this->_cacheEntryLines = this->cacheLinesUnformatted->get(this->_cacheEntryLinesData);
 			if (this->_cacheEntryLines == NULL)
 			{
-				this->_cacheEntryLinesData.value = this->createRenderLines(rect, text, tags, horizontal, vertical, offset);
 				this->_cacheEntryLines = this->cacheLinesUnformatted->add(this->_cacheEntryLinesData);
+				this->_makeRenderLines(this->layoutContext, this->cacheLineBreaksUnformatted, this->cacheWordsUnformatted, this->_cacheEntryLinesData, this->_cacheEntryLines->value, text, tags);
 				this->cacheLinesUnformatted->update();
 			}
-			this->_lines = this->_cacheEntryLines->value;
-			this->_cacheEntryTextData.value = this->createRenderText(rect, text, this->_lines, tags);
 			this->_cacheEntryText = this->cacheTextUnformatted->add(this->_cacheEntryTextData);
+			this->_createRenderText(this->layoutContext, this->_cacheEntryText->value, rect, text, this->_cacheEntryLines->value, tags);
 			this->cacheTextUnformatted->update();
 		}
 		this->_drawRenderText(this->_cacheEntryText->value, color);
@@ -2658,13 +3611,12 @@ namespace atres
 			this->_cacheEntryLines = this->cacheLines->get(this->_cacheEntryLinesData);
 			if (this->_cacheEntryLines == NULL)
 			{
-				this->_cacheEntryLinesData.value = this->createRenderLines(rect, unformattedText, tags, horizontal, vertical, offset);
 				this->_cacheEntryLines = this->cacheLines->add(this->_cacheEntryLinesData);
+				this->_makeRenderLines(this->layoutContext, this->cacheLineBreaks, this->cacheWords, this->_cacheEntryLinesData, this->_cacheEntryLines->value, unformattedText, tags);
 				this->cacheLines->update();
 			}
-			this->_lines = this->_cacheEntryLines->value;
-			this->_cacheEntryTextData.value = this->createRenderText(rect, text, this->_lines, tags, &colorData);
 			this->_cacheEntryText = this->cacheText->add(this->_cacheEntryTextData);
+			this->_createRenderText(this->layoutContext, this->_cacheEntryText->value, rect, text, this->_cacheEntryLines->value, tags, &colorData);
 			this->cacheText->update();
 		}
 		this->_drawRenderText(this->_cacheEntryText->value, colorData.colorTopLeft);
@@ -2674,207 +3626,930 @@ namespace atres
 	{
 		this->_cacheEntryTextData.set(text, fontName, rect, horizontal, vertical, april::Color(colorData.colorTopLeft, 255), offset);
 		this->_cacheEntryText = this->cacheTextUnformatted->get(this->_cacheEntryTextData);
-		if (this->_cacheEntryText != NULL || !this->_checkTextures())
+		if (this->_cacheEntryText == NULL || !this->_checkTextures())
 		{
 			harray<FormatTag> tags = this->_makeDefaultTagsUnformatted(colorData.colorTopLeft, fontName);
 			this->_cacheEntryLinesData.set(text, fontName, rect, horizontal, vertical, april::Color(colorData.colorTopLeft, 255), offset);
 			this->_cacheEntryLines = this->cacheLinesUnformatted->get(this->_cacheEntryLinesData);
 			if (this->_cacheEntryLines == NULL)
 			{
-				this->_cacheEntryLinesData.value = this->createRenderLines(rect, text, tags, horizontal, vertical, offset);
 				this->_cacheEntryLines = this->cacheLinesUnformatted->add(this->_cacheEntryLinesData);
+				this->_makeRenderLines(this->layoutContext, this->cacheLineBreaksUnformatted, this->cacheWordsUnformatted, this->_cacheEntryLinesData, this->_cacheEntryLines->value, text, tags);
 				this->cacheLinesUnformatted->update();
 			}
-			this->_lines = this->_cacheEntryLines->value;
-			this->_cacheEntryTextData.value = this->createRenderText(rect, text, this->_lines, tags, &colorData);
 			this->_cacheEntryText = this->cacheTextUnformatted->add(this->_cacheEntryTextData);
+			this->_createRenderText(this->layoutContext, this->_cacheEntryText->value, rect, text, this->_cacheEntryLines->value, tags, &colorData);
 			this->cacheTextUnformatted->update();
 		}
 		this->_drawRenderText(this->_cacheEntryText->value, colorData.colorTopLeft);
 	}
 
-	harray<RenderLine> Renderer::makeRenderLines(chstr fontName, cgrectf rect, chstr text, const Horizontal& horizontal, const Vertical& vertical, const april::Color& color, cgvec2f offset)
+	void Renderer::drawText(const FormattedText& formattedText, cgrectf rect, const Horizontal& horizontal, const Vertical& vertical, const april::Color& color, cgvec2f offset)
 	{
-		this->_cacheEntryLinesData.set(text, fontName, rect, horizontal, vertical, april::Color(color, 255), offset);
-		this->_cacheEntryLines = this->cacheLines->get(this->_cacheEntryLinesData);
-		if (this->_cacheEntryLines == NULL)
+		this->_cacheEntryTextData.set(formattedText, rect, horizontal, vertical, color, offset);
+		this->_cacheEntryText = this->cacheText->get(this->_cacheEntryTextData);
+		if (this->_cacheEntryText == NULL || !this->_checkTextures())
 		{
-			hstr unformattedText = text;
-			harray<FormatTag> tags = this->_makeDefaultTags(april::Color(color, 255), fontName, unformattedText);
-			this->_cacheEntryLinesData.value = this->createRenderLines(rect, unformattedText, tags, horizontal, vertical, offset);
-			this->_cacheEntryLines = this->cacheLines->add(this->_cacheEntryLinesData);
-			this->cacheLines->update();
+			harray<FormatTag> tags = this->_makeDefaultTags(color, formattedText);
+			this->_cacheEntryLinesData.set(formattedText, rect, horizontal, vertical, april::Color(color, 255), offset);
+			this->_cacheEntryLines = this->cacheLines->get(this->_cacheEntryLinesData);
+			if (this->_cacheEntryLines == NULL)
+			{
+				this->_cacheEntryLines = this->cacheLines->add(this->_cacheEntryLinesData);
+				this->_makeRenderLines(this->layoutContext, this->cacheLineBreaks, this->cacheWords, this->_cacheEntryLinesData, this->_cacheEntryLines->value, formattedText.unformattedText, tags);
+				this->cacheLines->update();
+			}
+			this->_cacheEntryText = this->cacheText->add(this->_cacheEntryTextData);
+			this->_createRenderText(this->layoutContext, this->_cacheEntryText->value, rect, formattedText.text, this->_cacheEntryLines->value, tags);
+			this->cacheText->update();
 		}
-		return this->_cacheEntryLines->value;
+		this->_drawRenderText(this->_cacheEntryText->value, color);
 	}
 
-	harray<RenderLine> Renderer::makeRenderLinesUnformatted(chstr fontName, cgrectf rect, chstr text, const Horizontal& horizontal, const Vertical& vertical, const april::Color& color, cgvec2f offset)
+	void Renderer::drawText(const FormattedText& formattedText, cgrectf rect, const Horizontal& horizontal, const Vertical& vertical, const ColorData& colorData, cgvec2f offset)
 	{
-		this->_cacheEntryLinesData.set(text, fontName, rect, horizontal, vertical, april::Color(color, 255), offset);
-		this->_cacheEntryLines = this->cacheLinesUnformatted->get(this->_cacheEntryLinesData);
-		if (this->_cacheEntryLines == NULL)
+		this->_cacheEntryTextData.set(formattedText, rect, horizontal, vertical, colorData.colorTopLeft, offset);
+		this->_cacheEntryText = this->cacheText->get(this->_cacheEntryTextData);
+		if (this->_cacheEntryText == NULL || !this->_checkTextures())
 		{
-			harray<FormatTag> tags = this->_makeDefaultTagsUnformatted(april::Color(color, 255), fontName);
-			this->_cacheEntryLinesData.value = this->createRenderLines(rect, text, tags, horizontal, vertical, offset);
-			this->_cacheEntryLines = this->cacheLinesUnformatted->add(this->_cacheEntryLinesData);
-			this->cacheLinesUnformatted->update();
+			harray<FormatTag> tags = this->_makeDefaultTags(colorData.colorTopLeft, formattedText);
+			this->_cacheEntryLinesData.set(formattedText, rect, horizontal, vertical, april::Color(colorData.colorTopLeft, 255), offset);
+			this->_cacheEntryLines = this->cacheLines->get(this->_cacheEntryLinesData);
+			if (this->_cacheEntryLines == NULL)
+			{
+				this->_cacheEntryLines = this->cacheLines->add(this->_cacheEntryLinesData);
+				this->_makeRenderLines(this->layoutContext, this->cacheLineBreaks, this->cacheWords, this->_cacheEntryLinesData, this->_cacheEntryLines->value, formattedText.unformattedText, tags);
+				this->cacheLines->update();
+			}
+			this->_cacheEntryText = this->cacheText->add(this->_cacheEntryTextData);
+			this->_createRenderText(this->layoutContext, this->_cacheEntryText->value, rect, formattedText.text, this->_cacheEntryLines->value, tags, &colorData);
+			this->cacheText->update();
 		}
-		return this->_cacheEntryLines->value;
-	}
-
-	harray<FormatTag> Renderer::_makeDefaultTags(const april::Color& color, chstr fontName, hstr& text)
-	{
-		harray<FormatTag> tags;
-		text = this->analyzeFormatting(text, tags);
-		FormatTag tag;
-		tag.type = FormatTag::Type::Color;
-		tag.data = color.hex();
-		tags.addFirst(tag);
-		tag.type = FormatTag::Type::Font;
-		tag.data = fontName;
-		tags.addFirst(tag);
-		return tags;
-	}
-
-	harray<FormatTag> Renderer::_makeDefaultTagsUnformatted(const april::Color& color, chstr fontName)
-	{
-		harray<FormatTag> tags;
-		FormatTag tag;
-		tag.type = FormatTag::Type::Color;
-		tag.data = color.hex();
-		tags.addFirst(tag);
-		tag.type = FormatTag::Type::Font;
-		tag.data = fontName;
-		tags.addFirst(tag);
-		return tags;
+		this->_drawRenderText(this->_cacheEntryText->value, colorData.colorTopLeft);
 	}
 
-	float Renderer::getTextWidth(chstr fontName, chstr text)
+	void Renderer::drawTextObject(TextObject& textObject)
 	{
-		float result = 0.0f;
-		if (text != "")
+		if (!textObject.valid || textObject.cacheGeneration != this->cacheGeneration || !this->_checkTextures(textObject.renderText))
 		{
-			static grectf defaultRect(0.0f, 0.0f, CHECK_RECT_SIZE, CHECK_RECT_SIZE);
-			this->_lines = this->makeRenderLines(fontName, defaultRect, text);
-			foreach (RenderLine, it, this->_lines)
-			{
-				result = hmax(result, (*it).rect.w);
-			}
+			this->_updateTextObject(textObject);
 		}
-		return result;
+		this->_drawRenderText(textObject.renderText, textObject.color);
 	}
 
-	float Renderer::getTextWidth(chstr text)
+	void Renderer::drawTextObject(TextObject& textObject, int glyphCount)
 	{
-		return this->getTextWidth("", text);
+		if (!textObject.valid || textObject.cacheGeneration != this->cacheGeneration || !this->_checkTextures(textObject.renderText))
+		{
+			this->_updateTextObject(textObject);
+		}
+		this->_drawRenderText(textObject.renderText, textObject.color, glyphCount);
 	}
 
-	float Renderer::getTextWidthUnformatted(chstr fontName, chstr text)
+	void Renderer::_updateTextObject(TextObject& textObject)
 	{
-		return this->getTextWidth(fontName, "[-]" + text);
+		// the render text is built directly into the object instead of the text cache since copying it out of a cache entry
+		// on every rebuild would cost more than the cache saves for retained text
+		hstr unformattedText = textObject.text;
+		harray<FormatTag> tags = this->_makeDefaultTags(textObject.color, textObject.fontName, unformattedText);
+		this->_cacheEntryLinesData.set(textObject.text, textObject.fontName, textObject.rect, textObject.horizontal, textObject.vertical, april::Color(textObject.color, 255), textObject.offset);
+		this->_cacheEntryLines = this->cacheLines->get(this->_cacheEntryLinesData);
+		if (this->_cacheEntryLines == NULL)
+		{
+			this->_cacheEntryLines = this->cacheLines->add(this->_cacheEntryLinesData);
+			this->_makeRenderLines(this->layoutContext, this->cacheLineBreaks, this->cacheWords, this->_cacheEntryLinesData, this->_cacheEntryLines->value, unformattedText, tags);
+			this->cacheLines->update();
+		}
+		this->_createRenderText(this->layoutContext, textObject.renderText, textObject.rect, textObject.text, this->_cacheEntryLines->value, tags);
+		textObject.valid = true;
+		textObject.cacheGeneration = this->cacheGeneration;
 	}
 
-	float Renderer::getTextWidthUnformatted(chstr text)
+	void Renderer::appendText(AppendableText& appendableText, chstr text)
 	{
-		return this->getTextWidth("", "[-]" + text);
+		appendableText.texts += text;
+		if (appendableText.valid)
+		{
+			this->_updateAppendableText(appendableText);
+		}
 	}
 
-	float Renderer::getTextAdvanceX(chstr fontName, chstr text)
+	void Renderer::drawAppendableText(AppendableText& appendableText)
 	{
-		float result = 0.0f;
-		if (text != "")
+		// changed textures require everything to be created again before drawing
+		if (!appendableText.valid || appendableText.cacheGeneration != this->cacheGeneration || !this->_checkTextures(appendableText.renderText))
 		{
-			static grectf defaultRect(0.0f, 0.0f, CHECK_RECT_SIZE, CHECK_RECT_SIZE);
-			this->_lines = this->makeRenderLines(fontName, defaultRect, text);
-			foreach (RenderLine, it, this->_lines)
+			appendableText.lines.clear();
+			appendableText.renderText = RenderText();
+			appendableText.lineGlyphs.clear();
+			appendableText.height = 0.0f;
+			appendableText.offset.set(0.0f, 0.0f);
+			appendableText.laidOutCount = 0;
+			appendableText.valid = true;
+		}
+		this->_updateAppendableText(appendableText);
+		// alignment only moves the existing vertices
+		grectf rect = appendableText.rect;
+		gvec2f offset(rect.x, rect.y);
+		if (appendableText.vertical == Vertical::Bottom)
+		{
+			offset.y += rect.h - appendableText.height;
+		}
+		else if (appendableText.vertical == Vertical::Center)
+		{
+			offset.y += (rect.h - appendableText.height) * 0.5f;
+		}
+		if (offset != appendableText.offset)
+		{
+			this->_moveRenderLines(appendableText.lines, 0, offset - appendableText.offset);
+			this->_moveRenderText(appendableText.renderText, offset - appendableText.offset);
+			appendableText.offset = offset;
+		}
+		const harray<RenderLine>& lines = appendableText.lines;
+		// binary search for the first line that is fully inside of the rect, lines are sorted vertically
+		int minIndex = 0;
+		int maxIndex = lines.size();
+		int index = 0;
+		while (minIndex < maxIndex)
+		{
+			index = (minIndex + maxIndex) / 2;
+			if (lines[index].rect.y < rect.y)
 			{
-				result = hmax(result, (*it).advanceX);
+				minIndex = index + 1;
+			}
+			else
+			{
+				maxIndex = index;
 			}
 		}
-		return result;
+		int firstLine = minIndex;
+		int lastLine = firstLine;
+		float bottom = rect.bottom();
+		while (lastLine < lines.size() && lines[lastLine].rect.bottom() <= bottom)
+		{
+			++lastLine;
+		}
+		if (firstLine < lastLine)
+		{
+			this->_drawRenderTextRange(appendableText.renderText, appendableText.color, appendableText.lineGlyphs[firstLine],
+				(lastLine < lines.size() ? appendableText.lineGlyphs[lastLine] : appendableText.renderText.glyphCount));
+		}
 	}
 
-	float Renderer::getTextAdvanceX(chstr text)
+	void Renderer::_updateAppendableText(AppendableText& appendableText)
 	{
-		return this->getTextAdvanceX("", text);
+		int count = appendableText.texts.size();
+		if (appendableText.laidOutCount >= count)
+		{
+			return;
+		}
+		ResolvedFont font = this->resolveFont(appendableText.fontName);
+		if (font.font == NULL)
+		{
+			hlog::warnf(logTag, "Font '%s' does not exist!", appendableText.fontName.cStr());
+			return;
+		}
+		float lineHeight = font.getLineHeight();
+		hstr unformattedText;
+		harray<FormatTag> tags;
+		harray<RenderLine> lines;
+		harray<RenderLine> line;
+		RenderText renderText;
+		grectf rect;
+		int start = 0;
+		for_iter (i, appendableText.laidOutCount, count)
+		{
+			chstr text = appendableText.texts[i];
+			// new text is laid out below the existing text, unaligned and without any bounds
+			rect.set(0.0f, appendableText.height, appendableText.rect.w, CHECK_RECT_SIZE);
+			unformattedText = text;
+			tags = this->_makeDefaultTags(appendableText.color, appendableText.fontName, unformattedText);
+			lines = this->createRenderLines(rect, unformattedText, tags, appendableText.horizontal, Vertical::Top);
+			start = appendableText.lines.size();
+			// every line is created separately so its glyphs form a continuous range within the merged sequences
+			foreach (RenderLine, it, lines)
+			{
+				line.clear();
+				line += (*it);
+				appendableText.lines += (*it);
+				appendableText.lineGlyphs += appendableText.renderText.glyphCount;
+				this->_createRenderText(this->layoutContext, renderText, rect, text, line, tags);
+				this->_moveRenderText(renderText, appendableText.offset);
+				this->_mergeRenderText(appendableText.renderText, renderText);
+			}
+			appendableText.height += hmax(lines.size(), 1) * lineHeight;
+			this->_moveRenderLines(appendableText.lines, start, appendableText.offset);
+		}
+		appendableText.laidOutCount = count;
+		appendableText.cacheGeneration = this->cacheGeneration;
 	}
 
-	float Renderer::getTextAdvanceXUnformatted(chstr fontName, chstr text)
+	void Renderer::updateVirtualizedText(VirtualizedText& virtualizedText)
 	{
-		return this->getTextAdvanceX(fontName, "[-]" + text);
+		if (virtualizedText.valid && virtualizedText.cacheGeneration == this->cacheGeneration)
+		{
+			return;
+		}
+		virtualizedText.lines.clear();
+		virtualizedText.renderText = RenderText();
+		virtualizedText.firstLine = 0;
+		virtualizedText.lastLine = 0;
+		virtualizedText.height = 0.0f;
+		virtualizedText.renderValid = false;
+		virtualizedText.valid = true;
+		virtualizedText.cacheGeneration = this->cacheGeneration;
+		if (this->resolveFont(virtualizedText.fontName).font == NULL)
+		{
+			hlog::warnf(logTag, "Font '%s' does not exist!", virtualizedText.fontName.cStr());
+			return;
+		}
+		// the whole text is measured only once, only the line positions are kept
+		virtualizedText.unformattedText = virtualizedText.text;
+		virtualizedText.tags = this->_makeDefaultTags(virtualizedText.color, virtualizedText.fontName, virtualizedText.unformattedText);
+		grectf rect(0.0f, 0.0f, virtualizedText.rect.w, CHECK_RECT_SIZE);
+		this->_createRenderLines(this->layoutContext, this->_lines, rect, virtualizedText.unformattedText, virtualizedText.tags, virtualizedText.horizontal, Vertical::Top);
+		VirtualizedLine line;
+		foreachc (RenderLine, it, this->_lines)
+		{
+			line.start = (*it).start;
+			line.y = (*it).rect.y;
+			line.height = (*it).rect.h;
+			virtualizedText.lines += line;
+		}
+		if (virtualizedText.lines.size() > 0)
+		{
+			virtualizedText.height = virtualizedText.lines.last().y + virtualizedText.lines.last().height;
+		}
+		this->_lines.clear();
 	}
 
-	float Renderer::getTextAdvanceXUnformatted(chstr text)
+	void Renderer::drawVirtualizedText(VirtualizedText& virtualizedText)
 	{
-		return this->getTextAdvanceX("", "[-]" + text);
+		this->updateVirtualizedText(virtualizedText);
+		bool force = !this->_checkTextures(virtualizedText.renderText);
+		if (!virtualizedText.renderValid || force)
+		{
+			this->_updateVirtualizedWindow(virtualizedText, force);
+		}
+		this->_drawRenderText(virtualizedText.renderText, virtualizedText.color);
 	}
 
-	float Renderer::getTextHeight(chstr fontName, chstr text, float maxWidth, const Horizontal& horizontal)
+	void Renderer::_updateVirtualizedWindow(VirtualizedText& virtualizedText, bool force)
 	{
-		if (text != "" && maxWidth > 0.0f)
+		virtualizedText.renderValid = true;
+		const harray<VirtualizedLine>& lines = virtualizedText.lines;
+		float top = virtualizedText.scrollOffset;
+		float bottom = top + virtualizedText.rect.h;
+		// binary search for the first line that reaches into the window, lines are sorted vertically
+		int minIndex = 0;
+		int maxIndex = lines.size();
+		int index = 0;
+		while (minIndex < maxIndex)
 		{
-			grectf defaultRect(0.0f, 0.0f, maxWidth, CHECK_RECT_SIZE);
-			this->_lines = this->makeRenderLines(fontName, defaultRect, text, horizontal, Vertical::Top);
-			if (this->_lines.size() > 0)
+			index = (minIndex + maxIndex) / 2;
+			if (lines[index].y + lines[index].height <= top)
+			{
+				minIndex = index + 1;
+			}
+			else
 			{
-				Font* font = this->getFont(fontName);
-				float lineHeight = font->getLineHeight();
-				return hmax((this->_lines.size() - 1) * lineHeight + hmax(lineHeight + font->getInternalDescender(), font->getHeight()), this->_lines.last().rect.bottom());
+				maxIndex = index;
 			}
 		}
-		return 0.0f;
-	}
-	
-	float Renderer::getTextHeight(chstr text, float maxWidth, const Horizontal& horizontal)
-	{
-		return this->getTextHeight("", text, maxWidth, horizontal);
+		int firstLine = minIndex;
+		int lastLine = minIndex;
+		while (lastLine < lines.size() && lines[lastLine].y < bottom)
+		{
+			++lastLine;
+		}
+		gvec2f offset(virtualizedText.rect.x, virtualizedText.rect.y - virtualizedText.scrollOffset);
+		// small scrolls that keep the same lines visible only move the existing vertices
+		if (!force && firstLine == virtualizedText.firstLine && lastLine == virtualizedText.lastLine)
+		{
+			this->_moveRenderText(virtualizedText.renderText, offset - virtualizedText.renderOffset);
+			virtualizedText.renderOffset = offset;
+			return;
+		}
+		virtualizedText.renderText = RenderText();
+		virtualizedText.renderOffset = offset;
+		virtualizedText.firstLine = firstLine;
+		virtualizedText.lastLine = lastLine;
+		if (firstLine >= lastLine)
+		{
+			return;
+		}
+		// only the text of the visible lines is laid out again, starting at the position from the line index
+		int textStart = lines[firstLine].start;
+		int textEnd = (lastLine < lines.size() ? lines[lastLine].start : virtualizedText.unformattedText.size());
+		grectf rect(offset.x, offset.y + lines[firstLine].y, virtualizedText.rect.w, CHECK_RECT_SIZE);
+		harray<RenderWord> words = this->_createRenderWords(this->layoutContext, grectf(0.0f, 0.0f, rect.w, CHECK_RECT_SIZE),
+			virtualizedText.unformattedText, virtualizedText.tags, textStart, textEnd);
+		this->_breakRenderWords(this->layoutContext, this->_lines, words, rect.w, virtualizedText.horizontal);
+		int count = lastLine - firstLine;
+		// the window has to break exactly like the whole text did, otherwise its lines are taken from a layout starting at the beginning
+		bool matching = (this->_lines.size() >= count);
+		for_iter (i, 0, hmin(count, this->_lines.size()))
+		{
+			if (this->_lines[i].start != lines[firstLine + i].start)
+			{
+				matching = false;
+				break;
+			}
+		}
+		if (!matching)
+		{
+			hlog::warnf(logTag, "Virtualized text window at line %d does not match the line index, laying out from the start of the text.", firstLine);
+			words = this->_createRenderWords(this->layoutContext, grectf(0.0f, 0.0f, rect.w, CHECK_RECT_SIZE), virtualizedText.unformattedText, virtualizedText.tags, 0, textEnd);
+			this->_breakRenderWords(this->layoutContext, this->_lines, words, rect.w, virtualizedText.horizontal);
+			this->_lines = this->_lines(hmin(firstLine, this->_lines.size()), hmax(this->_lines.size() - firstLine, 0));
+			rect.y -= firstLine * this->layoutContext._lineHeight;
+		}
+		if (this->_lines.size() > count)
+		{
+			this->_lines.removeLast(this->_lines.size() - count);
+		}
+		this->_placeRenderLines(this->_lines, rect, virtualizedText.horizontal, Vertical::Top, gvec2f(), this->layoutContext._lineHeight,
+			this->layoutContext._descender, this->layoutContext._internalDescender);
+		this->_createRenderText(this->layoutContext, virtualizedText.renderText, virtualizedText.rect, virtualizedText.unformattedText, this->_lines, virtualizedText.tags);
 	}
 
-	float Renderer::getTextHeightUnformatted(chstr fontName, chstr text, float maxWidth, const Horizontal& horizontal)
+	void Renderer::_moveRenderLines(harray<RenderLine>& lines, int start, cgvec2f offset)
 	{
-		return this->getTextHeight(fontName, "[-]" + text, maxWidth, horizontal);
+		if (offset.x == 0.0f && offset.y == 0.0f)
+		{
+			return;
+		}
+		int size = lines.size();
+		for_iter (i, start, size)
+		{
+			lines[i].rect += offset;
+			foreach (RenderWord, it, lines[i].words)
+			{
+				(*it).rect += offset;
+			}
+		}
 	}
 
-	float Renderer::getTextHeightUnformatted(chstr text, float maxWidth, const Horizontal& horizontal)
+	void Renderer::_moveRenderText(RenderText& renderText, cgvec2f offset)
 	{
-		return this->getTextHeight("", "[-]" + text, maxWidth, horizontal);
+		if (offset.x == 0.0f && offset.y == 0.0f)
+		{
+			return;
+		}
+		harray<RenderSequence>* sequences[3] = {&renderText.textSequences, &renderText.shadowSequences, &renderText.borderSequences};
+		for_iter (i, 0, 3)
+		{
+			foreach (RenderSequence, it, *sequences[i])
+			{
+				foreach (april::ColoredTexturedVertex, it2, (*it).vertices)
+				{
+					(*it2).x += offset.x;
+					(*it2).y += offset.y;
+				}
+			}
+		}
+		harray<RenderLiningSequence>* liningSequences[3] = {&renderText.textLiningSequences, &renderText.shadowLiningSequences, &renderText.borderLiningSequences};
+		for_iter (i, 0, 3)
+		{
+			foreach (RenderLiningSequence, it, *liningSequences[i])
+			{
+				foreach (april::PlainVertex, it2, (*it).vertices)
+				{
+					(*it2).x += offset.x;
+					(*it2).y += offset.y;
+				}
+			}
+		}
 	}
 
-	hstr Renderer::getFittingText(chstr fontName, chstr text, float maxWidth)
+	void Renderer::_mergeRenderText(RenderText& result, const RenderText& other)
 	{
-		if (text != "" && maxWidth > 0.0f)
+		// sequences with the same texture are merged so the whole text is drawn with as few calls as possible
+		harray<RenderSequence>* resultSequences[3] = {&result.textSequences, &result.shadowSequences, &result.borderSequences};
+		const harray<RenderSequence>* otherSequences[3] = {&other.textSequences, &other.shadowSequences, &other.borderSequences};
+		RenderSequence* sequence = NULL;
+		for_iter (i, 0, 3)
 		{
-			grectf defaultRect(0.0f, 0.0f, CHECK_RECT_SIZE, CHECK_RECT_SIZE);
-			this->_lines = this->makeRenderLines(fontName, defaultRect, text, Horizontal::LeftWrapped, Vertical::Top);
-			if (this->_lines.size() > 0)
+			foreachc (RenderSequence, it, *otherSequences[i])
 			{
-				float width = 0.0f;
-				harray<hstr> result;
-				std::ustring ustr;
-				int size = 0;
-				foreach (RenderWord, it, this->_lines[0].words)
+				sequence = NULL;
+				foreach (RenderSequence, it2, *resultSequences[i])
 				{
-					if ((*it).rect.right() > maxWidth)
+					if ((*it2).texture == (*it).texture && (*it2).multiplyAlpha == (*it).multiplyAlpha)
 					{
-						ustr = (*it).text.uStr();
-						size = (int)ustr.size();
-						for_iter (i, 0, size)
-						{
-							if (width + (*it).segmentWidths[i] > maxWidth)
-							{
-								break;
-							}
-							result += hstr::fromUnicode(ustr[i]);
-						}
+						sequence = &(*it2);
 						break;
 					}
-					width = (*it).rect.right();
-					result += (*it).text;
 				}
-				return result.joined("");
+				if (sequence == NULL)
+				{
+					*resultSequences[i] += RenderSequence();
+					sequence = &resultSequences[i]->last();
+					sequence->texture = (*it).texture;
+					sequence->multiplyAlpha = (*it).multiplyAlpha;
+				}
+				sequence->mergeFrom((*it), result.glyphCount);
+				sequence->lastAlpha = 0; // forces the alpha to be applied to the merged vertices on the next draw
 			}
 		}
-		return "";
+		harray<RenderLiningSequence>* resultLiningSequences[3] = {&result.textLiningSequences, &result.shadowLiningSequences, &result.borderLiningSequences};
+		const harray<RenderLiningSequence>* otherLiningSequences[3] = {&other.textLiningSequences, &other.shadowLiningSequences, &other.borderLiningSequences};
+		RenderLiningSequence* liningSequence = NULL;
+		for_iter (i, 0, 3)
+		{
+			foreachc (RenderLiningSequence, it, *otherLiningSequences[i])
+			{
+				liningSequence = NULL;
+				foreach (RenderLiningSequence, it2, *resultLiningSequences[i])
+				{
+					if ((*it2).color == (*it).color)
+					{
+						liningSequence = &(*it2);
+						break;
+					}
+				}
+				if (liningSequence == NULL)
+				{
+					*resultLiningSequences[i] += RenderLiningSequence();
+					liningSequence = &resultLiningSequences[i]->last();
+					liningSequence->color = (*it).color;
+				}
+				liningSequence->mergeFrom((*it), result.glyphCount);
+			}
+		}
+		int size = other.fonts.size();
+		for_iter (i, 0, size)
+		{
+			// the oldest texture generation is kept so any change since then is detected
+			if (!result.fonts.has(other.fonts[i]))
+			{
+				result.fonts += other.fonts[i];
+				result.textureGenerations += other.textureGenerations[i];
+			}
+		}
+		result.glyphCount += other.glyphCount;
+	}
+
+	harray<RenderLine> Renderer::makeRenderLines(chstr fontName, cgrectf rect, chstr text, const Horizontal& horizontal, const Vertical& vertical, const april::Color& color, cgvec2f offset)
+	{
+		this->_cacheEntryLinesData.set(text, fontName, rect, horizontal, vertical, april::Color(color, 255), offset);
+		this->_cacheEntryLines = this->cacheLines->get(this->_cacheEntryLinesData);
+		if (this->_cacheEntryLines == NULL)
+		{
+			hstr unformattedText = text;
+			harray<FormatTag> tags = this->_makeDefaultTags(april::Color(color, 255), fontName, unformattedText);
+			this->_cacheEntryLines = this->cacheLines->add(this->_cacheEntryLinesData);
+			this->_makeRenderLines(this->layoutContext, this->cacheLineBreaks, this->cacheWords, this->_cacheEntryLinesData, this->_cacheEntryLines->value, unformattedText, tags);
+			this->cacheLines->update();
+		}
+		return this->_cacheEntryLines->value;
+	}
+
+	harray<RenderLine> Renderer::makeRenderLinesUnformatted(chstr fontName, cgrectf rect, chstr text, const Horizontal& horizontal, const Vertical& vertical, const april::Color& color, cgvec2f offset)
+	{
+		this->_cacheEntryLinesData.set(text, fontName, rect, horizontal, vertical, april::Color(color, 255), offset);
+		this->_cacheEntryLines = this->cacheLinesUnformatted->get(this->_cacheEntryLinesData);
+		if (this->_cacheEntryLines == NULL)
+		{
+			harray<FormatTag> tags = this->_makeDefaultTagsUnformatted(april::Color(color, 255), fontName);
+			this->_cacheEntryLines = this->cacheLinesUnformatted->add(this->_cacheEntryLinesData);
+			this->_makeRenderLines(this->layoutContext, this->cacheLineBreaksUnformatted, this->cacheWordsUnformatted, this->_cacheEntryLinesData, this->_cacheEntryLines->value, text, tags);
+			this->cacheLinesUnformatted->update();
+		}
+		return this->_cacheEntryLines->value;
+	}
+
+	harray<RenderLine> Renderer::makeRenderLines(const FormattedText& formattedText, cgrectf rect, const Horizontal& horizontal, const Vertical& vertical, const april::Color& color, cgvec2f offset)
+	{
+		this->_cacheEntryLinesData.set(formattedText, rect, horizontal, vertical, april::Color(color, 255), offset);
+		this->_cacheEntryLines = this->cacheLines->get(this->_cacheEntryLinesData);
+		if (this->_cacheEntryLines == NULL)
+		{
+			harray<FormatTag> tags = this->_makeDefaultTags(april::Color(color, 255), formattedText);
+			this->_cacheEntryLines = this->cacheLines->add(this->_cacheEntryLinesData);
+			this->_makeRenderLines(this->layoutContext, this->cacheLineBreaks, this->cacheWords, this->_cacheEntryLinesData, this->_cacheEntryLines->value, formattedText.unformattedText, tags);
+			this->cacheLines->update();
+		}
+		return this->_cacheEntryLines->value;
+	}
+
+	harray<LayoutResult> Renderer::makeRenderLines(const harray<LayoutRequest>& requests, int workerCount)
+	{
+		harray<LayoutResult> results;
+		results.add(LayoutResult(), requests.size());
+		LayoutBatch batch;
+		batch.renderer = this;
+		batch.requests = &requests;
+		batch.results = &results;
+		hstr unformattedText;
+		harray<FormatTag> tags;
+		int size = requests.size();
+		for_iter (i, 0, size)
+		{
+			const LayoutRequest& request = requests[i];
+			this->_cacheEntryLinesData.set(request.text, request.fontName, request.rect, request.horizontal, request.vertical, april::Color::White, request.offset);
+			this->_cacheEntryLines = this->cacheLines->get(this->_cacheEntryLinesData);
+			if (this->_cacheEntryLines != NULL)
+			{
+				results[i].lines = this->_cacheEntryLines->value;
+			}
+			else
+			{
+				unformattedText = request.text;
+				tags = this->_makeDefaultTags(april::Color::White, request.fontName, unformattedText);
+				// fonts are not thread-safe when loading characters so this is done before the workers start
+				this->_preloadCharacters(unformattedText, tags);
+				batch.indices += i;
+				batch.texts += unformattedText;
+				batch.tags += tags;
+			}
+		}
+		if (batch.indices.size() > 0)
+		{
+			// workers are created once and kept, so thread creation doesn't add to the latency of every batch
+			workerCount = hmin(workerCount, batch.indices.size() - 1);
+			while (this->layoutWorkers.size() < workerCount)
+			{
+				this->layoutWorkers += new LayoutWorker();
+				this->layoutWorkers.last()->start();
+			}
+			for_iter (i, 0, workerCount)
+			{
+				this->layoutWorkers[i]->assign(&batch);
+			}
+			batch.process(this->layoutContext);
+			for_iter (i, 0, workerCount)
+			{
+				this->layoutWorkers[i]->finish();
+			}
+			foreach (int, it, batch.indices)
+			{
+				const LayoutRequest& request = requests[*it];
+				this->_cacheEntryLinesData.set(request.text, request.fontName, request.rect, request.horizontal, request.vertical, april::Color::White, request.offset);
+				this->_cacheEntryLines = this->cacheLines->add(this->_cacheEntryLinesData);
+				this->_cacheEntryLines->value = results[*it].lines;
+			}
+			this->cacheLines->update();
+		}
+		ResolvedFont font;
+		float lineHeight = 0.0f;
+		for_iter (i, 0, size)
+		{
+			LayoutResult& result = results[i];
+			if (result.lines.size() > 0)
+			{
+				foreach (RenderLine, it, result.lines)
+				{
+					result.width = hmax(result.width, (*it).rect.w);
+				}
+				font = this->resolveFont(requests[i].fontName);
+				if (font.font != NULL)
+				{
+					lineHeight = font.getLineHeight();
+					result.height = hmax((result.lines.size() - 1) * lineHeight + hmax(lineHeight + font.getInternalDescender(), font.getHeight()),
+						result.lines.last().rect.bottom() - result.lines.first().rect.y);
+				}
+			}
+		}
+		return results;
+	}
+
+	void Renderer::_preloadCharacters(chstr text, const harray<FormatTag>& tags)
+	{
+		FontIconMap* iconFont = NULL;
+		foreachc (FormatTag, it, tags)
+		{
+			if ((*it).type == FormatTag::Type::Font)
+			{
+				this->analyzeText((*it).data, text);
+			}
+			else if ((*it).type == FormatTag::Type::Icon)
+			{
+				iconFont = dynamic_cast<FontIconMap*>(this->resolveFont((*it).data).font);
+				if (iconFont != NULL)
+				{
+					iconFont->hasIcon((*it).consumedData);
+				}
+			}
+		}
+	}
+
+	void Renderer::_preloadBorderCharacters(chstr text, const harray<FormatTag>& tags)
+	{
+		harray<float> thicknesses;
+		float textBorderThickness = 1.0f;
+		hstr color;
+		hstr thickness;
+		foreachc (FormatTag, it, tags)
+		{
+			if ((*it).type == FormatTag::Type::Border)
+			{
+				if ((*it).data.count(',') == 1)
+				{
+					(*it).data.split(',', color, thickness);
+					textBorderThickness = (float)thickness;
+				}
+				if (!thicknesses.has(this->borderThickness * textBorderThickness))
+				{
+					thicknesses += this->borderThickness * textBorderThickness;
+				}
+			}
+		}
+		if (thicknesses.size() == 0)
+		{
+			return;
+		}
+		// all missing border glyphs of a font are created at once instead of one by one while the text is being processed
+		harray<Font*> fonts;
+		Font* font = NULL;
+		foreachc (FormatTag, it, tags)
+		{
+			if ((*it).type == FormatTag::Type::Font)
+			{
+				font = this->resolveFont((*it).data).font;
+				if (font != NULL && font->getBorderMode() != Font::BorderMode::Software && !fonts.has(font))
+				{
+					fonts += font;
+					foreach (float, it2, thicknesses)
+					{
+						font->loadBorderCharacters(text, (*it2) / font->getBaseScale());
+					}
+				}
+			}
+		}
+	}
+
+	harray<FormatTag> Renderer::_makeDefaultTags(const april::Color& color, chstr fontName, hstr& text)
+	{
+		harray<FormatTag> tags;
+		text = this->analyzeFormatting(text, tags);
+		FormatTag tag;
+		tag.type = FormatTag::Type::Color;
+		tag.data = color.hex();
+		tags.addFirst(tag);
+		tag.type = FormatTag::Type::Font;
+		tag.data = fontName;
+		tags.addFirst(tag);
+		return tags;
+	}
+
+	harray<FormatTag> Renderer::_makeDefaultTagsUnformatted(const april::Color& color, chstr fontName)
+	{
+		harray<FormatTag> tags;
+		FormatTag tag;
+		tag.type = FormatTag::Type::Color;
+		tag.data = color.hex();
+		tags.addFirst(tag);
+		tag.type = FormatTag::Type::Font;
+		tag.data = fontName;
+		tags.addFirst(tag);
+		return tags;
+	}
+
+	harray<FormatTag> Renderer::_makeDefaultTags(const april::Color& color, const FormattedText& formattedText)
+	{
+		harray<FormatTag> tags = formattedText.tags;
+		bool resolved = (formattedText.cacheGeneration == this->cacheGeneration);
+		if (!resolved) // fonts could have been changed in the meantime so the resolved data cannot be used anymore
+		{
+			foreach (FormatTag, it, tags)
+			{
+				(*it).resolved = false;
+			}
+		}
+		FormatTag tag;
+		tag.type = FormatTag::Type::Color;
+		tag.data = color.hex();
+		tag.color = color;
+		tag.resolved = true;
+		tags.addFirst(tag);
+		tag.type = FormatTag::Type::Font;
+		tag.data = formattedText.fontName;
+		tag.font = formattedText.font;
+		tag.resolved = (resolved && formattedText.font.font != NULL);
+		tags.addFirst(tag);
+		return tags;
+	}
+
+	float Renderer::getTextWidth(chstr fontName, chstr text)
+	{
+		float result = 0.0f;
+		if (text != "")
+		{
+			static grectf defaultRect(0.0f, 0.0f, CHECK_RECT_SIZE, CHECK_RECT_SIZE);
+			this->_lines = this->makeRenderLines(fontName, defaultRect, text);
+			foreach (RenderLine, it, this->_lines)
+			{
+				result = hmax(result, (*it).rect.w);
+			}
+		}
+		return result;
+	}
+
+	float Renderer::getTextWidth(chstr text)
+	{
+		return this->getTextWidth("", text);
+	}
+
+	float Renderer::getTextWidthUnformatted(chstr fontName, chstr text)
+	{
+		return this->getTextWidth(fontName, "[-]" + text);
+	}
+
+	float Renderer::getTextWidthUnformatted(chstr text)
+	{
+		return this->getTextWidth("", "[-]" + text);
+	}
+
+	float Renderer::getTextWidth(const FormattedText& formattedText)
+	{
+		float result = 0.0f;
+		if (formattedText.text != "")
+		{
+			static grectf defaultRect(0.0f, 0.0f, CHECK_RECT_SIZE, CHECK_RECT_SIZE);
+			this->_lines = this->makeRenderLines(formattedText, defaultRect);
+			foreach (RenderLine, it, this->_lines)
+			{
+				result = hmax(result, (*it).rect.w);
+			}
+		}
+		return result;
+	}
+
+	float Renderer::getTextAdvanceX(chstr fontName, chstr text)
+	{
+		float result = 0.0f;
+		if (text != "")
+		{
+			static grectf defaultRect(0.0f, 0.0f, CHECK_RECT_SIZE, CHECK_RECT_SIZE);
+			this->_lines = this->makeRenderLines(fontName, defaultRect, text);
+			foreach (RenderLine, it, this->_lines)
+			{
+				result = hmax(result, (*it).advanceX);
+			}
+		}
+		return result;
+	}
+
+	float Renderer::getTextAdvanceX(chstr text)
+	{
+		return this->getTextAdvanceX("", text);
+	}
+
+	float Renderer::getTextAdvanceXUnformatted(chstr fontName, chstr text)
+	{
+		return this->getTextAdvanceX(fontName, "[-]" + text);
+	}
+
+	float Renderer::getTextAdvanceXUnformatted(chstr text)
+	{
+		return this->getTextAdvanceX("", "[-]" + text);
+	}
+
+	float Renderer::getTextHeight(chstr fontName, chstr text, float maxWidth, const Horizontal& horizontal)
+	{
+		if (text != "" && maxWidth > 0.0f)
+		{
+			grectf defaultRect(0.0f, 0.0f, maxWidth, CHECK_RECT_SIZE);
+			this->_lines = this->makeRenderLines(fontName, defaultRect, text, horizontal, Vertical::Top);
+			if (this->_lines.size() > 0)
+			{
+				ResolvedFont font = this->resolveFont(fontName);
+				float lineHeight = font.getLineHeight();
+				return hmax((this->_lines.size() - 1) * lineHeight + hmax(lineHeight + font.getInternalDescender(), font.getHeight()), this->_lines.last().rect.bottom());
+			}
+		}
+		return 0.0f;
+	}
+	
+	float Renderer::getTextHeight(chstr text, float maxWidth, const Horizontal& horizontal)
+	{
+		return this->getTextHeight("", text, maxWidth, horizontal);
+	}
+
+	float Renderer::getTextHeightUnformatted(chstr fontName, chstr text, float maxWidth, const Horizontal& horizontal)
+	{
+		return this->getTextHeight(fontName, "[-]" + text, maxWidth, horizontal);
+	}
+
+	float Renderer::getTextHeightUnformatted(chstr text, float maxWidth, const Horizontal& horizontal)
+	{
+		return this->getTextHeight("", "[-]" + text, maxWidth, horizontal);
+	}
+
+	FitResult Renderer::fitText(chstr fontName, cgrectf rect, chstr text, float minScale, float maxScale, const Horizontal& horizontal, const Vertical& vertical)
+	{
+		FitResult result;
+		int minStep = hmax((int)hroundf(minScale / FIT_TEXT_SCALE_STEP), 1);
+		int maxStep = hmax((int)hroundf(maxScale / FIT_TEXT_SCALE_STEP), minStep);
+		int bestStep = minStep;
+		// an already scaled font name has to be split so the fitted scales are built from the base font name
+		hstr baseFontName = fontName;
+		float baseScale = 1.0f;
+		int position = (int)fontName.indexOf(":");
+		if (position >= 0 && !this->fonts.hasKey(fontName))
+		{
+			baseFontName = fontName(0, position);
+			++position;
+			baseScale = (float)fontName(position, fontName.size() - position);
+		}
+		if (text == "")
+		{
+			bestStep = maxStep;
+			result.fits = true;
+		}
+		else if (rect.w > 0.0f)
+		{
+			hstr unformattedText = text;
+			harray<FormatTag> tags = this->_makeDefaultTags(april::Color::White, baseFontName, unformattedText);
+			unsigned int textHash = CacheEntryBasicText::hashText(text);
+			int minIndex = minStep;
+			int maxIndex = maxStep;
+			int index = maxStep; // most texts fit without shrinking, so the largest scale is checked first
+			while (minIndex <= maxIndex)
+			{
+				if (this->_checkTextFit(this->layoutContext, baseFontName, rect, text, textHash, unformattedText, tags, horizontal, baseScale * index * FIT_TEXT_SCALE_STEP))
+				{
+					bestStep = index;
+					result.fits = true;
+					minIndex = index + 1;
+				}
+				else
+				{
+					maxIndex = index - 1;
+				}
+				index = (minIndex + maxIndex) / 2;
+			}
+		}
+		result.scale = bestStep * FIT_TEXT_SCALE_STEP;
+		result.fontName = hsprintf("%s:%g", baseFontName.cStr(), baseScale * result.scale);
+		result.lines = this->makeRenderLines(result.fontName, rect, text, horizontal, vertical);
+		return result;
+	}
+
+	bool Renderer::_checkTextFit(LayoutContext& context, chstr fontName, cgrectf rect, chstr text, unsigned int textHash, chstr unformattedText, const harray<FormatTag>& tags, const Horizontal& horizontal, float scale)
+	{
+		hstr scaledFontName = hsprintf("%s:%g", fontName.cStr(), scale);
+		ResolvedFont font = this->resolveFont(fontName);
+		ResolvedFont scaledFont = this->resolveFont(scaledFontName);
+		if (scaledFont.font == NULL)
+		{
+			return false;
+		}
+		CacheEntryWords* wordsEntry = NULL;
+		float wordsScale = 1.0f;
+		// words measured with the unscaled font are reused for every scale if the scaled font shares its metrics
+		if (scaledFont.font == font.font && !_hasFontChanges(tags))
+		{
+			wordsEntry = this->_makeRenderWords(context, this->cacheWords, text, textHash, fontName, unformattedText, tags);
+			wordsScale = scaledFont.getScale() / font.getScale();
+		}
+		else
+		{
+			wordsEntry = this->_makeRenderWords(context, this->cacheWords, text, textHash, scaledFontName, unformattedText, tags);
+		}
+		harray<RenderWord> words;
+		if (!this->_scaleRenderWords(context, *wordsEntry, wordsScale, rect.w, words))
+		{
+			return false;
+		}
+		this->_breakRenderWords(context, this->_lines, words, rect.w, horizontal);
+		if (this->_lines.size() == 0)
+		{
+			return true;
+		}
+		foreach (RenderLine, it, this->_lines)
+		{
+			if ((*it).rect.w > rect.w)
+			{
+				return false;
+			}
+		}
+		float lineHeight = context._lineHeight;
+		float height = hmax((this->_lines.size() - 1) * lineHeight + hmax(lineHeight + context._internalDescender, context._height), this->_lines.last().rect.bottom());
+		return (height <= rect.h);
+	}
+
+	hstr Renderer::getFittingText(chstr fontName, chstr text, float maxWidth)
+	{
+		if (text != "" && maxWidth > 0.0f)
+		{
+			grectf defaultRect(0.0f, 0.0f, CHECK_RECT_SIZE, CHECK_RECT_SIZE);
+			this->_lines = this->makeRenderLines(fontName, defaultRect, text, Horizontal::LeftWrapped, Vertical::Top);
+			if (this->_lines.size() > 0)
+			{
+				const RenderLine& line = this->_lines[0];
+				int byteCount = 0;
+				int index = this->_findFittingWord(line, maxWidth, 0.0f, byteCount);
+				// the line's text is made of the texts of its words
+				for_iter (i, 0, index)
+				{
+					byteCount += line.words[i].text.size();
+				}
+				return line.text(0, byteCount);
+			}
+		}
+		return "";
 	}
 
 	hstr Renderer::getFittingText(chstr text, float maxWidth)
@@ -2892,4 +4567,327 @@ namespace atres
 		return this->getFittingText("", "[-]" + text, maxWidth);
 	}
 
+	int Renderer::getFittingTextOffset(chstr fontName, chstr text, float maxWidth, chstr ellipsis)
+	{
+		bool truncated = false;
+		return this->_getFittingTextOffset(fontName, text, maxWidth, ellipsis, truncated);
+	}
+
+	int Renderer::getFittingTextOffsetUnformatted(chstr fontName, chstr text, float maxWidth, chstr ellipsis)
+	{
+		bool truncated = false;
+		return this->_getFittingTextOffset(fontName, "[-]" + text, maxWidth, ellipsis, truncated);
+	}
+
+	hstr Renderer::getTruncatedText(chstr fontName, chstr text, float maxWidth, chstr ellipsis)
+	{
+		bool truncated = false;
+		int offset = this->_getFittingTextOffset(fontName, text, maxWidth, ellipsis, truncated);
+		harray<FormatTag> tags;
+		hstr unformattedText = this->analyzeFormatting(text, tags);
+		return (truncated ? unformattedText(0, offset) + ellipsis : unformattedText(0, offset));
+	}
+
+	hstr Renderer::getTruncatedTextUnformatted(chstr fontName, chstr text, float maxWidth, chstr ellipsis)
+	{
+		bool truncated = false;
+		int offset = this->_getFittingTextOffset(fontName, "[-]" + text, maxWidth, ellipsis, truncated);
+		return (truncated ? text(0, offset) + ellipsis : text(0, offset));
+	}
+
+	int Renderer::_getFittingTextOffset(chstr fontName, chstr text, float maxWidth, chstr ellipsis, bool& truncated)
+	{
+		truncated = false;
+		if (text == "")
+		{
+			return 0;
+		}
+		// measured first, because it reuses the same lines buffer
+		float ellipsisWidth = (ellipsis != "" ? this->getTextWidthUnformatted(fontName, ellipsis) : 0.0f);
+		grectf defaultRect(0.0f, 0.0f, CHECK_RECT_SIZE, CHECK_RECT_SIZE);
+		this->_lines = this->makeRenderLines(fontName, defaultRect, text, Horizontal::Left, Vertical::Top);
+		if (this->_lines.size() == 0)
+		{
+			return 0;
+		}
+		const RenderLine& line = this->_lines[0];
+		int byteCount = 0;
+		int index = this->_findFittingWord(line, maxWidth, ellipsisWidth, byteCount);
+		if (index < line.words.size())
+		{
+			truncated = true;
+			return (line.words[index].start + byteCount);
+		}
+		if (line.words.size() == 0)
+		{
+			return line.start;
+		}
+		return _getWordEnd(line.words.last());
+	}
+
+	int Renderer::_findFittingWord(const RenderLine& line, float maxWidth, float ellipsisWidth, int& byteCount)
+	{
+		byteCount = 0;
+		int size = line.words.size();
+		// word extents grow along the line so the first word that doesn't fit can be found with a binary search
+		int minIndex = 0;
+		int maxIndex = size;
+		int index = 0;
+		while (minIndex < maxIndex)
+		{
+			index = (minIndex + maxIndex) / 2;
+			if (line.words[index].rect.right() > maxWidth)
+			{
+				maxIndex = index;
+			}
+			else
+			{
+				minIndex = index + 1;
+			}
+		}
+		if (minIndex >= size) // the whole line fits
+		{
+			return size;
+		}
+		// the ellipsis only needs space when the text doesn't fit as a whole
+		if (ellipsisWidth > 0.0f)
+		{
+			maxWidth -= ellipsisWidth;
+			maxIndex = minIndex;
+			minIndex = 0;
+			while (minIndex < maxIndex)
+			{
+				index = (minIndex + maxIndex) / 2;
+				if (line.words[index].rect.right() > maxWidth)
+				{
+					maxIndex = index;
+				}
+				else
+				{
+					minIndex = index + 1;
+				}
+			}
+		}
+		int wordIndex = minIndex;
+		const RenderWord& word = line.words[wordIndex];
+		if (word.icon || word.glyphCount == 0) // icons cannot be split
+		{
+			return wordIndex;
+		}
+		float width = (wordIndex > 0 ? line.words[wordIndex - 1].rect.right() : 0.0f);
+		// segment widths are the growing extents of the word after each character, so they work as prefix sums
+		const harray<float>& segmentWidths = line.glyphs.segmentWidths;
+		minIndex = 0;
+		maxIndex = word.glyphCount;
+		while (minIndex < maxIndex)
+		{
+			index = (minIndex + maxIndex) / 2;
+			if (width + segmentWidths[word.glyphIndex + index] > maxWidth)
+			{
+				maxIndex = index;
+			}
+			else
+			{
+				minIndex = index + 1;
+			}
+		}
+		// only the fitting characters are converted to bytes
+		const char* str = word.text.cStr();
+		for_iter (i, 0, minIndex)
+		{
+			byteCount += _utf8CharSize(str[byteCount]);
+		}
+		return wordIndex;
+	}
+
+	int Renderer::getTextIndexAt(const harray<RenderLine>& lines, cgvec2f position)
+	{
+		int size = lines.size();
+		if (size == 0)
+		{
+			return 0;
+		}
+		// finding the last line that starts above the position, lines are sorted from top to bottom
+		int minIndex = 1;
+		int maxIndex = size;
+		int index = 0;
+		while (minIndex < maxIndex)
+		{
+			index = (minIndex + maxIndex) / 2;
+			if (lines[index].rect.y > position.y)
+			{
+				maxIndex = index;
+			}
+			else
+			{
+				minIndex = index + 1;
+			}
+		}
+		const RenderLine& line = lines[minIndex - 1];
+		size = line.words.size();
+		if (size == 0)
+		{
+			return line.start;
+		}
+		// finding the last word that starts left of the position
+		minIndex = 1;
+		maxIndex = size;
+		while (minIndex < maxIndex)
+		{
+			index = (minIndex + maxIndex) / 2;
+			if (line.words[index].rect.x > position.x)
+			{
+				maxIndex = index;
+			}
+			else
+			{
+				minIndex = index + 1;
+			}
+		}
+		const RenderWord& word = line.words[minIndex - 1];
+		if (word.glyphCount == 0)
+		{
+			return word.start;
+		}
+		// counting the characters whose center is left of the position
+		const harray<float>& charXs = line.glyphs.charXs;
+		const harray<float>& charAdvanceXs = line.glyphs.charAdvanceXs;
+		float x = position.x - word.rect.x;
+		float left = 0.0f;
+		minIndex = 0;
+		maxIndex = word.glyphCount;
+		while (minIndex < maxIndex)
+		{
+			index = (minIndex + maxIndex) / 2;
+			left = (index > 0 ? charXs[word.glyphIndex + index - 1] + charAdvanceXs[word.glyphIndex + index - 1] : 0.0f);
+			if ((left + charXs[word.glyphIndex + index] + charAdvanceXs[word.glyphIndex + index]) * 0.5f > x)
+			{
+				maxIndex = index;
+			}
+			else
+			{
+				minIndex = index + 1;
+			}
+		}
+		if (minIndex >= word.glyphCount)
+		{
+			return _getWordEnd(word);
+		}
+		// only the characters in front of the position are converted to bytes
+		const char* str = word.text.cStr();
+		int byteCount = 0;
+		for_iter (i, 0, minIndex)
+		{
+			byteCount += _utf8CharSize(str[byteCount]);
+		}
+		return (word.start + byteCount);
+	}
+
+	grectf Renderer::getCaretRect(const harray<RenderLine>& lines, int index)
+	{
+		if (lines.size() == 0)
+		{
+			return grectf();
+		}
+		const RenderLine& line = lines[this->_findLineIndex(lines, index)];
+		return grectf(this->_getCaretX(line, index), line.rect.y, 0.0f, line.rect.h);
+	}
+
+	harray<grectf> Renderer::getSelectionRects(const harray<RenderLine>& lines, int start, int end)
+	{
+		harray<grectf> result;
+		if (lines.size() == 0 || start >= end)
+		{
+			return result;
+		}
+		int startLine = this->_findLineIndex(lines, start);
+		int endLine = this->_findLineIndex(lines, end);
+		float left = 0.0f;
+		float right = 0.0f;
+		for_iter (i, startLine, endLine + 1)
+		{
+			const RenderLine& line = lines[i];
+			left = (i == startLine ? this->_getCaretX(line, start) : line.rect.x);
+			right = (i == endLine ? this->_getCaretX(line, end) : line.rect.right());
+			if (right > left)
+			{
+				result += grectf(left, line.rect.y, right - left, line.rect.h);
+			}
+		}
+		return result;
+	}
+
+	int Renderer::_findLineIndex(const harray<RenderLine>& lines, int index)
+	{
+		// finding the last line that starts before the index, lines are sorted by their position in the text
+		int minIndex = 1;
+		int maxIndex = lines.size();
+		int current = 0;
+		while (minIndex < maxIndex)
+		{
+			current = (minIndex + maxIndex) / 2;
+			if (lines[current].start > index)
+			{
+				maxIndex = current;
+			}
+			else
+			{
+				minIndex = current + 1;
+			}
+		}
+		return (minIndex - 1);
+	}
+
+	float Renderer::_getCaretX(const RenderLine& line, int index)
+	{
+		int size = line.words.size();
+		if (size == 0 || index <= line.words.first().start)
+		{
+			return line.rect.x;
+		}
+		// finding the last word that starts before the index
+		int minIndex = 1;
+		int maxIndex = size;
+		int current = 0;
+		while (minIndex < maxIndex)
+		{
+			current = (minIndex + maxIndex) / 2;
+			if (line.words[current].start > index)
+			{
+				maxIndex = current;
+			}
+			else
+			{
+				minIndex = current + 1;
+			}
+		}
+		const RenderWord& word = line.words[minIndex - 1];
+		if (word.glyphCount == 0)
+		{
+			return word.rect.x;
+		}
+		int charCount = word.glyphCount;
+		if (index < _getWordEnd(word))
+		{
+			charCount = 0;
+			if (!word.icon)
+			{
+				// only the bytes in front of the index are converted to characters
+				const char* str = word.text.cStr();
+				int byteCount = 0;
+				while (byteCount < index - word.start && charCount < word.glyphCount)
+				{
+					byteCount += _utf8CharSize(str[byteCount]);
+					++charCount;
+				}
+			}
+		}
+		if (charCount == 0)
+		{
+			return word.rect.x;
+		}
+		int glyphIndex = word.glyphIndex + charCount - 1;
+		return (word.rect.x + line.glyphs.charXs[glyphIndex] + line.glyphs.charAdvanceXs[glyphIndex]);
+	}
+
 }
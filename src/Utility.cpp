@@ -11,6 +11,7 @@
 #include <hltypes/hlog.h>
 #include <hltypes/hstring.h>
 
+#include "Font.h"
 #include "Utility.h"
 
 namespace atres
@@ -136,7 +137,7 @@ namespace atres
 	{
 	}
 
-	void RenderSequence::addRenderRectangle(const RenderRectangle& rect, const april::Color& color, float italicSkewOffset)
+	void RenderSequence::addRenderRectangle(const RenderRectangle& rect, const april::Color& color, float italicSkewOffset, int glyph)
 	{
 		_ctVertices[0].x = _ctVertices[2].x = _ctVertices[4].x = rect.dest.left();
 		_ctVertices[1].x = _ctVertices[3].x = _ctVertices[5].x = rect.dest.right();
@@ -153,11 +154,12 @@ namespace atres
 			_ctVertices[3].x += italicSkewOffset;
 		}
 		this->vertices.add(_ctVertices, 6);
+		this->glyphs += glyph;
 		this->colors.add(color, 6);
 	}
 
 	void RenderSequence::addRenderRectangle(const RenderRectangle& rect, const april::Color& colorTopLeft, const april::Color& colorTopRight,
-		const april::Color& colorBottomLeft, const april::Color& colorBottomRight, float italicSkewOffset)
+		const april::Color& colorBottomLeft, const april::Color& colorBottomRight, float italicSkewOffset, int glyph)
 	{
 		_ctVertices[0].x = _ctVertices[2].x = _ctVertices[4].x = rect.dest.left();
 		_ctVertices[1].x = _ctVertices[3].x = _ctVertices[5].x = rect.dest.right();
@@ -174,6 +176,7 @@ namespace atres
 			_ctVertices[3].x += italicSkewOffset;
 		}
 		this->vertices.add(_ctVertices, 6);
+		this->glyphs += glyph;
 		this->colors += colorTopLeft;
 		this->colors += colorTopRight;
 		this->colors += colorBottomLeft;
@@ -182,29 +185,63 @@ namespace atres
 		this->colors += colorBottomRight;
 	}
 
-	void RenderSequence::mergeFrom(const RenderSequence& other)
+	int RenderSequence::getRevealedVertexCount(int glyphCount) const
+	{
+		// glyphs are always sorted in layout order
+		int minIndex = 0;
+		int maxIndex = this->glyphs.size();
+		int index = 0;
+		while (minIndex < maxIndex)
+		{
+			index = (minIndex + maxIndex) / 2;
+			if (this->glyphs[index] < glyphCount)
+			{
+				minIndex = index + 1;
+			}
+			else
+			{
+				maxIndex = index;
+			}
+		}
+		return (minIndex * 6);
+	}
+
+	void RenderSequence::mergeFrom(const RenderSequence& other, int glyphOffset)
 	{
 		this->vertices += other.vertices;
 		this->colors += other.colors;
+		if (glyphOffset == 0)
+		{
+			this->glyphs += other.glyphs;
+		}
+		else
+		{
+			foreachc (int, it, other.glyphs)
+			{
+				this->glyphs += (*it) + glyphOffset;
+			}
+		}
 	}
 	
 	void RenderSequence::clear()
 	{
 		this->vertices.clear();
 		this->colors.clear();
+		this->glyphs.clear();
 	}
 
 	RenderLiningSequence::RenderLiningSequence()
 	{
 	}
 
-	void RenderLiningSequence::addRectangle(cgrectf rect)
+	void RenderLiningSequence::addRectangle(cgrectf rect, int glyph)
 	{
 		_top = rect.top();
 		_bottom = rect.bottom();
 		if (this->vertices.size() > 0 && this->vertices[this->vertices.size() - 1].y == _bottom && this->vertices[this->vertices.size() - 3].y == _top)
 		{
 			this->vertices[this->vertices.size() - 1].x = this->vertices[this->vertices.size() - 3].x = this->vertices[this->vertices.size() - 5].x = rect.right();
+			this->lastGlyphs[this->lastGlyphs.size() - 1] = glyph;
 		}
 		else
 		{
@@ -213,17 +250,104 @@ namespace atres
 			_pVertices[0].y = _pVertices[1].y = _pVertices[3].y = _top;
 			_pVertices[2].y = _pVertices[4].y = _pVertices[5].y = _bottom;
 			this->vertices.add(_pVertices, 6);
+			this->glyphs += glyph;
+			this->lastGlyphs += glyph;
 		}
 	}
 
-	void RenderLiningSequence::mergeFrom(const RenderLiningSequence& other)
+	int RenderLiningSequence::getRevealedVertexCount(int glyphCount) const
+	{
+		// glyphs are always sorted in layout order
+		int minIndex = 0;
+		int maxIndex = this->glyphs.size();
+		int index = 0;
+		while (minIndex < maxIndex)
+		{
+			index = (minIndex + maxIndex) / 2;
+			if (this->glyphs[index] < glyphCount)
+			{
+				minIndex = index + 1;
+			}
+			else
+			{
+				maxIndex = index;
+			}
+		}
+		return (minIndex * 6);
+	}
+
+	void RenderLiningSequence::mergeFrom(const RenderLiningSequence& other, int glyphOffset)
 	{
 		this->vertices += other.vertices;
+		if (glyphOffset == 0)
+		{
+			this->glyphs += other.glyphs;
+			this->lastGlyphs += other.lastGlyphs;
+		}
+		else
+		{
+			foreachc (int, it, other.glyphs)
+			{
+				this->glyphs += (*it) + glyphOffset;
+			}
+			foreachc (int, it, other.lastGlyphs)
+			{
+				this->lastGlyphs += (*it) + glyphOffset;
+			}
+		}
 	}
 
 	void RenderLiningSequence::clear()
 	{
 		this->vertices.clear();
+		this->glyphs.clear();
+		this->lastGlyphs.clear();
+	}
+
+	GlyphRun::GlyphRun()
+	{
+	}
+
+	void GlyphRun::add(float charX, float charAdvanceX, float segmentWidth)
+	{
+		this->charXs += charX;
+		this->charAdvanceXs += charAdvanceX;
+		this->segmentWidths += segmentWidth;
+	}
+
+	void GlyphRun::addFrom(const GlyphRun& other, int start, int count)
+	{
+		for_iter (i, start, start + count)
+		{
+			this->charXs += other.charXs[i];
+			this->charAdvanceXs += other.charAdvanceXs[i];
+			this->segmentWidths += other.segmentWidths[i];
+		}
+	}
+
+	void GlyphRun::scale(float factor)
+	{
+		int size = this->charXs.size();
+		for_iter (i, 0, size)
+		{
+			this->charXs[i] *= factor;
+			this->charAdvanceXs[i] *= factor;
+			this->segmentWidths[i] *= factor;
+		}
+	}
+
+	void GlyphRun::clear()
+	{
+		this->charXs.clear();
+		this->charAdvanceXs.clear();
+		this->segmentWidths.clear();
+	}
+
+	void GlyphRun::swap(GlyphRun& other)
+	{
+		this->charXs.swap(other.charXs);
+		this->charAdvanceXs.swap(other.charAdvanceXs);
+		this->segmentWidths.swap(other.segmentWidths);
 	}
 
 	RenderWord::RenderWord() :
@@ -232,7 +356,9 @@ namespace atres
 		spaces(0),
 		icon(false),
 		advanceX(0.0f),
-		bearingX(0.0f)
+		bearingX(0.0f),
+		glyphIndex(0),
+		glyphCount(0)
 	{
 	}
 
@@ -245,7 +371,8 @@ namespace atres
 	{
 	}
 	
-	RenderText::RenderText()
+	RenderText::RenderText() :
+		glyphCount(0)
 	{
 	}
 
@@ -271,7 +398,356 @@ namespace atres
 	FormatTag::FormatTag() :
 		type(Type::Escape),
 		start(0),
-		count(0)
+		count(0),
+		resolved(false)
+	{
+	}
+
+	ResolvedFont::ResolvedFont() :
+		font(NULL),
+		scale(1.0f)
+	{
+	}
+
+	ResolvedFont::ResolvedFont(Font* font, float scale) :
+		font(font),
+		scale(scale)
+	{
+	}
+
+	float ResolvedFont::getScale() const
+	{
+		return this->font->getScale(this->scale);
+	}
+
+	float ResolvedFont::getHeight() const
+	{
+		return this->font->getHeight(this->scale);
+	}
+
+	float ResolvedFont::getLineHeight() const
+	{
+		return this->font->getLineHeight(this->scale);
+	}
+
+	float ResolvedFont::getDescender() const
+	{
+		return this->font->getDescender(this->scale);
+	}
+
+	float ResolvedFont::getInternalDescender() const
+	{
+		return this->font->getInternalDescender(this->scale);
+	}
+
+	float ResolvedFont::getStrikeThroughOffset() const
+	{
+		return this->font->getStrikeThroughOffset(this->scale);
+	}
+
+	float ResolvedFont::getUnderlineOffset() const
+	{
+		return this->font->getUnderlineOffset(this->scale);
+	}
+
+	FormattedText::FormattedText() :
+		textHash(0),
+		textId(0),
+		cacheGeneration(0)
+	{
+	}
+
+	TextObject::TextObject() :
+		horizontal(Horizontal::Left),
+		vertical(Vertical::Center),
+		color(april::Color::White),
+		valid(false),
+		cacheGeneration(0)
+	{
+	}
+
+	TextObject::TextObject(chstr fontName, cgrectf rect, chstr text, const Horizontal& horizontal, const Vertical& vertical, const april::Color& color, cgvec2f offset) :
+		fontName(fontName),
+		text(text),
+		rect(rect),
+		horizontal(horizontal),
+		vertical(vertical),
+		color(color),
+		offset(offset),
+		valid(false),
+		cacheGeneration(0)
+	{
+	}
+
+	void TextObject::setFontName(chstr value)
+	{
+		if (this->fontName != value)
+		{
+			this->fontName = value;
+			this->valid = false;
+		}
+	}
+
+	void TextObject::setText(chstr value)
+	{
+		if (this->text != value)
+		{
+			this->text = value;
+			this->valid = false;
+		}
+	}
+
+	void TextObject::setRect(cgrectf value)
+	{
+		if (this->rect != value)
+		{
+			this->rect = value;
+			this->valid = false;
+		}
+	}
+
+	void TextObject::setHorizontal(const Horizontal& value)
+	{
+		if (this->horizontal != value)
+		{
+			this->horizontal = value;
+			this->valid = false;
+		}
+	}
+
+	void TextObject::setVertical(const Vertical& value)
+	{
+		if (this->vertical != value)
+		{
+			this->vertical = value;
+			this->valid = false;
+		}
+	}
+
+	void TextObject::setColor(const april::Color& value)
+	{
+		if (this->color.r != value.r || this->color.g != value.g || this->color.b != value.b)
+		{
+			this->valid = false;
+		}
+		this->color = value;
+	}
+
+	void TextObject::setOffset(cgvec2f value)
+	{
+		if (this->offset != value)
+		{
+			this->offset = value;
+			this->valid = false;
+		}
+	}
+
+	void TextObject::invalidate()
+	{
+		this->valid = false;
+	}
+
+	AppendableText::AppendableText() :
+		horizontal(Horizontal::LeftWrapped),
+		vertical(Vertical::Bottom),
+		color(april::Color::White),
+		height(0.0f),
+		laidOutCount(0),
+		valid(true),
+		cacheGeneration(0)
+	{
+	}
+
+	AppendableText::AppendableText(chstr fontName, cgrectf rect, const Horizontal& horizontal, const Vertical& vertical, const april::Color& color) :
+		fontName(fontName),
+		rect(rect),
+		horizontal(horizontal),
+		vertical(vertical),
+		color(color),
+		height(0.0f),
+		laidOutCount(0),
+		valid(true),
+		cacheGeneration(0)
+	{
+	}
+
+	void AppendableText::setFontName(chstr value)
+	{
+		if (this->fontName != value)
+		{
+			this->fontName = value;
+			this->valid = false;
+		}
+	}
+
+	void AppendableText::setRect(cgrectf value)
+	{
+		if (this->rect.w != value.w)
+		{
+			this->valid = false;
+		}
+		this->rect = value;
+	}
+
+	void AppendableText::setHorizontal(const Horizontal& value)
+	{
+		if (this->horizontal != value)
+		{
+			this->horizontal = value;
+			this->valid = false;
+		}
+	}
+
+	void AppendableText::setColor(const april::Color& value)
+	{
+		if (this->color.r != value.r || this->color.g != value.g || this->color.b != value.b)
+		{
+			this->valid = false;
+		}
+		this->color = value;
+	}
+
+	void AppendableText::clear()
+	{
+		this->texts.clear();
+		this->lines.clear();
+		this->renderText = RenderText();
+		this->lineGlyphs.clear();
+		this->height = 0.0f;
+		this->offset.set(0.0f, 0.0f);
+		this->laidOutCount = 0;
+		this->valid = true;
+	}
+
+	void AppendableText::invalidate()
+	{
+		this->valid = false;
+	}
+
+	VirtualizedLine::VirtualizedLine() :
+		start(0),
+		y(0.0f),
+		height(0.0f)
+	{
+	}
+
+	VirtualizedText::VirtualizedText() :
+		horizontal(Horizontal::LeftWrapped),
+		color(april::Color::White),
+		scrollOffset(0.0f),
+		height(0.0f),
+		firstLine(0),
+		lastLine(0),
+		valid(false),
+		renderValid(false),
+		cacheGeneration(0)
+	{
+	}
+
+	VirtualizedText::VirtualizedText(chstr fontName, chstr text, cgrectf rect, const Horizontal& horizontal, const april::Color& color) :
+		fontName(fontName),
+		text(text),
+		rect(rect),
+		horizontal(horizontal),
+		color(color),
+		scrollOffset(0.0f),
+		height(0.0f),
+		firstLine(0),
+		lastLine(0),
+		valid(false),
+		renderValid(false),
+		cacheGeneration(0)
+	{
+	}
+
+	void VirtualizedText::setFontName(chstr value)
+	{
+		if (this->fontName != value)
+		{
+			this->fontName = value;
+			this->valid = false;
+		}
+	}
+
+	void VirtualizedText::setText(chstr value)
+	{
+		if (this->text != value)
+		{
+			this->text = value;
+			this->valid = false;
+		}
+	}
+
+	void VirtualizedText::setRect(cgrectf value)
+	{
+		if (this->rect.w != value.w)
+		{
+			this->valid = false;
+		}
+		else if (this->rect != value)
+		{
+			this->renderValid = false;
+		}
+		this->rect = value;
+	}
+
+	void VirtualizedText::setHorizontal(const Horizontal& value)
+	{
+		if (this->horizontal != value)
+		{
+			this->horizontal = value;
+			this->valid = false;
+		}
+	}
+
+	void VirtualizedText::setColor(const april::Color& value)
+	{
+		if (this->color.r != value.r || this->color.g != value.g || this->color.b != value.b)
+		{
+			this->valid = false;
+		}
+		this->color = value;
+	}
+
+	void VirtualizedText::setScrollOffset(float value)
+	{
+		if (this->scrollOffset != value)
+		{
+			this->scrollOffset = value;
+			this->renderValid = false;
+		}
+	}
+
+	void VirtualizedText::invalidate()
+	{
+		this->valid = false;
+	}
+
+	LayoutRequest::LayoutRequest() :
+		horizontal(Horizontal::Left),
+		vertical(Vertical::Center)
+	{
+	}
+
+	LayoutRequest::LayoutRequest(chstr fontName, cgrectf rect, chstr text, const Horizontal& horizontal, const Vertical& vertical, cgvec2f offset) :
+		fontName(fontName),
+		rect(rect),
+		text(text),
+		horizontal(horizontal),
+		vertical(vertical),
+		offset(offset)
+	{
+	}
+
+	LayoutResult::LayoutResult() :
+		width(0.0f),
+		height(0.0f)
+	{
+	}
+
+	FitResult::FitResult() :
+		scale(1.0f),
+		fits(false)
 	{
 	}
 
@@ -308,6 +784,8 @@ namespace atres
 	}
 
 	CacheEntryBasicText::CacheEntryBasicText() :
+		textHash(0),
+		textId(0),
 		horizontal(Horizontal::CenterWrapped),
 		vertical(Vertical::Center),
 		useMoreColors(false),
@@ -321,8 +799,15 @@ namespace atres
 	}
 
 	void CacheEntryBasicText::set(chstr text, chstr fontName, cgrectf rect, Horizontal horizontal, Vertical vertical, const april::Color& color, cgvec2f offset)
+	{
+		this->set(text, CacheEntryBasicText::hashText(text), fontName, rect, horizontal, vertical, color, offset);
+	}
+
+	void CacheEntryBasicText::set(chstr text, unsigned int textHash, chstr fontName, cgrectf rect, Horizontal horizontal, Vertical vertical, const april::Color& color, cgvec2f offset)
 	{
 		this->text = text;
+		this->textHash = textHash;
+		this->textId = 0;
 		this->fontName = fontName;
 		this->rect = rect;
 		this->horizontal = horizontal;
@@ -343,6 +828,8 @@ namespace atres
 		const april::Color& colorTopRight, const april::Color& colorBottomLeft, const april::Color& colorBottomRight, bool horizontalColorFit, bool verticalColorFit, cgvec2f offset)
 	{
 		this->text = text;
+		this->textHash = CacheEntryBasicText::hashText(text);
+		this->textId = 0;
 		this->fontName = fontName;
 		this->rect = rect;
 		this->horizontal = horizontal;
@@ -359,9 +846,17 @@ namespace atres
 		this->offset = offset;
 	}
 
+	void CacheEntryBasicText::set(const FormattedText& formattedText, cgrectf rect, Horizontal horizontal, Vertical vertical, const april::Color& color, cgvec2f offset)
+	{
+		this->set(formattedText.getText(), formattedText.getTextHash(), formattedText.getFontName(), rect, horizontal, vertical, color, offset);
+		this->textId = formattedText.getTextId();
+	}
+
 	bool CacheEntryBasicText::isEqual(const CacheEntryBasicText& other) const
 	{
-		if (this->text == other.text &&
+		// the same formatted text object guarantees the same text so the potentially long text doesn't have to be compared
+		if (this->textHash == other.textHash &&
+			((this->textId != 0 && this->textId == other.textId) || this->text == other.text) &&
 			this->fontName == other.fontName &&
 			this->rect == other.rect &&
 			this->horizontal == other.horizontal &&
@@ -395,11 +890,7 @@ namespace atres
 
 	unsigned int CacheEntryBasicText::hash() const
 	{
-		unsigned int result = 0;
-		for_iter (i, 0, this->text.size())
-		{
-			result ^= this->text[i] << ((i % 4) * 8);
-		}
+		unsigned int result = this->textHash;
 		for_iter (i, 0, this->fontName.size())
 		{
 			result ^= this->fontName[i] << ((i % 4) * 8);
@@ -436,6 +927,17 @@ namespace atres
 		return result;
 	}
 
+	unsigned int CacheEntryBasicText::hashText(chstr text)
+	{
+		unsigned int result = 0;
+		int size = text.size();
+		for_iter (i, 0, size)
+		{
+			result ^= text[i] << ((i % 4) * 8);
+		}
+		return result;
+	}
+
 	CacheEntryText::CacheEntryText() :
 		CacheEntryBasicText()
 	{
@@ -446,6 +948,23 @@ namespace atres
 	{
 	}
 
+	CacheEntryLineBreaks::CacheEntryLineBreaks() :
+		CacheEntryBasicText(),
+		lineHeight(0.0f),
+		descender(0.0f),
+		internalDescender(0.0f)
+	{
+	}
+
+	CacheEntryWords::CacheEntryWords() :
+		CacheEntryBasicText(),
+		height(0.0f),
+		lineHeight(0.0f),
+		descender(0.0f),
+		internalDescender(0.0f)
+	{
+	}
+
 	CacheEntryLine::CacheEntryLine()
 	{
 	}